@@ -0,0 +1,57 @@
+package com.quickjs;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNull;
+
+public class ArrayBufferTest extends BaseTest {
+    private JSContext context;
+    private QuickJS quickJS;
+
+    @Before
+    public void setUp() {
+        quickJS = createQuickJS();
+        context = quickJS.createContext();
+    }
+
+    @After
+    public void tearDown() {
+        context.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void newArrayBufferSharesMemory() {
+        ByteBuffer buffer = ByteBuffer.allocateDirect(4);
+        JSObject arrayBuffer = context.newArrayBuffer(buffer);
+        JSFunction fill = (JSFunction) context.executeScript("(function (b) { new Uint8Array(b).fill(7); return b.byteLength; })", "file.js");
+        assertEquals(4, fill.call((JSObject) null, arrayBuffer));
+        assertEquals(7, buffer.get(3));
+    }
+
+    @Test
+    public void newTypedArray() {
+        ByteBuffer buffer = ByteBuffer.allocateDirect(8).order(ByteOrder.nativeOrder());
+        buffer.putFloat(0, 1.5f).putFloat(4, 2.5f);
+        JSObject array = context.newTypedArray(JSValue.TYPE_FLOAT_32_ARRAY, buffer);
+        JSFunction sum = (JSFunction) context.executeScript("(function (a) { return a[0] + a[1]; })", "file.js");
+        assertEquals(4.0, (Double) sum.call((JSObject) null, array), 0);
+    }
+
+    @Test
+    public void toByteBuffer() {
+        JSObject array = (JSObject) context.executeScript("var a = new Int32Array(4); a[1] = 42; a.subarray(1)", "file.js");
+        ByteBuffer buffer = array.toByteBuffer();
+        assertEquals(12, buffer.capacity());
+        assertEquals(42, buffer.getInt(0));
+        buffer.putInt(4, 7);
+        assertEquals(7, context.executeScript("a[2]", "file.js"));
+        assertNull(new JSObject(context).toByteBuffer());
+    }
+}
@@ -0,0 +1,105 @@
+package com.quickjs;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.io.File;
+import java.io.RandomAccessFile;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertTrue;
+
+public class BytecodeCacheTest extends BaseTest {
+    private static final String SOURCE = "function fib(n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); } fib(15)";
+
+    private File dir;
+    private QuickJS quickJS;
+    private JSContext context;
+
+    @Before
+    public void setUp() {
+        dir = new File(System.getProperty("java.io.tmpdir"), "quickjs-bytecode-test");
+        QuickJS.enableBytecodeCache(dir);
+        QuickJS.clearBytecodeCache();
+        quickJS = QuickJS.Companion.createRuntimeWithEventQueue();
+        context = quickJS.createContext();
+    }
+
+    @After
+    public void tearDown() {
+        context.close();
+        quickJS.close();
+        QuickJS.clearBytecodeCache();
+        QuickJS.disableBytecodeCache();
+    }
+
+    @Test
+    public void cacheHit() {
+        assertEquals(610, context.executeScript(SOURCE, "fib.js"));
+        File entry = cacheFiles()[0];
+        // 命中时只读取缓存；重新编译会经临时文件 rename 成新文件，修改时间随之变为当前时间
+        long stamp = 1_000_000_000_000L;
+        assertTrue(entry.setLastModified(stamp));
+        assertEquals(610, context.executeScript(SOURCE, "fib.js"));
+        assertEquals(1, cacheFiles().length);
+        assertEquals(stamp, entry.lastModified());
+    }
+
+    @Test
+    public void corruptedEntryIsRebuilt() throws Exception {
+        context.executeScript(SOURCE, "fib.js");
+        File entry = cacheFiles()[0];
+        try (RandomAccessFile file = new RandomAccessFile(entry, "rw")) {
+            file.seek(file.length() - 1);
+            file.write(0x7f);
+        }
+        assertEquals(610, context.executeScript(SOURCE, "fib.js"));
+        assertEquals(1, cacheFiles().length);
+    }
+
+    @Test
+    public void module() {
+        context.executeModuleScript("globalThis.answer = 6 * 7;", "answer.mjs");
+        context.executeModuleScript("globalThis.answer = 6 * 7;", "answer2.mjs");
+        assertEquals(42, context.executeScript("answer", "read.js"));
+        assertEquals(2, cacheFiles().length);
+    }
+
+    @Test
+    public void moduleCacheHit() {
+        String main = "import { value } from './dep.js'; globalThis.result = value * 2;";
+        newModuleContext().executeModuleScript(main, "main.mjs");
+        File[] entries = cacheFiles();
+        // 入口模块与经模块加载器编译的依赖各一个缓存
+        assertEquals(2, entries.length);
+        long stamp = 1_000_000_000_000L;
+        for (File entry : entries) {
+            assertTrue(entry.setLastModified(stamp));
+        }
+        // 新上下文中没有已加载的模块，入口与依赖都要经过缓存命中、JS_ResolveModule 与模块加载器
+        ES6Module second = newModuleContext();
+        second.executeModuleScript(main, "main.mjs");
+        assertEquals(42, second.executeScript("result", "read.js"));
+        assertEquals(2, cacheFiles().length);
+        for (File entry : entries) {
+            assertEquals(stamp, entry.lastModified());
+        }
+    }
+
+    private ES6Module newModuleContext() {
+        return new ES6Module(quickJS) {
+            @Override
+            public String getModuleScript(String moduleName) {
+                return moduleName.endsWith("dep.js") ? "export const value = 21;" : null;
+            }
+        };
+    }
+
+    private File[] cacheFiles() {
+        File[] files = dir.listFiles((d, name) -> name.endsWith(".qjbc"));
+        assertNotNull(files);
+        return files;
+    }
+}
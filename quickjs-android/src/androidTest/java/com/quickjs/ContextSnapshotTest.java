@@ -0,0 +1,60 @@
+package com.quickjs;
+
+import com.quickjs.plugin.ConsolePlugin;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotEquals;
+
+public class ContextSnapshotTest extends BaseTest {
+    private QuickJS quickJS;
+    private ContextSnapshot snapshot;
+
+    @Before
+    public void setUp() {
+        quickJS = QuickJS.Companion.createRuntimeWithEventQueue();
+        snapshot = new ContextSnapshot.Builder(quickJS)
+                .addPlugin(ConsolePlugin::new)
+                .registerJavaMethod("nativeAdd", (receiver, args) -> (Integer) args[0] + (Integer) args[1])
+                .addScript("var counter = 0; function next() { return ++counter; }", "preload.js")
+                .prewarm(2)
+                .build();
+    }
+
+    @After
+    public void tearDown() {
+        snapshot.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void newContextIsInitialised() {
+        JSContext context = snapshot.newContext();
+        assertEquals(1, context.executeScript("next()", "test.js"));
+        assertEquals(5, context.executeScript("nativeAdd(2, 3)", "test.js"));
+        assertEquals("object", context.executeScript("typeof console", "test.js"));
+        context.close();
+    }
+
+    @Test
+    public void contextsAreIsolated() {
+        JSContext first = snapshot.newContext();
+        JSContext second = snapshot.newContext();
+        assertNotEquals(first.getContextPtr(), second.getContextPtr());
+        first.executeScript("next(); next();", "test.js");
+        assertEquals(1, second.executeScript("next()", "test.js"));
+        first.close();
+        second.close();
+    }
+
+    @Test
+    public void bytecodeRoundTrip() {
+        JSContext context = quickJS.createContext();
+        byte[] bytecode = context.compileScript("6 * 7", "answer.js");
+        assertEquals(42, context.executeBytecode(bytecode));
+        context.close();
+    }
+}
@@ -4,7 +4,13 @@ import org.junit.After;
 import org.junit.Before;
 import org.junit.Test;
 
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.Collections;
+
+import static org.junit.Assert.assertArrayEquals;
 import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNull;
 import static org.junit.Assert.assertTrue;
 
 public class JSContextTest  extends BaseTest{
@@ -111,4 +117,108 @@ public class JSContextTest  extends BaseTest{
             assertEquals(QuickJSException.class, e.getClass());
         }
     }
-}
\ No newline at end of file
+
+    @Test
+    public void executeScriptAsync() throws Exception {
+        QuickJSFuture<Object> first = context.executeScriptAsync("var counter = 1; counter", "file.js");
+        QuickJSFuture<Object> second = context.executeScriptAsync("counter + 1", "file.js");
+        assertEquals(1, first.get());
+        assertEquals(2, second.get());
+    }
+
+    @Test
+    public void executeScriptAsyncError() throws Exception {
+        QuickJSFuture<Object> future = context.executeScriptAsync("throw new Error('boom')", "file.js");
+        try {
+            future.get();
+            throw new Exception();
+        } catch (java.util.concurrent.ExecutionException e) {
+            assertEquals(QuickJSException.class, e.getCause().getClass());
+        }
+    }
+
+    @Test
+    public void supplementaryCharacters() {
+        String text = "emoji \uD83D\uDE00 中文 é";
+        JSFunction identity = (JSFunction) context.executeScript("(function (s) { return s; })", "file.js");
+        assertEquals(text, identity.call((JSObject) null, text));
+        assertEquals(2, context.executeScript("'\\uD83D\\uDE00'.length", "file.js"));
+        JSFunction length = (JSFunction) context.executeScript("(function (s) { return s.length; })", "file.js");
+        assertEquals(text.length(), length.call((JSObject) null, text));
+    }
+
+    @Test
+    public void leakReport() {
+        JSContext strictContext = quickJS.createContext();
+        strictContext.setStrict(true);
+        int baseline = strictContext.getHandleCount();
+        JSObject leaked = (JSObject) strictContext.executeScript("({a: 1})", "file.js");
+        strictContext.executeScript("'primitive results are not tracked'", "file.js");
+        Object undefined = strictContext.executeScript("undefined", "file.js");
+        assertTrue(undefined instanceof JSObject.Undefined);
+        assertEquals(baseline + 1, strictContext.getHandleCount());
+        assertEquals(Collections.singletonList("executeScript JSObject x1"), strictContext.dumpLeaks());
+        try {
+            strictContext.close();
+            throw new AssertionError("strict close should report the leak");
+        } catch (IllegalStateException e) {
+            assertTrue(e.getMessage().contains("executeScript JSObject x1"));
+        }
+        assertTrue(leaked.released);
+        assertTrue(strictContext.isReleased());
+    }
+
+    @Test
+    public void jsonBytes() {
+        String json = "{\"name\":\"\uD83D\uDE00 中文\",\"list\":[1,2.5,true,null]}";
+        byte[] utf8 = json.getBytes(StandardCharsets.UTF_8);
+
+        JSObject fromString = (JSObject) context.parseJSON(json);
+        assertEquals("\uD83D\uDE00 中文", fromString.getString("name"));
+        JSObject fromBytes = (JSObject) context.parseJSONBytes(utf8);
+        assertEquals(2.5, fromBytes.getArray("list").getDouble(1), 0);
+        assertEquals(42, context.parseJSONBytes("[42]".getBytes(StandardCharsets.UTF_8), 1, 2));
+
+        ByteBuffer buffer = ByteBuffer.allocateDirect(utf8.length + 1);
+        buffer.put(utf8).put((byte) 0).flip();
+        buffer.limit(utf8.length);
+        JSObject fromBuffer = (JSObject) context.parseJSONBytes(buffer);
+        assertEquals(json, context.stringify(fromBuffer));
+
+        assertArrayEquals(utf8, context.stringifyToBytes(fromBytes));
+        ByteBuffer out = context.stringifyToBuffer(fromString);
+        byte[] outBytes = new byte[out.remaining()];
+        out.get(outBytes);
+        assertArrayEquals(utf8, outBytes);
+        assertEquals("{\n  \"a\": 1\n}", context.stringify((JSObject) context.parseJSON("{\"a\":1}"), 2));
+        assertNull(context.stringify((JSValue) context.executeScript("(function () {})", "file.js")));
+
+        try {
+            context.parseJSONBytes("{\"a\":".getBytes(StandardCharsets.UTF_8));
+            throw new AssertionError("truncated JSON should fail");
+        } catch (QuickJSException ignored) {
+        }
+    }
+
+    @Test
+    public void executionLimits() {
+        quickJS.setExecutionLimits(50);
+        try {
+            context.executeScript("try { while (true) {} } catch (e) {}", "file.js");
+            throw new AssertionError("runaway script should time out");
+        } catch (QuickJSTimeoutException e) {
+            assertTrue(e.getMessage().contains("deadline exceeded"));
+        }
+        assertEquals(2, context.executeScript("1 + 1", "file.js"));
+        quickJS.setExecutionLimits(0);
+
+        JSFunction spin = (JSFunction) context.executeScript("(function () { for (;;) {} })", "file.js");
+        try {
+            quickJS.withExecutionLimits(0, 100_000, () -> spin.call((JSObject) null));
+            throw new AssertionError("instruction budget should be enforced");
+        } catch (QuickJSTimeoutException e) {
+            assertTrue(e.getMessage().contains("instruction budget exhausted"));
+        }
+        assertEquals(3, quickJS.withExecutionLimits(1000, () -> context.executeScript("1 + 2", "file.js")));
+    }
+}
@@ -242,4 +242,95 @@ public class JSFunctionTest  extends BaseTest{
         context.executeVoidScript("log(['Hello'])", null);
 //        assertEquals("Hello", ans[0]);
     }
+
+    @Test
+    public void callbackSlotsAreReleasedWithFunction() {
+        int before = quickJS.getCallbackCount();
+        for (int i = 0; i < 1000; i++) {
+            final int value = i;
+            // 重新注册同名函数时旧函数被 JS 回收，它的回调槽位随之释放并复用
+            context.registerJavaMethod("dynamic", (JavaCallback) (receiver, args) -> value).close();
+            assertEquals(i, context.executeIntegerScript("dynamic()", null));
+        }
+        assertEquals(before + 1, quickJS.getCallbackCount());
+        context.executeVoidScript("delete globalThis.dynamic", null);
+        assertEquals(before, quickJS.getCallbackCount());
+    }
+
+    @Test
+    public void callbacksWithEqualHashCodesDoNotCollide() {
+        context.registerJavaMethod("first", new JavaCallback() {
+            @Override
+            public Object invoke(JSObject receiver, Object[] args) {
+                return "first";
+            }
+
+            @Override
+            public int hashCode() {
+                return 42;
+            }
+        });
+        context.registerJavaMethod("second", new JavaCallback() {
+            @Override
+            public Object invoke(JSObject receiver, Object[] args) {
+                return "second";
+            }
+
+            @Override
+            public int hashCode() {
+                return 42;
+            }
+        });
+        assertEquals("first second", context.executeStringScript("first() + ' ' + second()", null));
+    }
+
+    @Test
+    public void typedCallbacks() {
+        context.registerJavaMethod("hypot", (DoubleBinaryCallback) Math::hypot);
+        context.registerJavaMethod("half", (DoubleUnaryCallback) a -> a / 2);
+        context.registerJavaMethod("imul", (IntBinaryCallback) (a, b) -> a * b);
+        StringBuilder log = new StringBuilder();
+        context.registerJavaMethod("log", (StringCallback) log::append);
+        assertEquals(5.0, context.executeDoubleScript("hypot(3, 4)", null), 0);
+        assertEquals(1.25, context.executeDoubleScript("half('2.5')", null), 0);
+        assertEquals(-6, context.executeIntegerScript("imul(2.9, -3)", null));
+        assertTrue(context.executeBooleanScript("isNaN(half())", null));
+        context.executeVoidScript("log('a'); log(1); log({toString: function () { return 'c'; }})", null);
+        assertEquals("a1c", log.toString());
+
+        context.registerJavaMethod("boom", (DoubleUnaryCallback) a -> {
+            throw new IllegalStateException("typed");
+        });
+        assertEquals("typed", context.executeStringScript(
+                "try { boom(1); 'no' } catch (e) { e.message.indexOf('typed') >= 0 ? 'typed' : e.message }", null));
+    }
+
+    @Test
+    public void preparedCall() {
+        JSObject scorer = context.executeObjectScript(
+                "({bias: 0.5, score: function (a, b) { return a * b + this.bias; }," +
+                        " add: function (a, b) { return a + b; }," +
+                        " sum: function () { var s = 0; for (var i = 0; i < arguments.length; i++) s += arguments[i]; return s; }," +
+                        " fail: function () { throw new Error('boom'); }})", "file.js");
+        PreparedCall score = ((JSFunction) scorer.get("score")).prepare(scorer);
+        assertEquals(6.5, score.callDD(2, 3), 0);
+        JSFunction add = (JSFunction) scorer.get("add");
+        assertEquals(7, add.prepare().callII(3, 4));
+        assertEquals(1L << 40, add.prepare().callLL(1L << 39, 1L << 39));
+        assertEquals(10.0, ((JSFunction) scorer.get("sum")).prepare().callDoubles(1, 2, 3, 4), 0);
+        PreparedCall fail = ((JSFunction) scorer.get("fail")).prepare();
+        try {
+            fail.callVoid();
+            throw new AssertionError();
+        } catch (QuickJSException e) {
+            assertTrue(e.getMessage().contains("boom"));
+        }
+        add.close();
+        try {
+            add.prepare().callII(1, 2);
+            throw new AssertionError();
+        } catch (QuickJSException e) {
+            assertTrue(e.getMessage().contains("released"));
+        }
+    }
 }
\ No newline at end of file
@@ -9,9 +9,16 @@ import org.junit.After;
 import org.junit.Before;
 import org.junit.Test;
 
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+import static org.junit.Assert.assertArrayEquals;
 import static org.junit.Assert.assertEquals;
 import static org.junit.Assert.assertFalse;
 import static org.junit.Assert.assertTrue;
+import static org.junit.Assert.fail;
 
 public class JSObjectTest extends BaseTest {
 
@@ -45,6 +52,33 @@ public class JSObjectTest extends BaseTest {
         assertEquals(1, object.getInteger("key3"));
     }
 
+    @Test
+    public void getManyAndSetMany() {
+        object.setMany(new String[]{"name", "age", "score", "vip"}, new Object[]{"Wiki", 18, 3.5, true});
+        Object[] values = object.getMany(new String[]{"name", "age", "score", "vip", "missing"});
+        assertEquals("Wiki", values[0]);
+        assertEquals(18, values[1]);
+        assertEquals(3.5, (Double) values[2], 0);
+        assertEquals(true, values[3]);
+        assertTrue(values[4] instanceof JSObject.Undefined);
+    }
+
+    @Test
+    public void useAfterCloseIsDetected() {
+        JSObject child = new JSObject(context);
+        child.set("value", 1);
+        child.close();
+        try {
+            child.getInteger("value");
+            throw new AssertionError("expected QuickJSException");
+        } catch (QuickJSException e) {
+            // 已释放的句柄被原生句柄表识别
+        }
+        JSObject next = new JSObject(context);
+        next.set("value", 2);
+        assertEquals(2, next.getInteger("value"));
+    }
+
     @Test
     public void getBoolean() {
         object.set("key1", true);
@@ -312,6 +346,46 @@ public class JSObjectTest extends BaseTest {
         assertEquals("b", jsonObject.getJSONArray("likes").getJSONObject(2).getString("b"));
     }
 
+    @Test
+    public void toJavaAndFromJava() {
+        JSObject graph = (JSObject) context.executeScript("({ name: 'Wiki', age: 18, score: 1.5, big: 12n, " +
+                "list: [1, 'a', null, undefined], bytes: new Uint8Array([1, 2, 3]), " +
+                "doubles: new Float64Array([0.5]), nested: { ok: true }, fn() {} })", "graph.js");
+        Map<?, ?> map = (Map<?, ?>) graph.toJava();
+        assertEquals("Wiki", map.get("name"));
+        assertEquals(18, map.get("age"));
+        assertEquals(1.5, map.get("score"));
+        assertEquals(12L, map.get("big"));
+        assertEquals(Arrays.asList(1, "a", null, null), map.get("list"));
+        assertArrayEquals(new byte[]{1, 2, 3}, (byte[]) map.get("bytes"));
+        assertArrayEquals(new double[]{0.5}, (double[]) map.get("doubles"), 0);
+        assertEquals(true, ((Map<?, ?>) map.get("nested")).get("ok"));
+        assertFalse(map.containsKey("fn"));
+
+        Map<String, Object> source = new HashMap<>();
+        source.put("list", Arrays.asList(1, "b"));
+        source.put("ints", new int[]{4, 5});
+        source.put("nested", map.get("nested"));
+        source.put(null, "null key");
+        JSObject back = (JSObject) context.fromJava(source);
+        assertEquals("null key", back.getString("null"));
+        assertEquals("b", ((JSArray) back.get("list")).getString(1));
+        context.getGlobal().set("back", back);
+        assertEquals(5, context.executeScript("back.ints instanceof Int32Array ? back.ints[1] : -1", "back.js"));
+        assertTrue(back.getObject("nested").getBoolean("ok"));
+        assertEquals(source.get("list"), ((Map<?, ?>) back.toJava()).get("list"));
+
+        JSObject cyclic = (JSObject) context.executeScript("var c = { a: {} }; c.a.self = c; c", "cycle.js");
+        try {
+            cyclic.toJava();
+            fail();
+        } catch (QuickJSException e) {
+            assertTrue(e.getMessage().contains("cyclic"));
+        }
+        JSObject shared = (JSObject) context.executeScript("var s = {}; ({ a: s, b: s })", "shared.js");
+        assertEquals(2, ((Map<?, ?>) shared.toJava()).size());
+    }
+
     public static class Console {
         int count = 0;
 
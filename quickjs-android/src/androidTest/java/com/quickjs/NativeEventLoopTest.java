@@ -0,0 +1,142 @@
+package com.quickjs;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.List;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicBoolean;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
+
+/**
+ * 原生事件循环的调度语义。只使用 JUnit 与 com.quickjs，不依赖 Android API
+ */
+public class NativeEventLoopTest extends BaseTest {
+    private QuickJS quickJS;
+    private EventLoop eventLoop;
+
+    @Before
+    public void setUp() {
+        quickJS = QuickJS.Companion.createRuntimeWithNativeEventLoop();
+        eventLoop = quickJS.getNative().getEventLoop();
+    }
+
+    @After
+    public void tearDown() {
+        quickJS.close();
+    }
+
+    @Test
+    public void postRunsInOrder() throws InterruptedException {
+        List<Integer> order = Collections.synchronizedList(new ArrayList<>());
+        CountDownLatch done = new CountDownLatch(1);
+        for (int i = 0; i < 1000; i++) {
+            final int index = i;
+            assertTrue(eventLoop.post(() -> order.add(index)));
+        }
+        eventLoop.post(done::countDown);
+        assertTrue(done.await(10, TimeUnit.SECONDS));
+        assertEquals(1000, order.size());
+        for (int i = 0; i < order.size(); i++) {
+            assertEquals(i, (int) order.get(i));
+        }
+    }
+
+    @Test
+    public void postDelayedRunsByDeadline() throws InterruptedException {
+        List<String> order = Collections.synchronizedList(new ArrayList<>());
+        CountDownLatch done = new CountDownLatch(4);
+        eventLoop.postDelayed(() -> { order.add("150"); done.countDown(); }, 150);
+        eventLoop.postDelayed(() -> { order.add("50"); done.countDown(); }, 50);
+        eventLoop.postDelayed(() -> { order.add("100"); done.countDown(); }, 100);
+        eventLoop.post(() -> { order.add("0"); done.countDown(); });
+        assertTrue(done.await(10, TimeUnit.SECONDS));
+        assertEquals(Arrays.asList("0", "50", "100", "150"), order);
+    }
+
+    @Test
+    public void removeCallbacksCancelsTimer() throws InterruptedException {
+        AtomicBoolean cancelledRan = new AtomicBoolean(false);
+        CountDownLatch done = new CountDownLatch(1);
+        Runnable cancelled = () -> cancelledRan.set(true);
+        eventLoop.postDelayed(cancelled, 100);
+        eventLoop.postDelayed(cancelled, 120);
+        eventLoop.removeCallbacks(cancelled);
+        eventLoop.postDelayed(done::countDown, 300);
+        assertTrue(done.await(10, TimeUnit.SECONDS));
+        assertFalse(cancelledRan.get());
+    }
+
+    @Test
+    public void postFromLoopThreadBeyondCapacity() throws InterruptedException {
+        // 超过环形队列容量（4096），循环线程自己投递时不能等待自己消费
+        final int count = 10_000;
+        List<Integer> order = new ArrayList<>();
+        CountDownLatch done = new CountDownLatch(1);
+        eventLoop.post(() -> {
+            for (int i = 0; i < count; i++) {
+                final int index = i;
+                assertTrue(eventLoop.post(() -> order.add(index)));
+            }
+            eventLoop.post(done::countDown);
+        });
+        assertTrue(done.await(10, TimeUnit.SECONDS));
+        assertEquals(count, order.size());
+        for (int i = 0; i < count; i++) {
+            assertEquals(i, (int) order.get(i));
+        }
+    }
+
+    @Test
+    public void closeRunsTasksQueuedBeforeIt() throws InterruptedException {
+        CountDownLatch gate = new CountDownLatch(1);
+        AtomicInteger ran = new AtomicInteger();
+        eventLoop.post(() -> {
+            try {
+                gate.await();
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+            }
+        });
+        for (int i = 0; i < 100; i++) {
+            eventLoop.post(ran::incrementAndGet);
+        }
+        // close 会排在已投递的任务之后释放运行时，然后等待循环线程结束
+        Thread closer = new Thread(quickJS::close);
+        closer.start();
+        gate.countDown();
+        closer.join(10_000);
+        assertFalse(closer.isAlive());
+        assertEquals(100, ran.get());
+        assertFalse(eventLoop.post(ran::incrementAndGet));
+    }
+
+    @Test
+    public void closeOnLoopThreadDropsQueuedTasks() throws InterruptedException {
+        AtomicInteger ran = new AtomicInteger();
+        CountDownLatch closed = new CountDownLatch(1);
+        eventLoop.post(() -> {
+            for (int i = 0; i < 100; i++) {
+                eventLoop.post(ran::incrementAndGet);
+            }
+            eventLoop.postDelayed(ran::incrementAndGet, 10);
+            // 在循环线程上关闭：线程 detach，当前任务返回后退出并丢弃剩余任务
+            quickJS.close();
+            closed.countDown();
+        });
+        assertTrue(closed.await(10, TimeUnit.SECONDS));
+        Thread.sleep(200);
+        assertEquals(0, ran.get());
+        assertFalse(eventLoop.post(ran::incrementAndGet));
+        assertFalse(eventLoop.postDelayed(ran::incrementAndGet, 10));
+    }
+}
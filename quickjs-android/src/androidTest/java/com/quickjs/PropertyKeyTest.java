@@ -0,0 +1,60 @@
+package com.quickjs;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
+
+public class PropertyKeyTest extends BaseTest {
+    private JSContext context;
+    private QuickJS quickJS;
+
+    @Before
+    public void setUp() {
+        quickJS = createQuickJS();
+        context = quickJS.createContext();
+    }
+
+    @After
+    public void tearDown() {
+        context.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void getAndSet() {
+        PropertyKey name = context.newPropertyKey("name");
+        PropertyKey age = context.newPropertyKey("age");
+        JSObject object = new JSObject(context);
+        object.set(name, "Wiki");
+        object.set(age, 18);
+        assertEquals("Wiki", object.getString(name));
+        assertEquals(18, object.getInteger(age));
+        assertEquals("Wiki", object.getString("name"));
+        assertTrue(object.contains(name));
+
+        Object[] values = object.getMany(new PropertyKey[]{name, age});
+        assertEquals("Wiki", values[0]);
+        assertEquals(18, values[1]);
+        name.close();
+        age.close();
+    }
+
+    @Test
+    public void executeFunction() {
+        PropertyKey add = context.newPropertyKey("add");
+        JSObject object = (JSObject) context.executeScript("({ add: function (a, b) { return a + b; } })", "file.js");
+        assertEquals(3, object.executeFunction(add, 1, 2));
+        assertFalse(new JSObject(context).contains(add));
+    }
+
+    @Test(expected = IllegalStateException.class)
+    public void closedKey() {
+        PropertyKey key = context.newPropertyKey("key");
+        key.close();
+        new JSObject(context).get(key);
+    }
+}
@@ -0,0 +1,65 @@
+package com.quickjs;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.concurrent.ExecutionException;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertTrue;
+import static org.junit.Assert.fail;
+
+public class QuickJSPoolTest extends BaseTest {
+    private static final int SIZE = 4;
+    private QuickJSPool pool;
+
+    @Before
+    public void setUp() {
+        pool = new QuickJSPool(SIZE, Collections.singletonMap("preload.js", "function square(x) { return x * x; }"));
+    }
+
+    @After
+    public void tearDown() {
+        pool.close();
+    }
+
+    @Test
+    public void preloadOnEveryWorker() throws Exception {
+        List<QuickJSFuture<Object>> futures = new ArrayList<>();
+        for (int i = 0; i < 100; i++) {
+            futures.add(pool.executeFunction("square", i));
+        }
+        for (int i = 0; i < futures.size(); i++) {
+            assertEquals(i * i, futures.get(i).get());
+        }
+        long completed = 0;
+        for (QuickJSPool.WorkerMetrics metrics : pool.metrics()) {
+            completed += metrics.getCompleted();
+        }
+        assertEquals(100, completed);
+        assertEquals(0, pool.getQueueDepth());
+    }
+
+    @Test
+    public void submitRunsOnPoolContext() throws Exception {
+        QuickJSFuture<Object> future = pool.submit(ctx -> ctx.executeScript("square(7)", "submit.js"));
+        assertEquals(49, future.get());
+        assertEquals(SIZE, pool.metrics().size());
+    }
+
+    @Test
+    public void submitAfterCloseFails() throws Exception {
+        pool.close();
+        QuickJSFuture<Object> future = pool.executeFunction("square", 3);
+        try {
+            future.get();
+            fail("task submitted after close should fail");
+        } catch (ExecutionException e) {
+            assertTrue(e.getCause() instanceof IllegalStateException);
+        }
+    }
+}
@@ -1,7 +1,18 @@
 package com.quickjs;
 
+import org.json.JSONArray;
+import org.json.JSONException;
+import org.json.JSONObject;
 import org.junit.Test;
 
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertTrue;
+
 public class QuickJSTest extends BaseTest {
 
     @Test
@@ -39,4 +50,142 @@ public class QuickJSTest extends BaseTest {
         JSContext context = quickJS.createContext();
         quickJS.close();
     }
-}
\ No newline at end of file
+
+    @Test
+    public void memoryUsage() throws InterruptedException {
+        QuickJS quickJS = QuickJS.Companion.createRuntimeWithEventQueue();
+        JSContext context = quickJS.createContext();
+        MemoryUsage before = quickJS.getMemoryUsage();
+        assertEquals(-1, before.getMallocLimit());
+        context.executeVoidScript("var items = []; for (var i = 0; i < 1000; i++) items.push({ i: i });", "file.js");
+        MemoryUsage after = quickJS.getMemoryUsage();
+        assertTrue(after.getObjectCount() >= before.getObjectCount() + 1000);
+        assertTrue(after.getFastArrayElements() >= 1000);
+
+        quickJS.setMemoryLimit(64L * 1024 * 1024);
+        quickJS.setGCThreshold(1024 * 1024);
+        quickJS.setMaxStackSize(512 * 1024);
+        assertEquals(64L * 1024 * 1024, quickJS.getMemoryUsage().getMallocLimit());
+        context.executeVoidScript("items = null;", "file.js");
+        quickJS.runGC();
+        assertTrue(quickJS.getMemoryUsage().getObjectCount() < after.getObjectCount());
+
+        CountDownLatch sampled = new CountDownLatch(3);
+        MemoryUsageSampler sampler = new MemoryUsageSampler(quickJS, 10, 2, usage -> {
+            sampled.countDown();
+            return null;
+        });
+        assertTrue(sampled.await(5, TimeUnit.SECONDS));
+        sampler.close();
+        assertEquals(2, sampler.samples().size());
+        assertNotNull(sampler.getPeak());
+        assertNotNull(sampler.getLatest());
+        context.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void arenaRuntime() {
+        QuickJS plain = QuickJS.Companion.createRuntimeWithEventQueue();
+        assertNull(plain.getArenaStats());
+        plain.close();
+
+        QuickJS quickJS = QuickJS.Companion.createRuntimeWithEventQueue(true);
+        JSContext context = quickJS.createContext();
+        context.executeVoidScript("var items = []; for (var i = 0; i < 1000; i++) items.push({ i: i, s: 'item' + i });" +
+                "var big = 'x'.repeat(4096);", "file.js");
+        assertEquals(1000, context.executeIntegerScript("items.length", "file.js"));
+        ArenaStats stats = quickJS.getArenaStats();
+        assertNotNull(stats);
+        long live = 0;
+        for (ArenaStats.SizeClass sizeClass : stats.getSizeClasses()) {
+            live += sizeClass.getLive();
+            assertTrue(sizeClass.getAllocations() >= sizeClass.getLive());
+        }
+        assertTrue(live >= 1000);
+        assertTrue(stats.getLargeCount() > 0);
+        assertTrue(stats.getReservedBytes() > 0);
+        context.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void inlineCacheStats() {
+        QuickJS quickJS = QuickJS.Companion.createRuntimeWithEventQueue();
+        JSContext context = quickJS.createContext();
+        quickJS.resetInlineCacheStats();
+        context.executeVoidScript("function Point(x, y) { this.x = x; this.y = y; }" +
+                "var sum = 0; for (var i = 0; i < 1000; i++) { var p = new Point(i, 1); p.x = p.x + 1; sum += p.x + p.y; }", "file.js");
+        InlineCacheStats stats = quickJS.getInlineCacheStats();
+        assertTrue(stats.getGetHits() > 1000);
+        assertTrue(stats.getPutHits() > 1000);
+        assertTrue(stats.getGlobalHits() > 1000);
+        assertTrue(stats.getHitRate() > 0.9);
+        quickJS.resetInlineCacheStats();
+        assertEquals(0, quickJS.getInlineCacheStats().getGetHits());
+        context.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void opcodeProfile() {
+        QuickJS quickJS = QuickJS.Companion.createRuntimeWithEventQueue();
+        JSContext context = quickJS.createContext();
+        assertEquals(0, quickJS.getProfile().getTotal());
+        quickJS.setOpcodeProfiling(true);
+        context.executeVoidScript("function add(a, b) { return a + b; }" +
+                "var sum = 0; for (var i = 0; i < 100; i++) sum = add(sum, i);", "hot.js");
+        quickJS.setOpcodeProfiling(false);
+        OpcodeProfile profile = quickJS.getProfile();
+        assertTrue(profile.getTotal() > 500);
+        assertTrue(profile.getOpcodes().get(0).getCount() >= profile.getOpcodes().get(1).getCount());
+        assertTrue(profile.getPairs().get(0).getCount() > 0);
+        OpcodeProfile.FunctionProfile add = findFunction(profile, "add");
+        assertNotNull(add);
+        assertEquals("hot.js", add.getFileName());
+        assertEquals(100, add.getCalls());
+        assertTrue(profile.format().contains("hot.js:1:1"));
+        // 关闭后不再计数
+        context.executeVoidScript("add(1, 2)", "cold.js");
+        assertEquals(100, findFunction(quickJS.getProfile(), "add").getCalls());
+        quickJS.resetProfile();
+        assertEquals(0, quickJS.getProfile().getTotal());
+        context.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void cpuProfile() throws JSONException {
+        QuickJS quickJS = QuickJS.Companion.createRuntimeWithEventQueue();
+        JSContext context = quickJS.createContext();
+        assertNull(quickJS.getCpuProfile());
+        quickJS.startCPUProfiler(200);
+        context.executeVoidScript("function busy() { var end = Date.now() + 200, n = 0; while (Date.now() < end) n++; return n; }\n" +
+                "busy();", "busy.js");
+        quickJS.stopCPUProfiler();
+        JSONObject profile = new JSONObject(quickJS.getCpuProfile());
+        JSONArray nodes = profile.getJSONArray("nodes");
+        assertEquals("(root)", nodes.getJSONObject(0).getJSONObject("callFrame").getString("functionName"));
+        int busyHits = 0;
+        for (int i = 0; i < nodes.length(); i++) {
+            JSONObject node = nodes.getJSONObject(i);
+            JSONObject callFrame = node.getJSONObject("callFrame");
+            if (callFrame.getString("functionName").equals("busy")) {
+                assertEquals("busy.js", callFrame.getString("url"));
+                assertEquals(0, callFrame.getInt("lineNumber"));
+                busyHits += node.getInt("hitCount");
+            }
+        }
+        assertTrue(busyHits > 0);
+        assertEquals(profile.getJSONArray("samples").length(), profile.getJSONArray("timeDeltas").length());
+        context.close();
+        quickJS.close();
+    }
+
+    private static OpcodeProfile.FunctionProfile findFunction(OpcodeProfile profile, String name) {
+        for (OpcodeProfile.FunctionProfile function : profile.getFunctions()) {
+            if (function.getName().equals(name)) return function;
+        }
+        return null;
+    }
+}
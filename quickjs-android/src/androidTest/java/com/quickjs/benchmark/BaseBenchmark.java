@@ -0,0 +1,42 @@
+package com.quickjs.benchmark;
+
+import android.util.Log;
+
+import com.quickjs.BaseTest;
+
+/**
+ * 基准测试的公共部分：按轮次计时，结果统一以 QuickJS-Benchmark 为 TAG 输出到 logcat。
+ */
+public abstract class BaseBenchmark extends BaseTest {
+    protected static final String TAG = "QuickJS-Benchmark";
+
+    protected interface Round {
+        void run(int round);
+    }
+
+    /**
+     * 连续执行 rounds 轮，返回总耗时（纳秒）
+     */
+    protected static long time(int rounds, Round body) {
+        long start = System.nanoTime();
+        for (int i = 0; i < rounds; i++) {
+            body.run(i);
+        }
+        return System.nanoTime() - start;
+    }
+
+    protected static long micros(long nanos, long rounds) {
+        return nanos / rounds / 1000;
+    }
+
+    /**
+     * 每秒完成的操作数
+     */
+    protected static long throughput(long nanos, long operations) {
+        return operations * 1_000_000_000L / Math.max(nanos, 1);
+    }
+
+    protected static void report(String name, String result) {
+        Log.i(TAG, name + ": " + result);
+    }
+}
@@ -0,0 +1,54 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSFunction;
+import com.quickjs.JSObject;
+import com.quickjs.PreparedCall;
+import com.quickjs.QuickJS;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import static org.junit.Assert.assertEquals;
+
+/**
+ * 两个 double 参数的打分函数：通用 call 需要装箱参数和结果，PreparedCall.callDD 全程传递基本类型。
+ */
+public class CallBenchmarkTest extends BaseBenchmark {
+    private static final int CALLS = 200_000;
+
+    private JSContext context;
+    private QuickJS quickJS;
+    private JSFunction score;
+
+    @Before
+    public void setUp() {
+        quickJS = QuickJS.Companion.createRuntime();
+        context = quickJS.createContext();
+        score = (JSFunction) context.executeScript("(function (a, b) { return a * 0.7 + b * 0.3; })", "bench.js");
+    }
+
+    @After
+    public void tearDown() {
+        context.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void boxedCall() {
+        assertEquals(1.0, ((Number) score.call((JSObject) null, 1.0, 1.0)).doubleValue(), 1e-9);
+        reportCalls("call", time(CALLS, i -> score.call((JSObject) null, (double) i, 1.5)));
+    }
+
+    @Test
+    public void typedCall() {
+        PreparedCall prepared = score.prepare();
+        assertEquals(1.0, prepared.callDD(1.0, 1.0), 1e-9);
+        reportCalls("callDD", time(CALLS, i -> prepared.callDD(i, 1.5)));
+    }
+
+    private void reportCalls(String name, long nanos) {
+        report(name, (nanos / CALLS) + " ns/call, " + throughput(nanos, CALLS) + " calls/s");
+    }
+}
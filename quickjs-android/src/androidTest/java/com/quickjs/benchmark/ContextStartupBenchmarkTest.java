@@ -0,0 +1,87 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.ContextSnapshot;
+import com.quickjs.JSContext;
+import com.quickjs.QuickJS;
+import com.quickjs.plugin.ConsolePlugin;
+import com.quickjs.plugin.TimerPlugin;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * 上下文启动耗时：逐个创建并初始化 vs 从 ContextSnapshot 生成（字节码预加载 + 预热）。
+ */
+public class ContextStartupBenchmarkTest extends BaseBenchmark {
+    private static final int ROUNDS = 50;
+    private static final String PRELOAD;
+
+    static {
+        StringBuilder builder = new StringBuilder();
+        for (int i = 0; i < 500; i++) {
+            builder.append("function helper").append(i).append("(a, b) { return { sum: a + b, list: [a, b, ")
+                    .append(i).append("] }; }\n");
+        }
+        PRELOAD = builder.toString();
+    }
+
+    private QuickJS quickJS;
+
+    @Before
+    public void setUp() {
+        quickJS = QuickJS.Companion.createRuntimeWithEventQueue();
+    }
+
+    @After
+    public void tearDown() {
+        quickJS.close();
+    }
+
+    @Test
+    public void createContext() {
+        reportStartup("createContext", time(ROUNDS, i -> {
+            JSContext context = quickJS.createContext();
+            context.addPlugin(new ConsolePlugin());
+            context.addPlugin(new TimerPlugin());
+            context.executeScript(PRELOAD, "preload.js");
+            context.close();
+        }));
+    }
+
+    @Test
+    public void snapshot() {
+        ContextSnapshot snapshot = newSnapshot(0);
+        reportStartup("snapshot", time(ROUNDS, i -> snapshot.newContext().close()));
+        snapshot.close();
+    }
+
+    @Test
+    public void prewarmedSnapshot() throws InterruptedException {
+        ContextSnapshot snapshot = newSnapshot(ROUNDS);
+        // 等待 JS 线程空闲时完成预热
+        Thread.sleep(2000);
+        List<JSContext> contexts = new ArrayList<>(ROUNDS);
+        reportStartup("prewarmedSnapshot", time(ROUNDS, i -> contexts.add(snapshot.newContext())));
+        for (JSContext context : contexts) {
+            context.close();
+        }
+        snapshot.close();
+    }
+
+    private ContextSnapshot newSnapshot(int prewarm) {
+        return new ContextSnapshot.Builder(quickJS)
+                .addPlugin(ConsolePlugin::new)
+                .addPlugin(TimerPlugin::new)
+                .addScript(PRELOAD, "preload.js")
+                .prewarm(prewarm)
+                .build();
+    }
+
+    private void reportStartup(String name, long nanos) {
+        report(name, micros(nanos, ROUNDS) + " us/context");
+    }
+}
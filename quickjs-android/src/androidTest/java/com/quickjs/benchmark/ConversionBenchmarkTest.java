@@ -0,0 +1,124 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSArray;
+import com.quickjs.JSContext;
+import com.quickjs.JSFunction;
+import com.quickjs.JSObject;
+import com.quickjs.QuickJS;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+import static org.junit.Assert.assertEquals;
+
+/**
+ * Java -> JS 转换的微基准：10k 元素的 List/Map 作为参数传给 JS 函数。
+ * JNI 类引用与方法 ID 在 JNI_OnLoad 中缓存后，每个元素不再触发 GetMethodID/FindClass；
+ * 同一份数据上再单独计时缓存前每次调用要做的那些查找（uncachedLookups），得出缓存前后的单次调用耗时对比。
+ * JS -> Java 方向对比逐字段 get/getKeys 递归与 toJava 一次性转换约 10k 节点的对象树。
+ */
+public class ConversionBenchmarkTest extends BaseBenchmark {
+    private static final int SIZE = 10_000;
+    private static final int ROUNDS = 20;
+
+    private JSContext context;
+    private QuickJS quickJS;
+
+    @Before
+    public void setUp() {
+        quickJS = QuickJS.Companion.createRuntime();
+        context = quickJS.createContext();
+    }
+
+    @After
+    public void tearDown() {
+        context.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void listConversion() {
+        List<Object> list = new ArrayList<>(SIZE);
+        for (int i = 0; i < SIZE; i++) {
+            list.add(i % 2 == 0 ? (Object) i : (Object) (i + 0.5));
+        }
+        JSFunction length = (JSFunction) context.executeScript("(function (a) { return a.length; })", "bench.js");
+        assertEquals(SIZE, length.call((JSObject) null, list));
+
+        long cached = time(ROUNDS, i -> length.call((JSObject) null, list));
+        long lookups = time(ROUNDS, i -> uncachedLookups(SIZE, false));
+        reportConversion("List", cached);
+        reportCacheSaving("List", cached, lookups);
+    }
+
+    @Test
+    public void mapConversion() {
+        Map<String, Object> map = new HashMap<>(SIZE * 2);
+        for (int i = 0; i < SIZE; i++) {
+            map.put("k" + i, i % 2 == 0 ? (Object) Boolean.TRUE : (Object) i);
+        }
+        JSFunction size = (JSFunction) context.executeScript("(function (o) { return Object.keys(o).length; })", "bench.js");
+        assertEquals(SIZE, size.call((JSObject) null, map));
+
+        long cached = time(ROUNDS, i -> size.call((JSObject) null, map));
+        long lookups = time(ROUNDS, i -> uncachedLookups(SIZE, true));
+        reportConversion("Map", cached);
+        reportCacheSaving("Map", cached, lookups);
+    }
+
+    @Test
+    public void graphConversion() {
+        JSObject tree = (JSObject) context.executeScript("({ items: Array.from({ length: 1000 }, (_, i) => ({ " +
+                "id: i, name: 'item' + i, tags: ['a', 'b', 'c'], pos: { x: i + 0.5, y: i } })) })", "bench.js");
+        Map<?, ?> expected = (Map<?, ?>) tree.toJava();
+        assertEquals(expected, walk(tree));
+
+        reportConversion("get/getKeys graph", time(ROUNDS, i -> walk(tree)));
+        reportConversion("toJava graph", time(ROUNDS, i -> tree.toJava()));
+    }
+
+    private static Object walk(Object value) {
+        if (value instanceof JSArray) {
+            JSArray array = (JSArray) value;
+            List<Object> list = new ArrayList<>();
+            for (int i = 0; i < array.length(); i++) {
+                list.add(walk(array.get(i)));
+            }
+            return list;
+        }
+        if (value instanceof JSObject) {
+            JSObject object = (JSObject) value;
+            Map<String, Object> map = new HashMap<>();
+            for (String key : object.getKeys()) {
+                map.put(key, walk(object.get(key)));
+            }
+            return map;
+        }
+        return value;
+    }
+
+    /**
+     * 重做缓存前一次 List/Map 转换中的 FindClass/GetMethodID，实现在 quickjs-jni.cpp
+     */
+    private static native void uncachedLookups(int elements, boolean map);
+
+    /**
+     * 缓存前的单次调用耗时按“当前耗时 + 被缓存掉的查找耗时”估算
+     */
+    private void reportCacheSaving(String name, long cachedNanos, long lookupNanos) {
+        long before = cachedNanos + lookupNanos;
+        report(name + " method ID cache", "before ~" + micros(before, ROUNDS) + " us/call, after "
+                + micros(cachedNanos, ROUNDS) + " us/call, -" + lookupNanos * 100 / Math.max(before, 1) + "%");
+    }
+
+    private void reportConversion(String name, long elapsedNanos) {
+        long perElement = elapsedNanos / ((long) ROUNDS * SIZE);
+        report(name + " conversion", micros(elapsedNanos, ROUNDS) + " us/call, " + perElement + " ns/element");
+    }
+}
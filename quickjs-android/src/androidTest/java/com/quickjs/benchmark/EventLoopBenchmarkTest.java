@@ -0,0 +1,77 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.EventLoop;
+import com.quickjs.JSContext;
+import com.quickjs.QuickJS;
+
+import org.junit.Test;
+
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertTrue;
+
+/**
+ * 调度器吞吐对比：多个生产线程向 JS 线程投递空任务。
+ * Handler 每次 post 都要分配 Message 并持有 MessageQueue 锁，原生事件循环走无锁环形队列。
+ */
+public class EventLoopBenchmarkTest extends BaseBenchmark {
+    private static final int PRODUCERS = 4;
+    private static final int TASKS_PER_PRODUCER = 50_000;
+
+    @Test
+    public void handlerThroughput() throws InterruptedException {
+        QuickJS quickJS = QuickJS.Companion.createRuntimeWithEventQueue();
+        try {
+            reportThroughput("Handler", measure(quickJS.getNative().getEventLoop()));
+        } finally {
+            quickJS.close();
+        }
+    }
+
+    @Test
+    public void nativeLoopThroughput() throws InterruptedException {
+        QuickJS quickJS = QuickJS.Companion.createRuntimeWithNativeEventLoop();
+        try {
+            reportThroughput("Native", measure(quickJS.getNative().getEventLoop()));
+        } finally {
+            quickJS.close();
+        }
+    }
+
+    @Test
+    public void nativeLoopExecuteScript() {
+        QuickJS quickJS = QuickJS.Companion.createRuntimeWithNativeEventLoop();
+        JSContext context = quickJS.createContext();
+        assertEquals(3, context.executeScript("1 + 2", "loop.js"));
+        context.close();
+        quickJS.close();
+    }
+
+    private long measure(final EventLoop eventLoop) throws InterruptedException {
+        final int total = PRODUCERS * TASKS_PER_PRODUCER;
+        final CountDownLatch latch = new CountDownLatch(total);
+        final Runnable task = latch::countDown;
+        Thread[] producers = new Thread[PRODUCERS];
+        long start = System.nanoTime();
+        for (int i = 0; i < PRODUCERS; i++) {
+            producers[i] = new Thread(() -> {
+                for (int j = 0; j < TASKS_PER_PRODUCER; j++) {
+                    eventLoop.post(task);
+                }
+            });
+            producers[i].start();
+        }
+        assertTrue(latch.await(60, TimeUnit.SECONDS));
+        long elapsed = System.nanoTime() - start;
+        for (Thread producer : producers) {
+            producer.join();
+        }
+        return elapsed;
+    }
+
+    private void reportThroughput(String name, long nanos) {
+        report(name, throughput(nanos, (long) PRODUCERS * TASKS_PER_PRODUCER) + " ops/s");
+    }
+}
@@ -0,0 +1,75 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSFunction;
+import com.quickjs.JSObject;
+import com.quickjs.QuickJS;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+
+import static org.junit.Assert.assertEquals;
+
+/**
+ * 约 2 MB 的 JSON 往返：JSON.parse/JSON.stringify 经过 Java String，
+ * parseJSONBytes/stringifyToBuffer 直接传递 UTF-8 字节。
+ */
+public class JsonBenchmarkTest extends BaseBenchmark {
+    private static final int ITEMS = 20_000;
+    private static final int ROUNDS = 10;
+
+    private JSContext context;
+    private QuickJS quickJS;
+    private String json;
+    private byte[] utf8;
+
+    @Before
+    public void setUp() {
+        quickJS = QuickJS.Companion.createRuntime();
+        context = quickJS.createContext();
+        StringBuilder builder = new StringBuilder("[");
+        for (int i = 0; i < ITEMS; i++) {
+            if (i > 0) builder.append(',');
+            builder.append("{\"id\":").append(i).append(",\"name\":\"订单-").append(i)
+                    .append("\",\"price\":").append(i).append(".5").append(",\"tags\":[\"a\",\"b\"]}");
+        }
+        json = builder.append(']').toString();
+        utf8 = json.getBytes(StandardCharsets.UTF_8);
+    }
+
+    @After
+    public void tearDown() {
+        context.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void stringRoundTrip() {
+        JSFunction parse = (JSFunction) context.executeScript("(function (s) { return JSON.parse(s); })", "bench.js");
+        JSFunction stringify = (JSFunction) context.executeScript("(function (o) { return JSON.stringify(o); })", "bench.js");
+        reportRoundTrip("JSON.parse/stringify", time(ROUNDS, i -> {
+            JSObject value = (JSObject) parse.call((JSObject) null, json);
+            String out = (String) stringify.call((JSObject) null, value);
+            value.close();
+            assertEquals(json.length(), out.length());
+        }));
+    }
+
+    @Test
+    public void bytesRoundTrip() {
+        reportRoundTrip("parseJSONBytes/stringifyToBuffer", time(ROUNDS, i -> {
+            JSObject value = (JSObject) context.parseJSONBytes(utf8);
+            ByteBuffer out = context.stringifyToBuffer(value);
+            value.close();
+            assertEquals(utf8.length, out.remaining());
+        }));
+    }
+
+    private void reportRoundTrip(String name, long elapsedNanos) {
+        report(name, micros(elapsedNanos, ROUNDS) + " us/round trip, " + utf8.length + " bytes");
+    }
+}
@@ -0,0 +1,61 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSFunction;
+import com.quickjs.JSObject;
+import com.quickjs.QuickJS;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import static org.junit.Assert.assertEquals;
+
+/**
+ * 1 MB 字符串往返 Java -> JS -> Java：Latin-1 内容走 8 位快速路径，含 CJK 的内容按 UTF-16 直接复制。
+ */
+public class StringBenchmarkTest extends BaseBenchmark {
+    private static final int SIZE = 1024 * 1024;
+    private static final int ROUNDS = 20;
+
+    private JSContext context;
+    private QuickJS quickJS;
+    private JSFunction identity;
+
+    @Before
+    public void setUp() {
+        quickJS = QuickJS.Companion.createRuntime();
+        context = quickJS.createContext();
+        identity = (JSFunction) context.executeScript("(function (s) { return s; })", "bench.js");
+    }
+
+    @After
+    public void tearDown() {
+        context.close();
+        quickJS.close();
+    }
+
+    @Test
+    public void latin1RoundTrip() {
+        run("Latin-1", build("<div class=\"item\">café</div>"));
+    }
+
+    @Test
+    public void utf16RoundTrip() {
+        run("UTF-16", build("<div>模板😀</div>"));
+    }
+
+    private String build(String unit) {
+        StringBuilder builder = new StringBuilder(SIZE + unit.length());
+        while (builder.length() < SIZE) {
+            builder.append(unit);
+        }
+        return builder.toString();
+    }
+
+    private void run(String name, String text) {
+        assertEquals(text, identity.call((JSObject) null, text));
+        long nanos = time(ROUNDS, i -> identity.call((JSObject) null, text));
+        report(name + " 1MB round trip", micros(nanos, ROUNDS) + " us");
+    }
+}
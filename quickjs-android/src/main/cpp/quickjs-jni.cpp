@@ -6,16 +6,36 @@
 
 
 #include <queue>
+#include <deque>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
 
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
+#include <cstdio>
+#include <cstring>
 
-#include <android/log.h>
 #define LOG_TAG "TEST"
+#ifdef __ANDROID__
+#include <android/log.h>
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG,LOG_TAG,__VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO,LOG_TAG,__VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR,LOG_TAG,__VA_ARGS__)
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#else
+// 非 Android 平台（如 Linux JVM 上的单元测试）输出到 stderr
+#include <cstdio>
+#define LOG_PRINT(level, ...) (fprintf(stderr, "%s/" LOG_TAG ": ", level), fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define LOGD(...) LOG_PRINT("D", __VA_ARGS__)
+#define LOGI(...) LOG_PRINT("I", __VA_ARGS__)
+#define LOGE(...) LOG_PRINT("E", __VA_ARGS__)
+#define LOGW(...) LOG_PRINT("W", __VA_ARGS__)
+#endif
 
 #include <linux/input.h>
 
@@ -55,6 +75,8 @@ const int TYPE_UNSIGNED_INT_32_ARRAY = 15;
 const int TYPE_FLOAT_32_ARRAY = 16;
 const int TYPE_UNDEFINED = 99;
 
+JavaVM *jvm;
+
 jclass integerCls = nullptr;
 jclass longCls = nullptr;
 jclass doubleCls = nullptr;
@@ -63,6 +85,12 @@ jclass stringCls = nullptr;
 jclass objectCls = nullptr;
 jclass listCls = nullptr;
 jclass mapClass = nullptr;
+jclass setCls = nullptr;
+jclass iteratorCls = nullptr;
+jclass mapEntryCls = nullptr;
+jclass quickJSExceptionCls = nullptr;
+jclass runnableCls = nullptr;
+jclass quickJSTimeoutExceptionCls = nullptr;
 
 jmethodID integerInitMethodID = nullptr;
 jmethodID longInitMethodID = nullptr;
@@ -74,22 +102,67 @@ jmethodID longValueMethodID = nullptr;
 jmethodID doubleValueMethodID = nullptr;
 jmethodID booleanValueMethodID = nullptr;
 
+jmethodID listSizeMethodID = nullptr;
+jmethodID listGetMethodID = nullptr;
+jmethodID mapEntrySetMethodID = nullptr;
+jmethodID setIteratorMethodID = nullptr;
+jmethodID iteratorHasNextMethodID = nullptr;
+jmethodID iteratorNextMethodID = nullptr;
+jmethodID mapEntryGetKeyMethodID = nullptr;
+jmethodID mapEntryGetValueMethodID = nullptr;
+jmethodID objectToStringMethodID = nullptr;
+jmethodID quickJSExceptionInitMethodID = nullptr;
+jmethodID runnableRunMethodID = nullptr;
+jmethodID quickJSTimeoutExceptionInitMethodID = nullptr;
 
 jclass quickJSCls = nullptr;
-jmethodID callJavaCallbackMethodID = nullptr;
+jclass javaCallbackCls = nullptr;
+jmethodID javaCallbackInvokeMethodID = nullptr;
 jmethodID createJSValueMethodID = nullptr;
 jmethodID getModuleScriptMethodID = nullptr;
 jmethodID convertModuleNameMethodID = nullptr;
 
 jclass jsValueCls = nullptr;
-jfieldID js_value_tag_id;
-jfieldID js_value_u_int32_id;
-jfieldID js_value_u_float64_id;
-jfieldID js_value_u_ptr_id;
+jfieldID js_value_handle_id;
+
+jclass doubleUnaryCallbackCls = nullptr;
+jclass doubleBinaryCallbackCls = nullptr;
+jclass intBinaryCallbackCls = nullptr;
+jclass stringCallbackCls = nullptr;
+jmethodID doubleUnaryInvokeMethodID = nullptr;
+jmethodID doubleBinaryInvokeMethodID = nullptr;
+jmethodID intBinaryInvokeMethodID = nullptr;
+jmethodID stringInvokeMethodID = nullptr;
+
+jclass numberCls = nullptr;
+jclass collectionCls = nullptr;
+jclass arrayListCls = nullptr;
+jclass hashMapCls = nullptr;
+jclass objectArrayCls = nullptr;
+jclass byteArrayCls = nullptr;
+jclass shortArrayCls = nullptr;
+jclass intArrayCls = nullptr;
+jclass longArrayCls = nullptr;
+jclass floatArrayCls = nullptr;
+jclass doubleArrayCls = nullptr;
+jmethodID numberDoubleValueMethodID = nullptr;
+jmethodID collectionSizeMethodID = nullptr;
+jmethodID collectionIteratorMethodID = nullptr;
+jmethodID arrayListInitMethodID = nullptr;
+jmethodID arrayListAddMethodID = nullptr;
+jmethodID hashMapInitMethodID = nullptr;
+jmethodID hashMapPutMethodID = nullptr;
+
+jclass byteBufferCls = nullptr;
+jmethodID byteBufferAllocateDirectMethodID = nullptr;
+jmethodID bufferClearMethodID = nullptr;
+jmethodID bufferLimitMethodID = nullptr;
 
 std::queue<JSValue> unhandledRejections;
 
 void initES6Module(JSRuntime *rt);
+void initCallbackClass(JSRuntime *rt);
+void initExecutionBudget(JSRuntime *rt);
 
 bool JS_Equals(JSValue v1, JSValue v2) {
 #if defined(JS_NAN_BOXING)
@@ -99,21 +172,353 @@ bool JS_Equals(JSValue v1, JSValue v2) {
 #endif
 }
 
-JSValue TO_JS_VALUE(JNIEnv *env, jobject object_handle) {
-    jlong tag = env->GetLongField(object_handle, js_value_tag_id);
-#if defined(JS_NAN_BOXING)
-    return tag;
-#else
+void throwJSException(JNIEnv *env, const char *msg);
+
+/*
+ * 句柄表：交给 Java 的 JSValue 存放在所属运行时的槽位中，Java 只持有一个 long 句柄，
+ * 高 32 位是代数，低 32 位是槽位下标 + 1（0 不是有效句柄）。
+ * 释放槽位时代数加一，已释放的句柄再次使用会被识别出来，而不是访问悬空的 JSValue。
+ * 运行时只在其 JS 线程上访问，句柄表不需要加锁。
+ * 每个槽位还记录所属上下文、类型和创建位置（JNI 函数名），用于按上下文统计存活句柄和泄漏报告。
+ */
+struct HandleSlot {
     JSValue value;
-    value.tag = tag;
-    value.u.int32 = env->GetIntField(object_handle, js_value_u_int32_id);
-    value.u.float64 = env->GetDoubleField(object_handle, js_value_u_float64_id);
-    value.u.ptr = (void *) env->GetLongField(object_handle, js_value_u_ptr_id);
-    return value;
-#endif
+    uint32_t generation;
+    uint32_t next_free;
+    bool used;
+    JSContext *ctx;
+    int type;
+    const char *site;
+};
+
+/*
+ * 执行预算：QuickJS 在循环回跳和函数调用时递减计数器，每 INTERRUPT_TICKS 次调用一次中断处理函数，
+ * 处理函数在这里累计计数并检查单调时钟截止时间，超出时中断执行，对应的 JNI 调用抛出 QuickJSTimeoutException。
+ * 运行时默认预算在每次从 Java 进入 JS 的最外层调用时生效；beginExecutionBudget 为一段调用单独设置预算，
+ * 嵌套的预算只会收紧外层的限制。deadline_ns 与 tick_limit 为 0 表示不限制。
+ */
+const int64_t INTERRUPT_TICKS = 10000; // 与 quickjs.c 中的 JS_INTERRUPT_COUNTER_INIT 一致
+
+struct ExecutionBudget {
+    int64_t default_timeout_ns = 0;
+    int64_t default_ticks = 0;
+    int depth = 0;
+    int64_t deadline_ns = 0;
+    int64_t tick_limit = 0;
+    int64_t ticks = 0;
+    bool exhausted = false;
+    std::vector<std::pair<int64_t, int64_t>> saved;
+};
+
+struct Arena;
+
+// CPU 采样线程：每隔 interval 请求一次采样，JS 线程在下一次中断检查时记录调用栈
+struct CpuSampler {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop = false;
+};
+
+struct HandleTable {
+    std::vector<HandleSlot> slots;
+    uint32_t free_head = 0;
+    size_t live = 0;
+    // Java 回调表，见 NewCallbackHolder
+    std::vector<jobject> callbacks;
+    std::vector<uint32_t> free_callbacks;
+    size_t live_callbacks = 0;
+    // JSON 解析输入的可复用缓冲区，见 ParseJSONBytes
+    std::vector<char> json_scratch;
+    ExecutionBudget budget;
+    // 以内存池模式创建时的分配器，运行时释放后销毁，见 NewArenaRuntime
+    Arena *arena = nullptr;
+    CpuSampler *sampler = nullptr;
+};
+
+HandleTable *GetHandleTable(JSRuntime *rt) {
+    auto *table = static_cast<HandleTable *>(JS_GetRuntimeOpaque(rt));
+    if (table == nullptr) {
+        table = new HandleTable();
+        JS_SetRuntimeOpaque(rt, table);
+    }
+    return table;
+}
+
+// undefined 不占用槽位，统一以槽位号 0 表示，与 JSValue.UNDEFINED_HANDLE 一致
+const jlong UNDEFINED_HANDLE = 0;
+
+HandleSlot *GetHandleSlot(HandleTable *table, jlong handle) {
+    auto index = (uint32_t) (handle & 0xffffffff);
+    auto generation = (uint32_t) ((uint64_t) handle >> 32);
+    if (index == 0 || index > table->slots.size()) {
+        return nullptr;
+    }
+    HandleSlot *slot = &table->slots[index - 1];
+    if (!slot->used || slot->generation != generation) {
+        return nullptr;
+    }
+    return slot;
+}
+
+// 接管 value 的引用
+jlong NewHandle(JSContext *ctx, JSValue value, int type, const char *site) {
+    HandleTable *table = GetHandleTable(JS_GetRuntime(ctx));
+    uint32_t index;
+    if (table->free_head != 0) {
+        index = table->free_head;
+        table->free_head = table->slots[index - 1].next_free;
+    } else {
+        table->slots.push_back(HandleSlot{JS_UNDEFINED, 1, 0, false, nullptr, 0, nullptr});
+        index = (uint32_t) table->slots.size();
+    }
+    HandleSlot &slot = table->slots[index - 1];
+    slot.value = value;
+    slot.used = true;
+    slot.next_free = 0;
+    slot.ctx = ctx;
+    slot.type = type;
+    slot.site = site;
+    table->live++;
+    return (jlong) (((uint64_t) slot.generation << 32) | index);
+}
+
+bool FreeHandle(JSRuntime *rt, jlong handle) {
+    HandleTable *table = GetHandleTable(rt);
+    HandleSlot *slot = GetHandleSlot(table, handle);
+    if (slot == nullptr) {
+        return false;
+    }
+    JSValue value = slot->value;
+    slot->value = JS_UNDEFINED;
+    slot->used = false;
+    slot->generation++;
+    slot->next_free = table->free_head;
+    table->free_head = (uint32_t) (handle & 0xffffffff);
+    table->live--;
+    JS_FreeValueRT(rt, value);
+    return true;
+}
+
+/*
+ * Java 回调表：回调对象的全局引用按密集的整数 ID 存放在运行时的数组中，释放的 ID 经空闲链表复用。
+ * JS 函数的 func_data 是一个 JavaCallback 类的持有对象，opaque 中保存 ID + 1，
+ * 函数被 JS 回收时由持有对象的 finalizer 释放 ID 和全局引用。
+ * 表只在 JS 线程上访问，调用时按 ID 直接取回调对象，不需要加锁，也没有 hashCode 冲突。
+ */
+JSClassID callbackHolderClassId = 0;
+
+uint32_t NewCallbackSlot(JNIEnv *env, JSRuntime *rt, jobject callback) {
+    HandleTable *table = GetHandleTable(rt);
+    uint32_t id;
+    if (!table->free_callbacks.empty()) {
+        id = table->free_callbacks.back();
+        table->free_callbacks.pop_back();
+    } else {
+        id = (uint32_t) table->callbacks.size();
+        table->callbacks.push_back(nullptr);
+    }
+    table->callbacks[id] = env->NewGlobalRef(callback);
+    table->live_callbacks++;
+    return id;
+}
+
+void callbackHolderFinalizer(JSRuntime *rt, JSValue val) {
+    auto id = (uint32_t) ((uintptr_t) JS_GetOpaque(val, callbackHolderClassId) - 1);
+    auto *table = static_cast<HandleTable *>(JS_GetRuntimeOpaque(rt));
+    if (table == nullptr || id >= table->callbacks.size() || table->callbacks[id] == nullptr) {
+        return;
+    }
+    JNIEnv *env;
+    jvm->GetEnv((void **) &env, JNI_VERSION_1_6);
+    env->DeleteGlobalRef(table->callbacks[id]);
+    table->callbacks[id] = nullptr;
+    table->free_callbacks.push_back(id);
+    table->live_callbacks--;
+}
+
+void initCallbackClass(JSRuntime *rt) {
+    if (callbackHolderClassId == 0) {
+        JS_NewClassID(&callbackHolderClassId);
+    }
+    JSClassDef def = {};
+    def.class_name = "JavaCallback";
+    def.finalizer = callbackHolderFinalizer;
+    JS_NewClass(rt, callbackHolderClassId, &def);
+}
+
+JSValue NewCallbackHolder(JNIEnv *env, JSContext *ctx, jobject callback) {
+    JSValue holder = JS_NewObjectClass(ctx, (int) callbackHolderClassId);
+    uint32_t id = NewCallbackSlot(env, JS_GetRuntime(ctx), callback);
+    JS_SetOpaque(holder, (void *) (uintptr_t) (id + 1));
+    return holder;
+}
+
+// 返回借用的回调对象，持有对象存活期间有效
+jobject GetCallback(JSContext *ctx, JSValueConst holder) {
+    auto id = (uint32_t) ((uintptr_t) JS_GetOpaque(holder, callbackHolderClassId) - 1);
+    HandleTable *table = GetHandleTable(JS_GetRuntime(ctx));
+    return id < table->callbacks.size() ? table->callbacks[id] : nullptr;
+}
+
+int64_t monotonicNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int interruptHandler(JSRuntime *rt, void *opaque) {
+    auto *table = static_cast<HandleTable *>(JS_GetRuntimeOpaque(rt));
+    if (table == nullptr || table->budget.depth == 0) {
+        return 0;
+    }
+    ExecutionBudget &budget = table->budget;
+    budget.ticks += INTERRUPT_TICKS;
+    if ((budget.tick_limit > 0 && budget.ticks >= budget.tick_limit) ||
+        (budget.deadline_ns > 0 && monotonicNanos() >= budget.deadline_ns)) {
+        budget.exhausted = true;
+        return 1;
+    }
+    return 0;
+}
+
+void initExecutionBudget(JSRuntime *rt) {
+    GetHandleTable(rt);
+    JS_SetInterruptHandler(rt, interruptHandler, nullptr);
+}
+
+// timeout_ns 或 ticks 为 0 时不收紧对应的限制
+void EnterBudget(ExecutionBudget &budget, int64_t timeout_ns, int64_t ticks) {
+    if (budget.depth == 0) {
+        budget.deadline_ns = 0;
+        budget.tick_limit = 0;
+        budget.ticks = 0;
+        budget.exhausted = false;
+    }
+    budget.saved.emplace_back(budget.deadline_ns, budget.tick_limit);
+    budget.depth++;
+    if (timeout_ns > 0) {
+        int64_t deadline = monotonicNanos() + timeout_ns;
+        if (budget.deadline_ns == 0 || deadline < budget.deadline_ns) {
+            budget.deadline_ns = deadline;
+        }
+    }
+    if (ticks > 0) {
+        int64_t limit = budget.ticks + ticks;
+        if (budget.tick_limit == 0 || limit < budget.tick_limit) {
+            budget.tick_limit = limit;
+        }
+    }
+}
+
+void LeaveBudget(ExecutionBudget &budget) {
+    if (budget.depth == 0) {
+        return;
+    }
+    budget.deadline_ns = budget.saved.back().first;
+    budget.tick_limit = budget.saved.back().second;
+    budget.saved.pop_back();
+    budget.depth--;
+}
+
+// 从 Java 进入 JS 的 JNI 调用在作用域内执行，最外层调用应用运行时默认预算
+struct BudgetScope {
+    ExecutionBudget &budget;
+
+    explicit BudgetScope(JSContext *ctx) : budget(GetHandleTable(JS_GetRuntime(ctx))->budget) {
+        if (budget.depth == 0) {
+            EnterBudget(budget, budget.default_timeout_ns, budget.default_ticks);
+        } else {
+            EnterBudget(budget, 0, 0);
+        }
+    }
+
+    ~BudgetScope() {
+        LeaveBudget(budget);
+    }
+};
+
+// 预算耗尽导致的中断抛出 QuickJSTimeoutException 并清除标记，返回是否已抛出
+bool ThrowIfBudgetExhausted(JNIEnv *env, JSContext *ctx) {
+    ExecutionBudget &budget = GetHandleTable(JS_GetRuntime(ctx))->budget;
+    if (!budget.exhausted) {
+        return false;
+    }
+    budget.exhausted = false;
+    if (env->ExceptionCheck()) {
+        return true;
+    }
+    bool ticks_exceeded = budget.tick_limit > 0 && budget.ticks >= budget.tick_limit;
+    jstring message = env->NewStringUTF(ticks_exceeded ? "instruction budget exhausted" : "deadline exceeded");
+    auto t = (jthrowable) env->NewObject(quickJSTimeoutExceptionCls, quickJSTimeoutExceptionInitMethodID, message);
+    env->Throw(t);
+    env->DeleteLocalRef(t);
+    env->DeleteLocalRef(message);
+    return true;
+}
+
+// 释放运行时前调用，回收 Java 侧未关闭的值，避免 JS_FreeRuntime 时对象泄漏
+void StopCpuSampler(HandleTable *table) {
+    CpuSampler *sampler = table->sampler;
+    if (sampler == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sampler->mutex);
+        sampler->stop = true;
+    }
+    sampler->cv.notify_all();
+    sampler->thread.join();
+    delete sampler;
+    table->sampler = nullptr;
+}
+
+void FreeHandleTable(JSRuntime *rt) {
+    auto *table = static_cast<HandleTable *>(JS_GetRuntimeOpaque(rt));
+    if (table == nullptr) {
+        return;
+    }
+    // 采样线程持有运行时指针，必须在释放运行时之前结束
+    StopCpuSampler(table);
+    for (HandleSlot &slot : table->slots) {
+        if (slot.used) {
+            JS_FreeValueRT(rt, slot.value);
+        }
+    }
+    // 之后 JS_FreeRuntime 中运行的持有对象 finalizer 看到运行时 opaque 为空，不再访问回调表
+    JNIEnv *env;
+    jvm->GetEnv((void **) &env, JNI_VERSION_1_6);
+    for (jobject callback : table->callbacks) {
+        if (callback != nullptr) {
+            env->DeleteGlobalRef(callback);
+        }
+    }
+    JS_SetRuntimeOpaque(rt, nullptr);
+    delete table;
+}
+
+// 返回借用的 JSValue，不增加引用计数
+JSValue HANDLE_TO_JS_VALUE(JNIEnv *env, JSContext *ctx, jlong handle) {
+    if (env->ExceptionCheck() || handle == UNDEFINED_HANDLE) {
+        return JS_UNDEFINED;
+    }
+    HandleSlot *slot = GetHandleSlot(GetHandleTable(JS_GetRuntime(ctx)), handle);
+    if (slot == nullptr) {
+        LOGE("TO_JS_VALUE: stale or foreign handle %llx", (unsigned long long) handle);
+        throwJSException(env, "JSValue has been released or belongs to another runtime");
+        return JS_UNDEFINED;
+    }
+    return slot->value;
+}
+
+JSValue TO_JS_VALUE(JNIEnv *env, JSContext *ctx, jobject object_handle) {
+    if (env->ExceptionCheck()) {
+        return JS_UNDEFINED;
+    }
+    return HANDLE_TO_JS_VALUE(env, ctx, env->GetLongField(object_handle, js_value_handle_id));
 }
 
-jobject TO_JAVA_OBJECT(JNIEnv *env, JSContext *ctx, JSValue value) {
+// 接管 value 的引用，site 默认为调用方函数名，用于泄漏报告
+jobject TO_JAVA_OBJECT(JNIEnv *env, JSContext *ctx, JSValue value, const char *site = __builtin_FUNCTION()) {
     int type = TYPE_UNKNOWN;
     if (JS_IsUndefined(value)) {
         type = TYPE_UNDEFINED;
@@ -126,25 +531,64 @@ jobject TO_JAVA_OBJECT(JNIEnv *env, JSContext *ctx, JSValue value) {
     } else if (JS_IsException(value) || JS_IsError(ctx, value)) {
         type = TYPE_JS_EXCEPTION;
     }
-#if defined(JS_NAN_BOXING)
-    return env->CallStaticObjectMethod(quickJSCls,
-                                       createJSValueMethodID,
-                                       (jlong) ctx,
-                                       type,
-                                       (jlong) value,
-                                       0,
-                                       0.0,
-                                       (jlong) 0);
-#else
+    // undefined 不计引用，无需占用句柄
+    jlong handle = type == TYPE_UNDEFINED ? UNDEFINED_HANDLE : NewHandle(ctx, value, type, site);
     return env->CallStaticObjectMethod(quickJSCls,
                                        createJSValueMethodID,
                                        (jlong) ctx,
                                        type,
-                                       JS_VALUE_GET_TAG(value),
-                                       JS_VALUE_GET_INT(value),
-                                       (jdouble) JS_VALUE_GET_FLOAT64(value),
-                                       (jlong) JS_VALUE_GET_PTR(value));
-#endif
+                                       handle);
+}
+
+/*
+ * 字符串桥：jstring 与 JSString 都是 UTF-16（JSString 可能压缩为 Latin-1），直接按码元复制，
+ * 避免 modified UTF-8 的双向转码，也不会损坏补充平面字符
+ */
+jstring JSStringToJString(JNIEnv *env, JSContext *ctx, JSValueConst value) {
+    JSValue str = JS_ToString(ctx, value);
+    if (JS_IsException(str)) {
+        return nullptr;
+    }
+    size_t len;
+    JS_BOOL wide;
+    const void *buf = JS_GetStringBuffer(str, &len, &wide);
+    jstring result;
+    if (wide) {
+        result = env->NewString(static_cast<const jchar *>(buf), (jsize) len);
+    } else {
+        auto *latin1 = static_cast<const uint8_t *>(buf);
+        jchar stack_buf[256];
+        std::vector<jchar> heap_buf;
+        jchar *chars = stack_buf;
+        if (len > sizeof(stack_buf) / sizeof(jchar)) {
+            heap_buf.resize(len);
+            chars = heap_buf.data();
+        }
+        for (size_t i = 0; i < len; i++) {
+            chars[i] = latin1[i];
+        }
+        result = env->NewString(chars, (jsize) len);
+    }
+    JS_FreeValue(ctx, str);
+    return result;
+}
+
+JSValue JStringToJSValue(JNIEnv *env, JSContext *ctx, jstring string) {
+    jsize len = env->GetStringLength(string);
+    if (len >= (1 << 30)) {
+        return JS_ThrowInternalError(ctx, "string too long");
+    }
+    // 先用 GetStringRegion 复制出码元再创建 JSString：JS_NewStringUTF16 失败时会创建 Error 对象，
+    // 可能触发 GC 并在 finalizer 中调用 JNI，不能在 GetStringCritical 的临界区内进行
+    jchar stack_buf[256];
+    std::vector<jchar> heap_buf;
+    jchar *chars = stack_buf;
+    if ((size_t) len > sizeof(stack_buf) / sizeof(jchar)) {
+        heap_buf.resize(len);
+        chars = heap_buf.data();
+    }
+    env->GetStringRegion(string, 0, len, chars);
+    return JS_NewStringUTF16(ctx, reinterpret_cast<const uint16_t *>(chars), (size_t) len);
 }
 
 JSValue JobjectToJSValue(JNIEnv *env, JSContext *ctx, jobject value) {
@@ -159,12 +603,9 @@ JSValue JobjectToJSValue(JNIEnv *env, JSContext *ctx, jobject value) {
     } else if (env->IsInstanceOf(value, booleanCls)) {
         return JS_NewBool(ctx, env->CallBooleanMethod(value, booleanValueMethodID));
     } else if (env->IsInstanceOf(value, stringCls)) {
-        const char* chars = env->GetStringUTFChars((jstring) value, nullptr);
-        JSValue jsStr = JS_NewString(ctx, chars);
-        env->ReleaseStringUTFChars((jstring) value, chars);
-        return jsStr;
+        return JStringToJSValue(env, ctx, (jstring) value);
     } else if (env->IsInstanceOf(value, jsValueCls)) {
-        JSValue newValue = JS_DupValue(ctx, TO_JS_VALUE(env, value));
+        JSValue newValue = JS_DupValue(ctx, TO_JS_VALUE(env, ctx, value));
         return newValue;
     }
     return JS_UNDEFINED;
@@ -199,8 +640,11 @@ int GetObjectType(JSContext *ctx, JSValue result) {
     return TYPE_UNKNOWN;
 }
 
-jobject To_JObject(JNIEnv *env, jlong context_ptr, int expected_type, JSValue result) {
+// 消耗 result：对象交给句柄表，其它类型转换后立即释放
+jobject To_JObject(JNIEnv *env, jlong context_ptr, int expected_type, JSValue result,
+                   const char *site = __builtin_FUNCTION()) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    jobject converted = nullptr;
 
     if (expected_type == TYPE_UNKNOWN) {
         expected_type = GetObjectType(ctx, result);
@@ -212,26 +656,31 @@ jobject To_JObject(JNIEnv *env, jlong context_ptr, int expected_type, JSValue re
     }
     switch (expected_type) {
         case TYPE_NULL:
-            return nullptr;
+            break;
         case TYPE_INTEGER:
-            return env->NewObject(integerCls, integerInitMethodID, JS_VALUE_GET_INT(result));
+            converted = env->NewObject(integerCls, integerInitMethodID, JS_VALUE_GET_INT(result));
+            break;
         case TYPE_DOUBLE:
             double pres;
             JS_ToFloat64(ctx, &pres, result);
-            return env->NewObject(doubleCls, doubleInitMethodID, pres);
+            converted = env->NewObject(doubleCls, doubleInitMethodID, pres);
+            break;
         case TYPE_BOOLEAN:
-            return env->NewObject(booleanCls, booleanInitMethodID, JS_VALUE_GET_BOOL(result));
+            converted = env->NewObject(booleanCls, booleanInitMethodID, JS_VALUE_GET_BOOL(result));
+            break;
         case TYPE_STRING:
-            return env->NewStringUTF(JS_ToCString(ctx, result));
+            converted = JSStringToJString(env, ctx, result);
+            break;
         case TYPE_JS_ARRAY:
         case TYPE_JS_OBJECT:
         case TYPE_JS_FUNCTION:
         case TYPE_UNDEFINED:
-            return TO_JAVA_OBJECT(env, ctx, result);
+            return TO_JAVA_OBJECT(env, ctx, result, site);
         default:
-            return nullptr;
+            break;
     }
-    return nullptr;
+    JS_FreeValue(ctx, result);
+    return converted;
 }
 
 void tryToTriggerOnError(JSContext *ctx, JSValueConst *error) {
@@ -290,23 +739,25 @@ std::string getJSErrorStr(JSContext *ctx) {
 void throwJSException(JNIEnv *env, const char *msg) {
     if (env->ExceptionCheck()) return;
 
-    jclass e = env->FindClass("com/quickjs/QuickJSException");
-    auto init = env->GetMethodID(e, "<init>", "(Ljava/lang/String;Ljava/lang/String;)V");
     jstring ret = env->NewStringUTF(msg);
     jstring name = env->NewStringUTF("C");
-    auto t = (jthrowable)env->NewObject(e, init, name, ret);
+    auto t = (jthrowable) env->NewObject(quickJSExceptionCls, quickJSExceptionInitMethodID, name, ret);
     env->Throw(t);
-    env->DeleteLocalRef(e);
+    env->DeleteLocalRef(t);
+    env->DeleteLocalRef(name);
+    env->DeleteLocalRef(ret);
 }
 
 void throwJSException(JNIEnv *env, JSContext *ctx) {
+    if (ThrowIfBudgetExhausted(env, ctx)) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        return;
+    }
     std::string error = getJSErrorStr(ctx);
     throwJSException(env, error.c_str());
 }
 
 
-JavaVM *jvm;
-
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *) {
     jvm = vm;
     JNIEnv *env;
@@ -326,18 +777,25 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *) {
     objectCls = (jclass) env->NewGlobalRef((env)->FindClass("java/lang/Object"));
     quickJSCls = (jclass) env->NewGlobalRef((env)->FindClass("com/quickjs/QuickJS"));
     listCls = (jclass) env->NewGlobalRef((env)->FindClass("java/util/List"));
-    mapClass = (jclass) env->NewGlobalRef((env)->FindClass("java/util/HashMap"));
+    mapClass = (jclass) env->NewGlobalRef((env)->FindClass("java/util/Map"));
+    setCls = (jclass) env->NewGlobalRef((env)->FindClass("java/util/Set"));
+    iteratorCls = (jclass) env->NewGlobalRef((env)->FindClass("java/util/Iterator"));
+    mapEntryCls = (jclass) env->NewGlobalRef((env)->FindClass("java/util/Map$Entry"));
+    quickJSExceptionCls = (jclass) env->NewGlobalRef((env)->FindClass("com/quickjs/QuickJSException"));
+    runnableCls = (jclass) env->NewGlobalRef((env)->FindClass("java/lang/Runnable"));
 
     integerInitMethodID = env->GetMethodID(integerCls, "<init>", "(I)V");
     longInitMethodID = env->GetMethodID(longCls, "<init>", "(J)V");
     doubleInitMethodID = env->GetMethodID(doubleCls, "<init>", "(D)V");
     booleanInitMethodID = env->GetMethodID(booleanCls, "<init>", "(Z)V");
 
-    callJavaCallbackMethodID = env->GetStaticMethodID(quickJSCls, "callJavaCallback",
-                                                      "(JILcom/quickjs/JSValue;[Ljava/lang/Object;)Ljava/lang/Object;");
+    // JavaCallback 是 Kotlin 函数类型 (JSObject?, Array<out Any?>) -> Any?
+    javaCallbackCls = (jclass) env->NewGlobalRef((env)->FindClass("kotlin/jvm/functions/Function2"));
+    javaCallbackInvokeMethodID = env->GetMethodID(javaCallbackCls, "invoke",
+                                                  "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
 
     createJSValueMethodID = env->GetStaticMethodID(quickJSCls, "createJSValue",
-                                                   "(JIJIDJ)Lcom/quickjs/JSValue;");
+                                                   "(JIJ)Lcom/quickjs/JSValue;");
     getModuleScriptMethodID = env->GetStaticMethodID(quickJSCls, "getModuleScript",
                                                      "(JLjava/lang/String;)Ljava/lang/String;");
     convertModuleNameMethodID = env->GetStaticMethodID(quickJSCls, "convertModuleName",
@@ -348,12 +806,61 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *) {
     doubleValueMethodID = env->GetMethodID(doubleCls, "doubleValue", "()D");
     booleanValueMethodID = env->GetMethodID(booleanCls, "booleanValue", "()Z");
 
+    listSizeMethodID = env->GetMethodID(listCls, "size", "()I");
+    listGetMethodID = env->GetMethodID(listCls, "get", "(I)Ljava/lang/Object;");
+    mapEntrySetMethodID = env->GetMethodID(mapClass, "entrySet", "()Ljava/util/Set;");
+    setIteratorMethodID = env->GetMethodID(setCls, "iterator", "()Ljava/util/Iterator;");
+    iteratorHasNextMethodID = env->GetMethodID(iteratorCls, "hasNext", "()Z");
+    iteratorNextMethodID = env->GetMethodID(iteratorCls, "next", "()Ljava/lang/Object;");
+    mapEntryGetKeyMethodID = env->GetMethodID(mapEntryCls, "getKey", "()Ljava/lang/Object;");
+    mapEntryGetValueMethodID = env->GetMethodID(mapEntryCls, "getValue", "()Ljava/lang/Object;");
+    objectToStringMethodID = env->GetMethodID(objectCls, "toString", "()Ljava/lang/String;");
+    quickJSExceptionInitMethodID = env->GetMethodID(quickJSExceptionCls, "<init>",
+                                                    "(Ljava/lang/String;Ljava/lang/String;)V");
+    runnableRunMethodID = env->GetMethodID(runnableCls, "run", "()V");
+    quickJSTimeoutExceptionCls = (jclass) env->NewGlobalRef((env)->FindClass("com/quickjs/QuickJSTimeoutException"));
+    quickJSTimeoutExceptionInitMethodID = env->GetMethodID(quickJSTimeoutExceptionCls, "<init>",
+                                                           "(Ljava/lang/String;)V");
 
     jsValueCls = (jclass) env->NewGlobalRef((env)->FindClass("com/quickjs/JSValue"));
-    js_value_tag_id = env->GetFieldID(jsValueCls, "tag", "J");
-    js_value_u_int32_id = env->GetFieldID(jsValueCls, "uInt32", "I");
-    js_value_u_float64_id = env->GetFieldID(jsValueCls, "uFloat64", "D");
-    js_value_u_ptr_id = env->GetFieldID(jsValueCls, "uPtr", "J");
+    js_value_handle_id = env->GetFieldID(jsValueCls, "handle", "J");
+
+    doubleUnaryCallbackCls = (jclass) env->NewGlobalRef((env)->FindClass("com/quickjs/DoubleUnaryCallback"));
+    doubleBinaryCallbackCls = (jclass) env->NewGlobalRef((env)->FindClass("com/quickjs/DoubleBinaryCallback"));
+    intBinaryCallbackCls = (jclass) env->NewGlobalRef((env)->FindClass("com/quickjs/IntBinaryCallback"));
+    stringCallbackCls = (jclass) env->NewGlobalRef((env)->FindClass("com/quickjs/StringCallback"));
+    doubleUnaryInvokeMethodID = env->GetMethodID(doubleUnaryCallbackCls, "invoke", "(D)D");
+    doubleBinaryInvokeMethodID = env->GetMethodID(doubleBinaryCallbackCls, "invoke", "(DD)D");
+    intBinaryInvokeMethodID = env->GetMethodID(intBinaryCallbackCls, "invoke", "(II)I");
+    stringInvokeMethodID = env->GetMethodID(stringCallbackCls, "invoke", "(Ljava/lang/String;)V");
+
+    numberCls = (jclass) env->NewGlobalRef((env)->FindClass("java/lang/Number"));
+    collectionCls = (jclass) env->NewGlobalRef((env)->FindClass("java/util/Collection"));
+    arrayListCls = (jclass) env->NewGlobalRef((env)->FindClass("java/util/ArrayList"));
+    hashMapCls = (jclass) env->NewGlobalRef((env)->FindClass("java/util/HashMap"));
+    objectArrayCls = (jclass) env->NewGlobalRef((env)->FindClass("[Ljava/lang/Object;"));
+    byteArrayCls = (jclass) env->NewGlobalRef((env)->FindClass("[B"));
+    shortArrayCls = (jclass) env->NewGlobalRef((env)->FindClass("[S"));
+    intArrayCls = (jclass) env->NewGlobalRef((env)->FindClass("[I"));
+    longArrayCls = (jclass) env->NewGlobalRef((env)->FindClass("[J"));
+    floatArrayCls = (jclass) env->NewGlobalRef((env)->FindClass("[F"));
+    doubleArrayCls = (jclass) env->NewGlobalRef((env)->FindClass("[D"));
+    numberDoubleValueMethodID = env->GetMethodID(numberCls, "doubleValue", "()D");
+    collectionSizeMethodID = env->GetMethodID(collectionCls, "size", "()I");
+    collectionIteratorMethodID = env->GetMethodID(collectionCls, "iterator", "()Ljava/util/Iterator;");
+    arrayListInitMethodID = env->GetMethodID(arrayListCls, "<init>", "(I)V");
+    arrayListAddMethodID = env->GetMethodID(arrayListCls, "add", "(Ljava/lang/Object;)Z");
+    hashMapInitMethodID = env->GetMethodID(hashMapCls, "<init>", "(I)V");
+    hashMapPutMethodID = env->GetMethodID(hashMapCls, "put",
+                                          "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
+
+    byteBufferCls = (jclass) env->NewGlobalRef((env)->FindClass("java/nio/ByteBuffer"));
+    byteBufferAllocateDirectMethodID = env->GetStaticMethodID(byteBufferCls, "allocateDirect",
+                                                              "(I)Ljava/nio/ByteBuffer;");
+    jclass bufferCls = env->FindClass("java/nio/Buffer");
+    bufferClearMethodID = env->GetMethodID(bufferCls, "clear", "()Ljava/nio/Buffer;");
+    bufferLimitMethodID = env->GetMethodID(bufferCls, "limit", "(I)Ljava/nio/Buffer;");
+    env->DeleteLocalRef(bufferCls);
     return JNI_VERSION_1_6;
 }
 
@@ -408,9 +915,7 @@ bool executePendingJobLoop(JNIEnv *env, JSRuntime *rt, JSContext *ctx) {
         if (err <= 0) {
             if (err < 0) {
                 success = false;
-                std::string error = getJSErrorStr(ctx);
-                LOGI("executePendingJobLoop LL: %s", error.c_str());
-                throwJSException(env, error.c_str());
+                throwJSException(env, ctx);
                 break;
             }
             break;
@@ -430,43 +935,35 @@ JSValue JavaToJSValue(JSContext* ctx, JNIEnv* env, jobject value) {
 
     // Boolean
     if (env->IsInstanceOf(value, booleanCls)) {
-        jmethodID booleanValue = env->GetMethodID(booleanCls, "booleanValue", "()Z");
-        jboolean b = env->CallBooleanMethod(value, booleanValue);
+        jboolean b = env->CallBooleanMethod(value, booleanValueMethodID);
         return JS_NewBool(ctx, b);
     }
 
     // Integer
     if (env->IsInstanceOf(value, integerCls)) {
-        jmethodID intValue = env->GetMethodID(integerCls, "intValue", "()I");
-        jint i = env->CallIntMethod(value, intValue);
+        jint i = env->CallIntMethod(value, intValueMethodID);
         return JS_NewInt32(ctx, i);
     }
 
     // Double
     if (env->IsInstanceOf(value, doubleCls)) {
-        jmethodID doubleValue = env->GetMethodID(doubleCls, "doubleValue", "()D");
-        jdouble d = env->CallDoubleMethod(value, doubleValue);
+        jdouble d = env->CallDoubleMethod(value, doubleValueMethodID);
         return JS_NewFloat64(ctx, d);
     }
 
     // String
 
     if (env->IsInstanceOf(value, stringCls)) {
-        const char* str = env->GetStringUTFChars((jstring)value, nullptr);
-        JSValue jsStr = JS_NewString(ctx, str);
-        env->ReleaseStringUTFChars((jstring)value, str);
-        return jsStr;
+        return JStringToJSValue(env, ctx, (jstring) value);
     }
 
     // List (java.util.List)
 
     if (env->IsInstanceOf(value, listCls)) {
         JSValue arr = JS_NewArray(ctx);
-        jmethodID sizeMethod = env->GetMethodID(listCls, "size", "()I");
-        jmethodID getMethod = env->GetMethodID(listCls, "get", "(I)Ljava/lang/Object;");
-        jint size = env->CallIntMethod(value, sizeMethod);
+        jint size = env->CallIntMethod(value, listSizeMethodID);
         for (jint i = 0; i < size; i++) {
-            jobject elem = env->CallObjectMethod(value, getMethod, i);
+            jobject elem = env->CallObjectMethod(value, listGetMethodID, i);
             JSValue jsElem = JavaToJSValue(ctx, env, elem);
             JS_SetPropertyUint32(ctx, arr, i, jsElem);
             env->DeleteLocalRef(elem);
@@ -477,25 +974,13 @@ JSValue JavaToJSValue(JSContext* ctx, JNIEnv* env, jobject value) {
     // Map (java.util.Map)
     if (env->IsInstanceOf(value, mapClass)) {
         JSValue obj = JS_NewObject(ctx);
-        jmethodID entrySetMethod = env->GetMethodID(mapClass, "entrySet", "()Ljava/util/Set;");
-        jobject entrySet = env->CallObjectMethod(value, entrySetMethod);
-
-        jclass setClass = env->FindClass("java/util/Set");
-        jmethodID iteratorMethod = env->GetMethodID(setClass, "iterator", "()Ljava/util/Iterator;");
-        jobject iterator = env->CallObjectMethod(entrySet, iteratorMethod);
-
-        jclass iteratorClass = env->FindClass("java/util/Iterator");
-        jmethodID hasNextMethod = env->GetMethodID(iteratorClass, "hasNext", "()Z");
-        jmethodID nextMethod = env->GetMethodID(iteratorClass, "next", "()Ljava/lang/Object;");
-
-        jclass entryClass = env->FindClass("java/util/Map$Entry");
-        jmethodID getKeyMethod = env->GetMethodID(entryClass, "getKey", "()Ljava/lang/Object;");
-        jmethodID getValueMethod = env->GetMethodID(entryClass, "getValue", "()Ljava/lang/Object;");
+        jobject entrySet = env->CallObjectMethod(value, mapEntrySetMethodID);
+        jobject iterator = env->CallObjectMethod(entrySet, setIteratorMethodID);
 
-        while (env->CallBooleanMethod(iterator, hasNextMethod)) {
-            jobject entry = env->CallObjectMethod(iterator, nextMethod);
-            jobject key = env->CallObjectMethod(entry, getKeyMethod);
-            jobject val = env->CallObjectMethod(entry, getValueMethod);
+        while (env->CallBooleanMethod(iterator, iteratorHasNextMethodID)) {
+            jobject entry = env->CallObjectMethod(iterator, iteratorNextMethodID);
+            jobject key = env->CallObjectMethod(entry, mapEntryGetKeyMethodID);
+            jobject val = env->CallObjectMethod(entry, mapEntryGetValueMethodID);
 
             // 只处理 String key，为简化
             if (env->IsInstanceOf(key, stringCls)) {
@@ -515,22 +1000,22 @@ JSValue JavaToJSValue(JSContext* ctx, JNIEnv* env, jobject value) {
 
     // 其它类型可扩展
     if (env->IsInstanceOf(value, objectCls)) {
-        return TO_JS_VALUE(env, value);
+        return TO_JS_VALUE(env, ctx, value);
     }
     return JS_ThrowTypeError(ctx, "TODO: not instance of object");
 }
 
 
-jobject JSValueToJava(JSContext* ctx, JNIEnv* env, JSValue value) {
+// 消耗 value，规则同 To_JObject
+jobject JSValueToJava(JSContext* ctx, JNIEnv* env, JSValue value, const char *site = __builtin_FUNCTION()) {
     if (JS_IsNull(value) || JS_IsUndefined(value)) {
         return nullptr;
     }
 
     // Boolean
     if (JS_IsBool(value)) {
-        jmethodID ctor = env->GetMethodID(booleanCls, "<init>", "(Z)V");
         jboolean b = JS_ToBool(ctx, value);
-        return env->NewObject(booleanCls, ctor, b);
+        return env->NewObject(booleanCls, booleanInitMethodID, b);
     }
 
     // Number（优先转 Long，若溢出可转 Double）
@@ -539,133 +1024,1604 @@ jobject JSValueToJava(JSContext* ctx, JNIEnv* env, JSValue value) {
         if (JS_VALUE_GET_TAG(value) == JS_TAG_FLOAT64) {
             double d;
             JS_ToFloat64(ctx, &d, value);
-            jmethodID ctor = env->GetMethodID(doubleCls, "<init>", "(D)V");
-            return env->NewObject(doubleCls, ctor, (jdouble)d);
+            return env->NewObject(doubleCls, doubleInitMethodID, (jdouble)d);
         } else {
             int64_t l;
             JS_ToInt64(ctx, &l, value);
-            jmethodID ctor = env->GetMethodID(longCls, "<init>", "(J)V");
-            return env->NewObject(longCls, ctor, (jlong)l);
+            return env->NewObject(longCls, longInitMethodID, (jlong)l);
         }
     }
 
     // String
     if (JS_IsString(value)) {
-        const char* str = JS_ToCString(ctx, value);
-        jobject jstr = env->NewStringUTF(str);
-        JS_FreeCString(ctx, str);
-        return jstr;
+        jstring str = JSStringToJString(env, ctx, value);
+        JS_FreeValue(ctx, value);
+        return str;
     }
     // 其它类型返回 null
 
-    return TO_JAVA_OBJECT(env, ctx, value);
+    return TO_JAVA_OBJECT(env, ctx, value, site);
 }
 
-
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_quickjs_QuickJSNativeImpl_createRuntime(JNIEnv *env, jclass clazz) {
-    JSRuntime *runtime = JS_NewRuntime();
-    initES6Module(runtime);
-    return reinterpret_cast<jlong>(runtime);
+/*
+ * 对象图整体转换：一次 JNI 调用内递归遍历整个图，不再逐个属性 get 往返。
+ * JS -> Java：对象为 HashMap（自身可枚举字符串键），数组为 ArrayList，TypedArray/ArrayBuffer 为基本类型数组，
+ * 整数为 Integer，其它数字为 Double，BigInt 为 Long。
+ * Java -> JS：Map 为对象，Collection/Object[] 为数组，byte[] 为 Uint8Array，short[]/int[]/long[]/float[]/double[]
+ * 为对应的 TypedArray，JSValue 原样传入。
+ * 函数、Symbol 等无法表示的值在对象中跳过，在数组中为 null。
+ * 沿当前路径检测循环引用（共享的子对象会分别转换），出现循环或超过深度限制时抛出 QuickJSException。
+ */
+struct GraphConversion {
+    JNIEnv *env;
+    JSContext *ctx;
+    int depth_limit;
+    std::vector<void *> js_path;
+    std::vector<jobject> java_path;
+};
+
+bool IsGraphValue(JSContext *ctx, JSValueConst value) {
+    return !JS_IsFunction(ctx, value) && !JS_IsSymbol(value) && !JS_IsUndefined(value);
+}
+
+jobject JSGraphToJava(GraphConversion &c, JSValueConst value, int depth);
+
+jobject JSTypedArrayToJava(GraphConversion &c, JSValueConst value, int typed_type) {
+    JNIEnv *env = c.env;
+    JSContext *ctx = c.ctx;
+    size_t offset = 0;
+    size_t length;
+    size_t size;
+    uint8_t *data;
+    if (typed_type < 0) {
+        data = JS_GetArrayBuffer(ctx, &length, value);
+    } else {
+        JSValue buffer = JS_GetTypedArrayBuffer(ctx, value, &offset, &length, nullptr);
+        if (JS_IsException(buffer)) {
+            throwJSException(env, ctx);
+            return nullptr;
+        }
+        data = JS_GetArrayBuffer(ctx, &size, buffer);
+        JS_FreeValue(ctx, buffer);
+    }
+    if (data == nullptr) {
+        // 已 detach 的 ArrayBuffer
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    data += offset;
+    // 无符号类型按位复制到同宽度的有符号数组，超出有符号范围的元素在 Java 中为负数
+    switch (typed_type) {
+        case JS_TYPED_ARRAY_INT16:
+        case JS_TYPED_ARRAY_UINT16: {
+            auto n = (jsize) (length / 2);
+            jshortArray array = env->NewShortArray(n);
+            env->SetShortArrayRegion(array, 0, n, (const jshort *) data);
+            return array;
+        }
+        case JS_TYPED_ARRAY_INT32:
+        case JS_TYPED_ARRAY_UINT32: {
+            auto n = (jsize) (length / 4);
+            jintArray array = env->NewIntArray(n);
+            env->SetIntArrayRegion(array, 0, n, (const jint *) data);
+            return array;
+        }
+        case JS_TYPED_ARRAY_BIG_INT64:
+        case JS_TYPED_ARRAY_BIG_UINT64: {
+            auto n = (jsize) (length / 8);
+            jlongArray array = env->NewLongArray(n);
+            env->SetLongArrayRegion(array, 0, n, (const jlong *) data);
+            return array;
+        }
+        case JS_TYPED_ARRAY_FLOAT16: {
+            // 没有对应的 Java 类型，按元素读出为 float[]
+            auto n = (jsize) (length / 2);
+            jfloatArray array = env->NewFloatArray(n);
+            for (jsize i = 0; i < n; ++i) {
+                JSValue element = JS_GetPropertyUint32(ctx, value, i);
+                double d = 0;
+                JS_ToFloat64(ctx, &d, element);
+                auto f = (jfloat) d;
+                env->SetFloatArrayRegion(array, i, 1, &f);
+            }
+            return array;
+        }
+        case JS_TYPED_ARRAY_FLOAT32: {
+            auto n = (jsize) (length / 4);
+            jfloatArray array = env->NewFloatArray(n);
+            env->SetFloatArrayRegion(array, 0, n, (const jfloat *) data);
+            return array;
+        }
+        case JS_TYPED_ARRAY_FLOAT64: {
+            auto n = (jsize) (length / 8);
+            jdoubleArray array = env->NewDoubleArray(n);
+            env->SetDoubleArrayRegion(array, 0, n, (const jdouble *) data);
+            return array;
+        }
+        default: {
+            // ArrayBuffer 与 8 位 TypedArray
+            jbyteArray array = env->NewByteArray((jsize) length);
+            env->SetByteArrayRegion(array, 0, (jsize) length, (const jbyte *) data);
+            return array;
+        }
+    }
 }
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_quickjs_QuickJSNativeImpl_createContext(JNIEnv *env, jobject clzz, jlong runtime_ptr) {
 
-    auto *runtime = reinterpret_cast<JSRuntime *>(runtime_ptr);
-    auto *ctx = JS_NewContext(runtime);
-    return reinterpret_cast<jlong>(ctx);
-}
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_quickjs_QuickJSNativeImpl_releaseRuntime(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
-    auto *runtime = reinterpret_cast<JSRuntime *>(runtime_ptr);
-    JS_FreeRuntime(runtime);
-}extern "C"
-JNIEXPORT void JNICALL
-Java_com_quickjs_QuickJSNativeImpl_releaseContext(JNIEnv *env, jobject clazz, jlong context_ptr) {
-    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JS_FreeContext(ctx);
+jobject JSArrayGraphToJava(GraphConversion &c, JSValueConst value, int depth) {
+    JNIEnv *env = c.env;
+    JSContext *ctx = c.ctx;
+    uint32_t length = 0;
+    JSValue length_value = JS_GetPropertyStr(ctx, value, "length");
+    JS_ToUint32(ctx, &length, length_value);
+    JS_FreeValue(ctx, length_value);
+    jobject list = env->NewObject(arrayListCls, arrayListInitMethodID, (jint) length);
+    for (uint32_t i = 0; i < length; ++i) {
+        JSValue element = JS_GetPropertyUint32(ctx, value, i);
+        if (JS_IsException(element)) {
+            throwJSException(env, ctx);
+            break;
+        }
+        jobject item = IsGraphValue(ctx, element) ? JSGraphToJava(c, element, depth + 1) : nullptr;
+        JS_FreeValue(ctx, element);
+        if (env->ExceptionCheck()) {
+            break;
+        }
+        env->CallBooleanMethod(list, arrayListAddMethodID, item);
+        env->DeleteLocalRef(item);
+    }
+    return list;
 }
-extern "C"
-JNIEXPORT jobject JNICALL
-Java_com_quickjs_QuickJSNativeImpl_executeScript(JNIEnv *env, jobject clazz,jlong context_ptr,
-                                                   jint expected_type,
-                                                   jstring source, jstring file_name,jint eval_flags) {
-    if (source == nullptr) {
+
+jobject JSObjectGraphToJava(GraphConversion &c, JSValueConst value, int depth) {
+    JNIEnv *env = c.env;
+    JSContext *ctx = c.ctx;
+    JSPropertyEnum *tab;
+    uint32_t len;
+    if (JS_GetOwnPropertyNames(ctx, &tab, &len, value, JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY)) {
+        throwJSException(env, ctx);
         return nullptr;
     }
-    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-
-    JSRuntime *rt = JS_GetRuntime(ctx);
-    const char *file_name_;
-    if (file_name == nullptr) {
-        file_name_ = "";
-    } else {
-        file_name_ = env->GetStringUTFChars(file_name, JNI_FALSE);
+    jobject map = env->NewObject(hashMapCls, hashMapInitMethodID, (jint) (len + len / 3 + 1));
+    for (uint32_t i = 0; i < len; ++i) {
+        JSValue property = JS_GetProperty(ctx, value, tab[i].atom);
+        if (JS_IsException(property)) {
+            throwJSException(env, ctx);
+            break;
+        }
+        if (!IsGraphValue(ctx, property)) {
+            JS_FreeValue(ctx, property);
+            continue;
+        }
+        jobject item = JSGraphToJava(c, property, depth + 1);
+        JS_FreeValue(ctx, property);
+        if (env->ExceptionCheck()) {
+            break;
+        }
+        JSValue name = JS_AtomToString(ctx, tab[i].atom);
+        jstring key = JSStringToJString(env, ctx, name);
+        JS_FreeValue(ctx, name);
+        jobject previous = env->CallObjectMethod(map, hashMapPutMethodID, key, item);
+        env->DeleteLocalRef(previous);
+        env->DeleteLocalRef(key);
+        env->DeleteLocalRef(item);
     }
-    const char *source_ = env->GetStringUTFChars(source, JNI_FALSE);
-    const int source_length = env->GetStringUTFLength(source);
-    JSValue val = JS_Eval(ctx, source_, (size_t) source_length, file_name_, eval_flags);
-    if(JS_IsException(val)) {
-        std::string error = getJSErrorStr(ctx);
-        LOGE("executeScript: %s", error.c_str());
-//        env->ThrowNew(env->FindClass("com/quickjs/QuickJSException"), error.c_str());
-        return TO_JAVA_OBJECT(env, ctx, JS_Throw(ctx, val));
+    JS_FreePropertyEnum(ctx, tab, len);
+    return map;
+}
+
+jobject JSGraphToJava(GraphConversion &c, JSValueConst value, int depth) {
+    JNIEnv *env = c.env;
+    JSContext *ctx = c.ctx;
+    switch (JS_VALUE_GET_TAG(value)) {
+        case JS_TAG_INT:
+            return env->NewObject(integerCls, integerInitMethodID, JS_VALUE_GET_INT(value));
+        case JS_TAG_BOOL:
+            return env->NewObject(booleanCls, booleanInitMethodID, JS_VALUE_GET_BOOL(value));
+        case JS_TAG_STRING:
+            return JSStringToJString(env, ctx, value);
+        case JS_TAG_OBJECT:
+            break;
+        default:
+            if (JS_IsNumber(value)) {
+                double d;
+                JS_ToFloat64(ctx, &d, value);
+                return env->NewObject(doubleCls, doubleInitMethodID, d);
+            }
+            if (JS_IsBigInt(ctx, value)) {
+                int64_t l;
+                JS_ToBigInt64(ctx, &l, value);
+                return env->NewObject(longCls, longInitMethodID, (jlong) l);
+            }
+            return nullptr;
     }
-    if (!executePendingJobLoop(env, rt, ctx)) {
-        LOGE("executeScript: exce job error");
-        return TO_JAVA_OBJECT(env, ctx, JS_Throw(ctx, val));
+    if (depth >= c.depth_limit) {
+        throwJSException(env, "toJava: depth limit exceeded");
+        return nullptr;
     }
-    env->ReleaseStringUTFChars(source, source_);
-    env->ReleaseStringUTFChars(file_name, file_name_);
-
-    jobject result = To_JObject(env, context_ptr, expected_type, val);
+    void *ptr = JS_VALUE_GET_PTR(value);
+    for (void *ancestor : c.js_path) {
+        if (ancestor == ptr) {
+            throwJSException(env, "toJava: cyclic reference");
+            return nullptr;
+        }
+    }
+    int typed_type = JS_GetTypedArrayType(value);
+    if (typed_type >= 0 || JS_IsArrayBuffer(value)) {
+        return JSTypedArrayToJava(c, value, typed_type);
+    }
+    c.js_path.push_back(ptr);
+    jobject result = JS_IsArray(ctx, value) ? JSArrayGraphToJava(c, value, depth)
+                                            : JSObjectGraphToJava(c, value, depth);
+    c.js_path.pop_back();
     return result;
 }
 
-extern "C"
-JNIEXPORT jobject JNICALL
-Java_com_quickjs_QuickJSNativeImpl_getGlobalObject(JNIEnv *env, jobject clazz, jlong context_ptr) {
-    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue global_obj = JS_GetGlobalObject(ctx);
-    return TO_JAVA_OBJECT(env, ctx, global_obj);
+void freeArrayBufferData(JSRuntime *rt, void *opaque, void *ptr) {
+    js_free_rt(rt, ptr);
 }
 
-
-extern "C"
-JNIEXPORT jobject JNICALL
-Java_com_quickjs_QuickJSNativeImpl_initNewJSObject(JNIEnv *env, jobject clazz, jlong context_ptr) {
-    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue jsValue = JS_NewObject(ctx);
-    return TO_JAVA_OBJECT(env, ctx, jsValue);
+/*
+ * 先用 Get<Type>ArrayRegion 把元素复制到 js_malloc 的缓冲区，再交给 ArrayBuffer 接管。
+ * 不使用 GetPrimitiveArrayCritical：创建 JS 对象可能触发 GC，而 GC 中的 finalizer 会调用
+ * DeleteGlobalRef，临界区内不允许任何 JNI 调用
+ */
+JSValue NewTypedArrayFromJava(JSContext *ctx, JNIEnv *env, jarray array, size_t element_size,
+                              JSTypedArrayEnum type) {
+    jsize length = env->GetArrayLength(array);
+    auto byte_length = (size_t) length * element_size;
+    // js_malloc(0) 可能返回 NULL，空数组也分配 1 字节
+    auto *data = static_cast<uint8_t *>(js_malloc(ctx, byte_length > 0 ? byte_length : 1));
+    if (data == nullptr) {
+        return JS_EXCEPTION;
+    }
+    switch (type) {
+        case JS_TYPED_ARRAY_UINT8:
+            env->GetByteArrayRegion((jbyteArray) array, 0, length, (jbyte *) data);
+            break;
+        case JS_TYPED_ARRAY_INT16:
+            env->GetShortArrayRegion((jshortArray) array, 0, length, (jshort *) data);
+            break;
+        case JS_TYPED_ARRAY_INT32:
+            env->GetIntArrayRegion((jintArray) array, 0, length, (jint *) data);
+            break;
+        case JS_TYPED_ARRAY_BIG_INT64:
+            env->GetLongArrayRegion((jlongArray) array, 0, length, (jlong *) data);
+            break;
+        case JS_TYPED_ARRAY_FLOAT32:
+            env->GetFloatArrayRegion((jfloatArray) array, 0, length, (jfloat *) data);
+            break;
+        case JS_TYPED_ARRAY_FLOAT64:
+            env->GetDoubleArrayRegion((jdoubleArray) array, 0, length, (jdouble *) data);
+            break;
+        default:
+            js_free(ctx, data);
+            return JS_ThrowTypeError(ctx, "unsupported typed array type");
+    }
+    JSValue buffer = JS_NewArrayBuffer(ctx, data, byte_length, freeArrayBufferData, nullptr, FALSE);
+    if (JS_IsException(buffer)) {
+        js_free(ctx, data);
+        return buffer;
+    }
+    JSValue typed_array = JS_NewTypedArray(ctx, 1, &buffer, type);
+    JS_FreeValue(ctx, buffer);
+    return typed_array;
+}
+
+JSValue JavaGraphToJS(GraphConversion &c, jobject value, int depth);
+
+// 遍历 iterator 生成 JS 数组，出错时释放已生成的数组并返回 JS_EXCEPTION
+JSValue JavaIteratorToJS(GraphConversion &c, jobject iterator, int depth) {
+    JNIEnv *env = c.env;
+    JSContext *ctx = c.ctx;
+    JSValue array = JS_NewArray(ctx);
+    uint32_t index = 0;
+    while (env->CallBooleanMethod(iterator, iteratorHasNextMethodID)) {
+        jobject item = env->CallObjectMethod(iterator, iteratorNextMethodID);
+        JSValue element = JavaGraphToJS(c, item, depth + 1);
+        env->DeleteLocalRef(item);
+        if (JS_IsException(element)) {
+            JS_FreeValue(ctx, array);
+            return JS_EXCEPTION;
+        }
+        JS_DefinePropertyValueUint32(ctx, array, index++, element, JS_PROP_C_W_E);
+    }
+    return array;
 }
-extern "C"
-JNIEXPORT jobject JNICALL
-Java_com_quickjs_QuickJSNativeImpl_initNewJSArray(JNIEnv *env, jobject clazz, jlong context_ptr) {
-    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+
+JSValue JavaContainerToJS(GraphConversion &c, jobject value, int depth) {
+    JNIEnv *env = c.env;
+    JSContext *ctx = c.ctx;
+    if (env->IsInstanceOf(value, mapClass)) {
+        JSValue obj = JS_NewObject(ctx);
+        jobject entrySet = env->CallObjectMethod(value, mapEntrySetMethodID);
+        jobject iterator = env->CallObjectMethod(entrySet, setIteratorMethodID);
+        while (env->CallBooleanMethod(iterator, iteratorHasNextMethodID)) {
+            jobject entry = env->CallObjectMethod(iterator, iteratorNextMethodID);
+            jobject key = env->CallObjectMethod(entry, mapEntryGetKeyMethodID);
+            jobject val = env->CallObjectMethod(entry, mapEntryGetValueMethodID);
+            env->DeleteLocalRef(entry);
+            JSValue property = JavaGraphToJS(c, val, depth + 1);
+            env->DeleteLocalRef(val);
+            if (JS_IsException(property)) {
+                env->DeleteLocalRef(key);
+                JS_FreeValue(ctx, obj);
+                obj = JS_EXCEPTION;
+                break;
+            }
+            // null 键与 String.valueOf 一致记为 "null"，其它非字符串的键使用 toString()
+            JSAtom atom;
+            if (key == nullptr) {
+                atom = JS_NewAtom(ctx, "null");
+            } else {
+                bool string_key = env->IsInstanceOf(key, stringCls);
+                auto name = (jstring) (string_key ? key : env->CallObjectMethod(key, objectToStringMethodID));
+                if (name == nullptr) {
+                    // toString() 抛出异常或返回 null
+                    if (!env->ExceptionCheck()) {
+                        throwJSException(env, "fromJava: map key toString() returned null");
+                    }
+                    env->DeleteLocalRef(key);
+                    JS_FreeValue(ctx, property);
+                    JS_FreeValue(ctx, obj);
+                    obj = JS_EXCEPTION;
+                    break;
+                }
+                JSValue name_value = JStringToJSValue(env, ctx, name);
+                atom = JS_ValueToAtom(ctx, name_value);
+                JS_FreeValue(ctx, name_value);
+                if (!string_key) {
+                    env->DeleteLocalRef(name);
+                }
+            }
+            JS_DefinePropertyValue(ctx, obj, atom, property, JS_PROP_C_W_E);
+            JS_FreeAtom(ctx, atom);
+            env->DeleteLocalRef(key);
+        }
+        env->DeleteLocalRef(iterator);
+        env->DeleteLocalRef(entrySet);
+        return obj;
+    }
+    if (env->IsInstanceOf(value, collectionCls)) {
+        jobject iterator = env->CallObjectMethod(value, collectionIteratorMethodID);
+        JSValue array = JavaIteratorToJS(c, iterator, depth);
+        env->DeleteLocalRef(iterator);
+        return array;
+    }
+    // Object[]
+    auto items = (jobjectArray) value;
+    jsize length = env->GetArrayLength(items);
+    JSValue array = JS_NewArray(ctx);
+    for (jsize i = 0; i < length; ++i) {
+        jobject item = env->GetObjectArrayElement(items, i);
+        JSValue element = JavaGraphToJS(c, item, depth + 1);
+        env->DeleteLocalRef(item);
+        if (JS_IsException(element)) {
+            JS_FreeValue(ctx, array);
+            return JS_EXCEPTION;
+        }
+        JS_DefinePropertyValueUint32(ctx, array, (uint32_t) i, element, JS_PROP_C_W_E);
+    }
+    return array;
+}
+
+// 返回新的引用；出错时已设置 Java 异常并返回 JS_EXCEPTION
+JSValue JavaGraphToJS(GraphConversion &c, jobject value, int depth) {
+    JNIEnv *env = c.env;
+    JSContext *ctx = c.ctx;
+    if (value == nullptr) {
+        return JS_NULL;
+    }
+    if (env->IsInstanceOf(value, stringCls)) {
+        return JStringToJSValue(env, ctx, (jstring) value);
+    }
+    if (env->IsInstanceOf(value, integerCls)) {
+        return JS_NewInt32(ctx, env->CallIntMethod(value, intValueMethodID));
+    }
+    if (env->IsInstanceOf(value, booleanCls)) {
+        return JS_NewBool(ctx, env->CallBooleanMethod(value, booleanValueMethodID));
+    }
+    if (env->IsInstanceOf(value, longCls)) {
+        return JS_NewInt64(ctx, env->CallLongMethod(value, longValueMethodID));
+    }
+    if (env->IsInstanceOf(value, numberCls)) {
+        return JS_NewFloat64(ctx, env->CallDoubleMethod(value, numberDoubleValueMethodID));
+    }
+    if (env->IsInstanceOf(value, jsValueCls)) {
+        JSValue js_value = TO_JS_VALUE(env, ctx, value);
+        return env->ExceptionCheck() ? JS_EXCEPTION : JS_DupValue(ctx, js_value);
+    }
+    JSValue result;
+    if (env->IsInstanceOf(value, byteArrayCls)) {
+        result = NewTypedArrayFromJava(ctx, env, (jarray) value, 1, JS_TYPED_ARRAY_UINT8);
+    } else if (env->IsInstanceOf(value, shortArrayCls)) {
+        result = NewTypedArrayFromJava(ctx, env, (jarray) value, 2, JS_TYPED_ARRAY_INT16);
+    } else if (env->IsInstanceOf(value, intArrayCls)) {
+        result = NewTypedArrayFromJava(ctx, env, (jarray) value, 4, JS_TYPED_ARRAY_INT32);
+    } else if (env->IsInstanceOf(value, longArrayCls)) {
+        result = NewTypedArrayFromJava(ctx, env, (jarray) value, 8, JS_TYPED_ARRAY_BIG_INT64);
+    } else if (env->IsInstanceOf(value, floatArrayCls)) {
+        result = NewTypedArrayFromJava(ctx, env, (jarray) value, 4, JS_TYPED_ARRAY_FLOAT32);
+    } else if (env->IsInstanceOf(value, doubleArrayCls)) {
+        result = NewTypedArrayFromJava(ctx, env, (jarray) value, 8, JS_TYPED_ARRAY_FLOAT64);
+    } else if (env->IsInstanceOf(value, mapClass) || env->IsInstanceOf(value, collectionCls)
+               || env->IsInstanceOf(value, objectArrayCls)) {
+        if (depth >= c.depth_limit) {
+            throwJSException(env, "fromJava: depth limit exceeded");
+            return JS_EXCEPTION;
+        }
+        for (jobject ancestor : c.java_path) {
+            if (env->IsSameObject(ancestor, value)) {
+                throwJSException(env, "fromJava: cyclic reference");
+                return JS_EXCEPTION;
+            }
+        }
+        c.java_path.push_back(value);
+        result = JavaContainerToJS(c, value, depth);
+        c.java_path.pop_back();
+        return result;
+    } else {
+        throwJSException(env, "fromJava: unsupported value type");
+        return JS_EXCEPTION;
+    }
+    if (JS_IsException(result)) {
+        throwJSException(env, ctx);
+    }
+    return result;
+}
+
+/*
+ * 运行时专用的分级内存池：不超过 ARENA_MAX_SMALL 的分配按大小级别从 64KB 的块中顺序切分，
+ * 释放的槽位挂到该级别的空闲链表上复用，不归还系统；更大的分配直接使用 malloc 并挂在双向链表上。
+ * 每个分配前有 8 字节的头部记录大小级别。运行时只在 JS 线程上访问，内存池不需要加锁。
+ * JS_FreeRuntime 之后整体释放所有块，不再逐个 free，也不会在进程堆中留下碎片。
+ */
+const size_t ARENA_CHUNK_SIZE = 64 * 1024;
+const size_t ARENA_MAX_SMALL = 512;
+const uint32_t ARENA_LARGE = 0xffffffff;
+const size_t ARENA_SIZE_CLASSES[] = {16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128,
+                                     160, 192, 224, 256, 320, 384, 448, 512};
+const int ARENA_CLASS_COUNT = sizeof(ARENA_SIZE_CLASSES) / sizeof(ARENA_SIZE_CLASSES[0]);
+
+struct ArenaHeader {
+    uint32_t size_class;
+    uint32_t reserved;
+};
+
+struct ArenaLargeHeader {
+    ArenaLargeHeader *prev;
+    ArenaLargeHeader *next;
+    uint64_t size;
+    ArenaHeader header;
+};
+
+struct ArenaSizeClass {
+    ArenaHeader *free_list = nullptr;
+    char *bump = nullptr;
+    char *bump_end = nullptr;
+    int64_t live = 0;
+    int64_t allocations = 0;
+    int64_t chunks = 0;
+};
+
+struct Arena {
+    ArenaSizeClass classes[ARENA_CLASS_COUNT];
+    std::vector<char *> chunks;
+    ArenaLargeHeader *large = nullptr;
+    int64_t large_count = 0;
+    int64_t large_size = 0;
+};
+
+// 大小级别：64 以内按 8 字节递增，之后每翻一倍分为 4 级
+int ArenaSizeClassIndex(size_t size) {
+    if (size <= 64) return (int) ((size < 16 ? 16 : size) + 7) / 8 - 2;
+    if (size <= 128) return 7 + (int) (size - 65) / 16;
+    if (size <= 256) return 11 + (int) (size - 129) / 32;
+    return 15 + (int) (size - 257) / 64;
+}
+
+ArenaLargeHeader *ArenaLargeHeaderOf(void *ptr) {
+    return reinterpret_cast<ArenaLargeHeader *>(static_cast<char *>(ptr) - sizeof(ArenaLargeHeader));
+}
+
+size_t arenaUsableSize(const void *ptr) {
+    auto *header = static_cast<const ArenaHeader *>(ptr) - 1;
+    if (header->size_class == ARENA_LARGE) {
+        return (size_t) ArenaLargeHeaderOf(const_cast<void *>(ptr))->size;
+    }
+    return ARENA_SIZE_CLASSES[header->size_class];
+}
+
+void *arenaMalloc(JSMallocState *s, size_t size) {
+    auto *arena = static_cast<Arena *>(s->opaque);
+    if (size > ARENA_MAX_SMALL) {
+        if (s->malloc_size + size > s->malloc_limit) {
+            return nullptr;
+        }
+        auto *large = static_cast<ArenaLargeHeader *>(malloc(sizeof(ArenaLargeHeader) + size));
+        if (large == nullptr) {
+            return nullptr;
+        }
+        large->prev = nullptr;
+        large->next = arena->large;
+        if (arena->large != nullptr) arena->large->prev = large;
+        arena->large = large;
+        large->size = size;
+        large->header.size_class = ARENA_LARGE;
+        arena->large_count++;
+        arena->large_size += (int64_t) size;
+        s->malloc_count++;
+        s->malloc_size += size + sizeof(ArenaLargeHeader);
+        return large + 1;
+    }
+    int index = ArenaSizeClassIndex(size);
+    size_t slot_size = ARENA_SIZE_CLASSES[index];
+    if (s->malloc_size + slot_size > s->malloc_limit) {
+        return nullptr;
+    }
+    ArenaSizeClass &cls = arena->classes[index];
+    ArenaHeader *header = cls.free_list;
+    if (header != nullptr) {
+        cls.free_list = *reinterpret_cast<ArenaHeader **>(header + 1);
+    } else {
+        size_t stride = sizeof(ArenaHeader) + slot_size;
+        if (cls.bump == nullptr || (size_t) (cls.bump_end - cls.bump) < stride) {
+            auto *chunk = static_cast<char *>(malloc(ARENA_CHUNK_SIZE));
+            if (chunk == nullptr) {
+                return nullptr;
+            }
+            arena->chunks.push_back(chunk);
+            cls.chunks++;
+            cls.bump = chunk;
+            cls.bump_end = chunk + ARENA_CHUNK_SIZE;
+        }
+        header = reinterpret_cast<ArenaHeader *>(cls.bump);
+        header->size_class = (uint32_t) index;
+        cls.bump += stride;
+    }
+    cls.live++;
+    cls.allocations++;
+    s->malloc_count++;
+    s->malloc_size += slot_size + sizeof(ArenaHeader);
+    return header + 1;
+}
+
+void arenaFree(JSMallocState *s, void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    auto *arena = static_cast<Arena *>(s->opaque);
+    auto *header = static_cast<ArenaHeader *>(ptr) - 1;
+    if (header->size_class == ARENA_LARGE) {
+        ArenaLargeHeader *large = ArenaLargeHeaderOf(ptr);
+        if (large->prev != nullptr) large->prev->next = large->next; else arena->large = large->next;
+        if (large->next != nullptr) large->next->prev = large->prev;
+        arena->large_count--;
+        arena->large_size -= (int64_t) large->size;
+        s->malloc_count--;
+        s->malloc_size -= large->size + sizeof(ArenaLargeHeader);
+        free(large);
+        return;
+    }
+    ArenaSizeClass &cls = arena->classes[header->size_class];
+    *static_cast<ArenaHeader **>(ptr) = cls.free_list;
+    cls.free_list = header;
+    cls.live--;
+    s->malloc_count--;
+    s->malloc_size -= ARENA_SIZE_CLASSES[header->size_class] + sizeof(ArenaHeader);
+}
+
+void *arenaRealloc(JSMallocState *s, void *ptr, size_t size) {
+    if (ptr == nullptr) {
+        return size == 0 ? nullptr : arenaMalloc(s, size);
+    }
+    if (size == 0) {
+        arenaFree(s, ptr);
+        return nullptr;
+    }
+    auto *header = static_cast<ArenaHeader *>(ptr) - 1;
+    if (header->size_class == ARENA_LARGE && size > ARENA_MAX_SMALL) {
+        auto *arena = static_cast<Arena *>(s->opaque);
+        ArenaLargeHeader *large = ArenaLargeHeaderOf(ptr);
+        size_t old_size = (size_t) large->size;
+        if (s->malloc_size + size - old_size > s->malloc_limit) {
+            return nullptr;
+        }
+        auto *moved = static_cast<ArenaLargeHeader *>(realloc(large, sizeof(ArenaLargeHeader) + size));
+        if (moved == nullptr) {
+            return nullptr;
+        }
+        if (moved->prev != nullptr) moved->prev->next = moved; else arena->large = moved;
+        if (moved->next != nullptr) moved->next->prev = moved;
+        moved->size = size;
+        arena->large_size += (int64_t) size - (int64_t) old_size;
+        s->malloc_size += size - old_size;
+        return moved + 1;
+    }
+    // 小对象在同一级别内原地扩缩，否则换到新的级别
+    size_t old_size = arenaUsableSize(ptr);
+    if (header->size_class != ARENA_LARGE && size <= old_size &&
+        (header->size_class == 0 || size > ARENA_SIZE_CLASSES[header->size_class - 1])) {
+        return ptr;
+    }
+    void *result = arenaMalloc(s, size);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    memcpy(result, ptr, old_size < size ? old_size : size);
+    arenaFree(s, ptr);
+    return result;
+}
+
+const JSMallocFunctions arenaMallocFunctions = {
+    arenaMalloc,
+    arenaFree,
+    arenaRealloc,
+    arenaUsableSize,
+};
+
+// JS_FreeRuntime 之后调用，整体释放所有块和尚未释放的大对象
+void DestroyArena(Arena *arena) {
+    for (char *chunk : arena->chunks) {
+        free(chunk);
+    }
+    ArenaLargeHeader *large = arena->large;
+    while (large != nullptr) {
+        ArenaLargeHeader *next = large->next;
+        free(large);
+        large = next;
+    }
+    delete arena;
+}
+
+JSRuntime *NewArenaRuntime() {
+    auto *arena = new Arena();
+    JSRuntime *rt = JS_NewRuntime2(&arenaMallocFunctions, arena);
+    if (rt == nullptr) {
+        DestroyArena(arena);
+        return nullptr;
+    }
+    GetHandleTable(rt)->arena = arena;
+    return rt;
+}
+
+JSRuntime *NewRuntime(bool arena) {
+    JSRuntime *runtime = arena ? NewArenaRuntime() : JS_NewRuntime();
+    initES6Module(runtime);
+    initCallbackClass(runtime);
+    initExecutionBudget(runtime);
+    return runtime;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_quickjs_QuickJSNativeImpl_createRuntime(JNIEnv *env, jclass clazz, jboolean arena) {
+    return reinterpret_cast<jlong>(NewRuntime(arena));
+}
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_quickjs_QuickJSNativeImpl_createContext(JNIEnv *env, jobject clzz, jlong runtime_ptr) {
+
+    auto *runtime = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    auto *ctx = JS_NewContext(runtime);
+    return reinterpret_cast<jlong>(ctx);
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_releaseRuntime(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    auto *runtime = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    Arena *arena = GetHandleTable(runtime)->arena;
+    FreeHandleTable(runtime);
+    JS_FreeRuntime(runtime);
+    if (arena != nullptr) {
+        DestroyArena(arena);
+    }
+}
+
+/*
+ * 内存池统计：每个大小级别依次为槽位大小、存活数、累计分配次数、占用的块数，
+ * 之后是大对象的存活数和字节数，以及块的总字节数。不是内存池模式时返回 null
+ */
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getArenaStats(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    auto *runtime = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    Arena *arena = GetHandleTable(runtime)->arena;
+    if (arena == nullptr) {
+        return nullptr;
+    }
+    std::vector<jlong> stats;
+    stats.reserve(ARENA_CLASS_COUNT * 4 + 3);
+    for (int i = 0; i < ARENA_CLASS_COUNT; i++) {
+        const ArenaSizeClass &cls = arena->classes[i];
+        stats.push_back((jlong) ARENA_SIZE_CLASSES[i]);
+        stats.push_back(cls.live);
+        stats.push_back(cls.allocations);
+        stats.push_back(cls.chunks);
+    }
+    stats.push_back(arena->large_count);
+    stats.push_back(arena->large_size);
+    stats.push_back((jlong) (arena->chunks.size() * ARENA_CHUNK_SIZE));
+    jlongArray result = env->NewLongArray((jsize) stats.size());
+    env->SetLongArrayRegion(result, 0, (jsize) stats.size(), stats.data());
+    return result;
+}extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_releaseContext(JNIEnv *env, jobject clazz, jlong context_ptr) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JS_FreeContext(ctx);
+}
+/*
+ * 原生事件循环：多生产者/单消费者的无锁环形队列 + 专用线程。
+ * 任意线程通过 eventLoopPost 投递 Runnable，循环线程依次执行，
+ * 同时负责定时任务和 JS_ExecutePendingJob。JSRuntime 在循环线程上创建，
+ * 保证栈溢出检测使用的是该线程的栈。
+ */
+enum EventLoopMessageType {
+    LOOP_MESSAGE_POST,
+    LOOP_MESSAGE_REMOVE,
+};
+
+struct EventLoopMessage {
+    EventLoopMessageType type;
+    jobject runnable;
+    int64_t deadline;
+};
+
+// Vyukov 有界队列，入队为无锁 CAS，出队只在循环线程进行
+class MPSCRingBuffer {
+public:
+    explicit MPSCRingBuffer(size_t capacity) : mask(capacity - 1), cells(new Cell[capacity]) {
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MPSCRingBuffer() {
+        delete[] cells;
+    }
+
+    bool offer(const EventLoopMessage &message) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->message = message;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool poll(EventLoopMessage *message) {
+        Cell *cell = &cells[dequeuePos & mask];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        if (seq != dequeuePos + 1) {
+            return false;
+        }
+        *message = cell->message;
+        cell->sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+        dequeuePos++;
+        return true;
+    }
+
+    bool isEmpty() const {
+        const Cell *cell = &cells[dequeuePos & mask];
+        return cell->sequence.load(std::memory_order_acquire) != dequeuePos + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        EventLoopMessage message;
+    };
+    const size_t mask;
+    Cell *const cells;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) size_t dequeuePos = 0;
+};
+
+const size_t EVENT_LOOP_CAPACITY = 4096;
+
+int64_t monotonicMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct EventLoop {
+    MPSCRingBuffer queue{EVENT_LOOP_CAPACITY};
+    // 循环线程自己投递而环形队列已满时暂存于此，只在循环线程访问
+    std::deque<EventLoopMessage> overflow;
+    std::multimap<int64_t, jobject> timers;
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> stopped{false};
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::thread thread;
+    std::thread::id threadId;
+    JSRuntime *runtime = nullptr;
+    bool arena = false;
+    bool ready = false;
+    // 循环线程与 Java 端 NativeEventLoop 各持有一份，最后释放的一方负责 delete
+    std::atomic<int> refs{2};
+};
+
+void unrefEventLoop(EventLoop *loop) {
+    if (loop->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete loop;
+    }
+}
+
+void stopEventLoop(EventLoop *loop) {
+    std::lock_guard<std::mutex> lock(loop->mutex);
+    loop->runtime = nullptr;
+    loop->stopped.store(true);
+    loop->cond.notify_all();
+}
+
+void wakeEventLoop(EventLoop *loop) {
+    // 与消费者设置 sleeping 后的 fence 配对，保证至少一方能看到对方的写入
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (loop->sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(loop->mutex);
+        loop->cond.notify_one();
+    }
+}
+
+bool postEventLoopMessage(EventLoop *loop, const EventLoopMessage &message) {
+    if (std::this_thread::get_id() == loop->threadId) {
+        // 循环线程是唯一的消费者，不能等待队列腾出空间；已有积压时继续排在其后以保持顺序
+        if (loop->stopped.load()) {
+            return false;
+        }
+        if (!loop->overflow.empty() || !loop->queue.offer(message)) {
+            loop->overflow.push_back(message);
+        }
+        return true;
+    }
+    while (!loop->queue.offer(message)) {
+        if (loop->stopped.load()) {
+            return false;
+        }
+        // 队列已满：唤醒消费者并让出 CPU
+        wakeEventLoop(loop);
+        sched_yield();
+    }
+    wakeEventLoop(loop);
+    return true;
+}
+
+void runEventLoopRunnable(JNIEnv *env, jobject runnable) {
+    env->CallVoidMethod(runnable, runnableRunMethodID);
+    if (env->ExceptionCheck()) {
+        LOGE("EventLoop: uncaught exception in task");
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+    env->DeleteGlobalRef(runnable);
+}
+
+void executeEventLoopPendingJobs(EventLoop *loop) {
+    if (loop->runtime == nullptr) {
+        return;
+    }
+    ExecutionBudget &budget = GetHandleTable(loop->runtime)->budget;
+    JSContext *ctx;
+    while (JS_IsJobPending(loop->runtime)) {
+        // 每个任务作为一次最外层调用，应用运行时默认预算
+        EnterBudget(budget, budget.default_timeout_ns, budget.default_ticks);
+        int ret = JS_ExecutePendingJob(loop->runtime, &ctx);
+        LeaveBudget(budget);
+        if (ret < 0) {
+            budget.exhausted = false;
+            std::string error = getJSErrorStr(ctx);
+            LOGI("EventLoop pending job: %s", error.c_str());
+            break;
+        }
+    }
+}
+
+void handleEventLoopMessage(JNIEnv *env, EventLoop *loop, const EventLoopMessage &message) {
+    switch (message.type) {
+        case LOOP_MESSAGE_POST:
+            if (message.deadline <= 0) {
+                runEventLoopRunnable(env, message.runnable);
+            } else {
+                loop->timers.emplace(message.deadline, message.runnable);
+            }
+            break;
+        case LOOP_MESSAGE_REMOVE:
+            for (auto it = loop->timers.begin(); it != loop->timers.end();) {
+                if (env->IsSameObject(it->second, message.runnable)) {
+                    env->DeleteGlobalRef(it->second);
+                    it = loop->timers.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            env->DeleteGlobalRef(message.runnable);
+            break;
+    }
+}
+
+void runEventLoop(EventLoop *loop) {
+    JNIEnv *env;
+    JavaVMAttachArgs args;
+    args.version = JNI_VERSION_1_6;
+    args.name = "QuickJS-EventLoop";
+    args.group = nullptr;
+    jvm->AttachCurrentThreadAsDaemon(&env, &args);
+
+    JSRuntime *runtime = NewRuntime(loop->arena);
+    {
+        std::lock_guard<std::mutex> lock(loop->mutex);
+        loop->runtime = runtime;
+        loop->ready = true;
+        loop->cond.notify_all();
+    }
+
+    EventLoopMessage message;
+    while (!loop->stopped.load()) {
+        while (!loop->stopped.load() && loop->queue.poll(&message)) {
+            handleEventLoopMessage(env, loop, message);
+        }
+        // 只处理本轮之前积压的消息，执行中新投递的留到下一轮
+        for (size_t n = loop->overflow.size(); n > 0 && !loop->stopped.load(); --n) {
+            message = loop->overflow.front();
+            loop->overflow.pop_front();
+            handleEventLoopMessage(env, loop, message);
+        }
+        int64_t now = monotonicMillis();
+        while (!loop->stopped.load() && !loop->timers.empty() && loop->timers.begin()->first <= now) {
+            jobject runnable = loop->timers.begin()->second;
+            loop->timers.erase(loop->timers.begin());
+            runEventLoopRunnable(env, runnable);
+        }
+        executeEventLoopPendingJobs(loop);
+        if (loop->stopped.load() || !loop->queue.isEmpty() || !loop->overflow.empty()) {
+            continue;
+        }
+
+        // 空闲：标记休眠后再次检查队列，生产者看到标记后会加锁唤醒
+        loop->sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(loop->mutex);
+            while (!loop->stopped.load() && loop->queue.isEmpty()) {
+                if (loop->timers.empty()) {
+                    loop->cond.wait(lock);
+                } else {
+                    auto deadline = std::chrono::steady_clock::time_point(
+                            std::chrono::milliseconds(loop->timers.begin()->first));
+                    if (loop->cond.wait_until(lock, deadline) == std::cv_status::timeout) {
+                        break;
+                    }
+                }
+            }
+        }
+        loop->sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    // 丢弃尚未执行的任务
+    while (loop->queue.poll(&message)) {
+        env->DeleteGlobalRef(message.runnable);
+    }
+    for (auto &pending : loop->overflow) {
+        env->DeleteGlobalRef(pending.runnable);
+    }
+    loop->overflow.clear();
+    for (auto &timer : loop->timers) {
+        env->DeleteGlobalRef(timer.second);
+    }
+    loop->timers.clear();
+    jvm->DetachCurrentThread();
+    unrefEventLoop(loop);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_quickjs_QuickJSNativeImpl_createEventLoop(JNIEnv *env, jclass clazz, jboolean arena) {
+    auto *loop = new EventLoop();
+    loop->arena = arena;
+    loop->thread = std::thread(runEventLoop, loop);
+    loop->threadId = loop->thread.get_id();
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->cond.wait(lock, [loop] { return loop->ready; });
+    return reinterpret_cast<jlong>(loop);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getEventLoopRuntime(JNIEnv *env, jclass clazz, jlong loop_ptr) {
+    auto *loop = reinterpret_cast<EventLoop *>(loop_ptr);
+    return reinterpret_cast<jlong>(loop->runtime);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_quickjs_QuickJSNativeImpl_eventLoopPost(JNIEnv *env, jclass clazz, jlong loop_ptr,
+                                                 jobject runnable, jlong delay_millis) {
+    auto *loop = reinterpret_cast<EventLoop *>(loop_ptr);
+    if (loop->stopped.load()) {
+        return JNI_FALSE;
+    }
+    EventLoopMessage message;
+    message.type = LOOP_MESSAGE_POST;
+    message.runnable = env->NewGlobalRef(runnable);
+    message.deadline = delay_millis > 0 ? monotonicMillis() + delay_millis : 0;
+    if (!postEventLoopMessage(loop, message)) {
+        env->DeleteGlobalRef(message.runnable);
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_eventLoopRemove(JNIEnv *env, jclass clazz, jlong loop_ptr,
+                                                   jobject runnable) {
+    auto *loop = reinterpret_cast<EventLoop *>(loop_ptr);
+    EventLoopMessage message;
+    message.type = LOOP_MESSAGE_REMOVE;
+    message.runnable = env->NewGlobalRef(runnable);
+    message.deadline = 0;
+    if (!postEventLoopMessage(loop, message)) {
+        env->DeleteGlobalRef(message.runnable);
+    }
+}
+
+/*
+ * 停止事件循环，JSRuntime 由调用方先行释放。只让循环线程在当前任务结束后退出，
+ * EventLoop 本身留到 eventLoopRelease 时回收
+ */
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_eventLoopQuit(JNIEnv *env, jclass clazz, jlong loop_ptr) {
+    stopEventLoop(reinterpret_cast<EventLoop *>(loop_ptr));
+}
+
+/*
+ * 释放 Java 端持有的引用，调用方保证此后不再使用 loop_ptr。尚未停止时先停止；
+ * 在循环线程内调用时无法 join，改为 detach，由线程退出时释放最后一份引用
+ */
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_eventLoopRelease(JNIEnv *env, jclass clazz, jlong loop_ptr) {
+    auto *loop = reinterpret_cast<EventLoop *>(loop_ptr);
+    stopEventLoop(loop);
+    if (std::this_thread::get_id() == loop->threadId) {
+        loop->thread.detach();
+    } else {
+        loop->thread.join();
+    }
+    unrefEventLoop(loop);
+}
+
+/*
+ * 字节码磁盘缓存：以文件名、eval 标志和源码内容的哈希为键，命中时用 JS_ReadObject
+ * 代替 JS_Eval 的解析与编译。文件头记录 CONFIG_VERSION、源码长度和字节码校验和，
+ * 任一不符或 JS_ReadObject 失败时删除该文件并重新编译。写入先落到临时文件再 rename，
+ * 多个运行时并发读写同一目录也不会读到半个文件。
+ */
+#ifndef CONFIG_VERSION
+#define CONFIG_VERSION "unknown"
+#endif
+
+const char BYTECODE_CACHE_MAGIC[4] = {'Q', 'J', 'B', 'C'};
+const uint32_t BYTECODE_CACHE_FORMAT = 1;
+
+struct BytecodeCacheHeader {
+    char magic[4];
+    uint32_t format;
+    char version[32];
+    uint64_t key;
+    uint64_t source_length;
+    uint64_t payload_length;
+    uint64_t payload_checksum;
+};
+
+std::string bytecodeCacheDir;
+std::mutex bytecodeCacheMutex;
+std::atomic<uint32_t> bytecodeCacheTempId(0);
+
+uint64_t fnv1a(const void *data, size_t length, uint64_t hash = 0xcbf29ce484222325ULL) {
+    auto *p = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string getBytecodeCacheDir() {
+    std::lock_guard<std::mutex> lock(bytecodeCacheMutex);
+    return bytecodeCacheDir;
+}
+
+void fillBytecodeCacheHeader(BytecodeCacheHeader *header, uint64_t key, size_t source_length) {
+    memset(header, 0, sizeof(BytecodeCacheHeader));
+    memcpy(header->magic, BYTECODE_CACHE_MAGIC, sizeof(header->magic));
+    header->format = BYTECODE_CACHE_FORMAT;
+    strncpy(header->version, CONFIG_VERSION, sizeof(header->version) - 1);
+    header->key = key;
+    header->source_length = source_length;
+}
+
+bool readBytecodeCache(const std::string &path, uint64_t key, size_t source_length,
+                       std::vector<uint8_t> &payload) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    BytecodeCacheHeader expected, header;
+    fillBytecodeCacheHeader(&expected, key, source_length);
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+                 && memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0
+                 && header.format == expected.format
+                 && memcmp(header.version, expected.version, sizeof(header.version)) == 0
+                 && header.key == key
+                 && header.source_length == source_length
+                 && header.payload_length > 0 && header.payload_length < (1ULL << 31);
+    if (valid) {
+        payload.resize(header.payload_length);
+        valid = fread(payload.data(), 1, payload.size(), file) == payload.size()
+                && fgetc(file) == EOF
+                && fnv1a(payload.data(), payload.size()) == header.payload_checksum;
+    }
+    fclose(file);
+    if (!valid) {
+        LOGW("bytecode cache: invalid entry %s", path.c_str());
+        unlink(path.c_str());
+    }
+    return valid;
+}
+
+void writeBytecodeCache(const std::string &path, uint64_t key, size_t source_length,
+                        const uint8_t *payload, size_t payload_length) {
+    std::string temp = path + "." + std::to_string(getpid()) + "-"
+                       + std::to_string(bytecodeCacheTempId.fetch_add(1)) + ".tmp";
+    FILE *file = fopen(temp.c_str(), "wb");
+    if (file == nullptr) {
+        return;
+    }
+    BytecodeCacheHeader header;
+    fillBytecodeCacheHeader(&header, key, source_length);
+    header.payload_length = payload_length;
+    header.payload_checksum = fnv1a(payload, payload_length);
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+              && fwrite(payload, 1, payload_length, file) == payload_length;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+        unlink(temp.c_str());
+    }
+}
+
+/*
+ * 与 JS_Eval 语义相同，未设置缓存目录时直接调用 JS_Eval
+ */
+JSValue evalWithBytecodeCache(JSContext *ctx, const char *input, size_t input_len,
+                              const char *filename, int eval_flags) {
+    std::string dir = getBytecodeCacheDir();
+    if (dir.empty() || (eval_flags & JS_EVAL_TYPE_MASK) > JS_EVAL_TYPE_MODULE) {
+        return JS_Eval(ctx, input, input_len, filename, eval_flags);
+    }
+    int compile_flags = eval_flags | JS_EVAL_FLAG_COMPILE_ONLY;
+    uint64_t key = fnv1a(filename, strlen(filename) + 1);
+    key = fnv1a(&compile_flags, sizeof(compile_flags), key);
+    key = fnv1a(input, input_len, key);
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.qjbc", (unsigned long long) key);
+    std::string path = dir + name;
+
+    JSValue func = JS_UNDEFINED;
+    std::vector<uint8_t> payload;
+    if (readBytecodeCache(path, key, input_len, payload)) {
+        func = JS_ReadObject(ctx, payload.data(), payload.size(), JS_READ_OBJ_BYTECODE);
+        if (JS_IsException(func)) {
+            LOGW("bytecode cache: failed to load %s", path.c_str());
+            JS_FreeValue(ctx, JS_GetException(ctx));
+            unlink(path.c_str());
+            func = JS_UNDEFINED;
+        }
+    }
+    if (JS_IsUndefined(func)) {
+        func = JS_Eval(ctx, input, input_len, filename, compile_flags);
+        if (JS_IsException(func)) {
+            return func;
+        }
+        size_t size;
+        uint8_t *buf = JS_WriteObject(ctx, &size, func, JS_WRITE_OBJ_BYTECODE);
+        if (buf != nullptr) {
+            writeBytecodeCache(path, key, input_len, buf, size);
+            js_free(ctx, buf);
+        } else {
+            JS_FreeValue(ctx, JS_GetException(ctx));
+        }
+    }
+    if (eval_flags & JS_EVAL_FLAG_COMPILE_ONLY) {
+        return func;
+    }
+    // 从缓存读出的模块尚未解析依赖，对已解析的模块重复调用不会有副作用
+    if (JS_VALUE_GET_TAG(func) == JS_TAG_MODULE && JS_ResolveModule(ctx, func) < 0) {
+        JS_FreeValue(ctx, func);
+        return JS_EXCEPTION;
+    }
+    return JS_EvalFunction(ctx, func);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_setBytecodeCacheDir(JNIEnv *env, jclass clazz, jstring path) {
+    std::lock_guard<std::mutex> lock(bytecodeCacheMutex);
+    if (path == nullptr) {
+        bytecodeCacheDir.clear();
+        return;
+    }
+    const char *path_ = env->GetStringUTFChars(path, JNI_FALSE);
+    bytecodeCacheDir = path_;
+    env->ReleaseStringUTFChars(path, path_);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_executeScript(JNIEnv *env, jobject clazz,jlong context_ptr,
+                                                   jint expected_type,
+                                                   jstring source, jstring file_name,jint eval_flags) {
+    if (source == nullptr) {
+        return nullptr;
+    }
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    BudgetScope budget_scope(ctx);
+
+    JSRuntime *rt = JS_GetRuntime(ctx);
+    const char *file_name_;
+    if (file_name == nullptr) {
+        file_name_ = "";
+    } else {
+        file_name_ = env->GetStringUTFChars(file_name, JNI_FALSE);
+    }
+    const char *source_ = env->GetStringUTFChars(source, JNI_FALSE);
+    const int source_length = env->GetStringUTFLength(source);
+    JSValue val = evalWithBytecodeCache(ctx, source_, (size_t) source_length, file_name_, eval_flags);
+    // 之后的各个返回路径都不再需要源码和文件名
+    env->ReleaseStringUTFChars(source, source_);
+    if (file_name != nullptr) env->ReleaseStringUTFChars(file_name, file_name_);
+    if(JS_IsException(val)) {
+        if (ThrowIfBudgetExhausted(env, ctx)) {
+            JS_FreeValue(ctx, JS_GetException(ctx));
+            return nullptr;
+        }
+        std::string error = getJSErrorStr(ctx);
+        LOGE("executeScript: %s", error.c_str());
+//        env->ThrowNew(env->FindClass("com/quickjs/QuickJSException"), error.c_str());
+        return TO_JAVA_OBJECT(env, ctx, JS_Throw(ctx, val));
+    }
+    if (!executePendingJobLoop(env, rt, ctx)) {
+        LOGE("executeScript: exce job error");
+        return TO_JAVA_OBJECT(env, ctx, JS_Throw(ctx, val));
+    }
+
+    jobject result = To_JObject(env, context_ptr, expected_type, val);
+    return result;
+}
+
+// 编译脚本并序列化为字节码，字节码与上下文无关，可在同一版本引擎的任意上下文中执行
+extern "C"
+JNIEXPORT jbyteArray JNICALL
+Java_com_quickjs_QuickJSNativeImpl_compileScript(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                                 jstring source, jstring file_name, jint eval_flags) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    const char *file_name_ = env->GetStringUTFChars(file_name, JNI_FALSE);
+    const char *source_ = env->GetStringUTFChars(source, JNI_FALSE);
+    const int source_length = env->GetStringUTFLength(source);
+    JSValue func = JS_Eval(ctx, source_, (size_t) source_length, file_name_,
+                           eval_flags | JS_EVAL_FLAG_COMPILE_ONLY);
+    env->ReleaseStringUTFChars(source, source_);
+    env->ReleaseStringUTFChars(file_name, file_name_);
+    if (JS_IsException(func)) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    size_t size;
+    uint8_t *buf = JS_WriteObject(ctx, &size, func, JS_WRITE_OBJ_BYTECODE);
+    JS_FreeValue(ctx, func);
+    if (buf == nullptr) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    jbyteArray result = env->NewByteArray((jsize) size);
+    env->SetByteArrayRegion(result, 0, (jsize) size, reinterpret_cast<const jbyte *>(buf));
+    js_free(ctx, buf);
+    return result;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_executeBytecode(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                                   jint expected_type, jbyteArray bytecode) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    BudgetScope budget_scope(ctx);
+    JSRuntime *rt = JS_GetRuntime(ctx);
+    jsize size = env->GetArrayLength(bytecode);
+    jbyte *buf = env->GetByteArrayElements(bytecode, nullptr);
+    JSValue func = JS_ReadObject(ctx, reinterpret_cast<const uint8_t *>(buf), (size_t) size,
+                                 JS_READ_OBJ_BYTECODE);
+    env->ReleaseByteArrayElements(bytecode, buf, JNI_ABORT);
+    if (JS_IsException(func)) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    if (JS_VALUE_GET_TAG(func) == JS_TAG_MODULE && JS_ResolveModule(ctx, func) < 0) {
+        JS_FreeValue(ctx, func);
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    JSValue val = JS_EvalFunction(ctx, func);
+    if (JS_IsException(val)) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    if (!executePendingJobLoop(env, rt, ctx)) {
+        JS_FreeValue(ctx, val);
+        LOGE("executeBytecode: exce job error");
+        return nullptr;
+    }
+    return To_JObject(env, context_ptr, expected_type, val);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getGlobalObject(JNIEnv *env, jobject clazz, jlong context_ptr) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue global_obj = JS_GetGlobalObject(ctx);
+    return TO_JAVA_OBJECT(env, ctx, global_obj);
+}
+
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_initNewJSObject(JNIEnv *env, jobject clazz, jlong context_ptr) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue jsValue = JS_NewObject(ctx);
+    return TO_JAVA_OBJECT(env, ctx, jsValue);
+}
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_initNewJSArray(JNIEnv *env, jobject clazz, jlong context_ptr) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
     JSValue jsValue = JS_NewArray(ctx);
     return TO_JAVA_OBJECT(env, ctx, jsValue);
 }
 
+int ToTypedArrayEnum(int type) {
+    switch (type) {
+        case TYPE_INT_8_ARRAY:
+            return JS_TYPED_ARRAY_INT8;
+        case TYPE_UNSIGNED_INT_8_ARRAY:
+            return JS_TYPED_ARRAY_UINT8;
+        case TYPE_UNSIGNED_INT_8_CLAMPED_ARRAY:
+            return JS_TYPED_ARRAY_UINT8C;
+        case TYPE_INT_16_ARRAY:
+            return JS_TYPED_ARRAY_INT16;
+        case TYPE_UNSIGNED_INT_16_ARRAY:
+            return JS_TYPED_ARRAY_UINT16;
+        case TYPE_INT_32_ARRAY:
+            return JS_TYPED_ARRAY_INT32;
+        case TYPE_UNSIGNED_INT_32_ARRAY:
+            return JS_TYPED_ARRAY_UINT32;
+        case TYPE_FLOAT_32_ARRAY:
+            return JS_TYPED_ARRAY_FLOAT32;
+        case TYPE_FLOAT_64_ARRAY:
+            return JS_TYPED_ARRAY_FLOAT64;
+        default:
+            return -1;
+    }
+}
+
+// ArrayBuffer 被 GC 时释放对 ByteBuffer 的全局引用，内存本身归 Java 管理
+void freeDirectByteBuffer(JSRuntime *rt, void *opaque, void *ptr) {
+    JNIEnv *env;
+    if (jvm->GetEnv((void **) &env, JNI_VERSION_1_6) != JNI_OK) {
+        LOGE("freeDirectByteBuffer: current thread is not attached");
+        return;
+    }
+    env->DeleteGlobalRef(static_cast<jobject>(opaque));
+}
+
+// 以零拷贝方式把 direct ByteBuffer 包装为 ArrayBuffer
+JSValue NewArrayBufferFromDirectBuffer(JNIEnv *env, JSContext *ctx, jobject buffer) {
+    auto *data = static_cast<uint8_t *>(env->GetDirectBufferAddress(buffer));
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (data == nullptr || capacity < 0) {
+        return JS_ThrowTypeError(ctx, "ByteBuffer must be a direct buffer");
+    }
+    jobject ref = env->NewGlobalRef(buffer);
+    return JS_NewArrayBuffer(ctx, data, (size_t) capacity, freeDirectByteBuffer, ref, FALSE);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_newArrayBuffer(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                                  jobject buffer) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue value = NewArrayBufferFromDirectBuffer(env, ctx, buffer);
+    if (JS_IsException(value)) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    return TO_JAVA_OBJECT(env, ctx, value);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_newTypedArray(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                                 jint type, jobject buffer) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    int array_type = ToTypedArrayEnum(type);
+    if (array_type < 0) {
+        throwJSException(env, "Unsupported typed array type");
+        return nullptr;
+    }
+    JSValue array_buffer = NewArrayBufferFromDirectBuffer(env, ctx, buffer);
+    if (JS_IsException(array_buffer)) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    // 以 ArrayBuffer 为参数构造 TypedArray 只创建视图，不复制数据
+    JSValue value = JS_NewTypedArray(ctx, 1, &array_buffer, (JSTypedArrayEnum) array_type);
+    JS_FreeValue(ctx, array_buffer);
+    if (JS_IsException(value)) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    return TO_JAVA_OBJECT(env, ctx, value);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getArrayBuffer(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                                  jobject object_handle) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue value = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    size_t offset = 0;
+    size_t length;
+    uint8_t *data;
+    if (JS_IsArrayBuffer(value)) {
+        data = JS_GetArrayBuffer(ctx, &length, value);
+    } else if (JS_GetTypedArrayType(value) >= 0) {
+        size_t byte_length;
+        JSValue array_buffer = JS_GetTypedArrayBuffer(ctx, value, &offset, &byte_length, nullptr);
+        if (JS_IsException(array_buffer)) {
+            throwJSException(env, ctx);
+            return nullptr;
+        }
+        data = JS_GetArrayBuffer(ctx, &length, array_buffer);
+        JS_FreeValue(ctx, array_buffer);
+        length = byte_length;
+    } else {
+        return nullptr;
+    }
+    if (data == nullptr) {
+        // 已 detach 的 ArrayBuffer
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    return env->NewDirectByteBuffer(data + offset, (jlong) length);
+}
+
 extern "C"
 JNIEXPORT void JNICALL
 Java_com_quickjs_QuickJSNativeImpl_releasePtr(JNIEnv *env, jobject clazz, jlong context_ptr,
-                                                jlong tag,
-                                                jint u_int32, jdouble u_float64, jlong u_ptr) {
+                                                jlong handle) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    if (!FreeHandle(JS_GetRuntime(ctx), handle)) {
+        LOGW("releasePtr: handle %llx already released", (unsigned long long) handle);
+    }
+}
 
-    JSValue value;
-#if defined(JS_NAN_BOXING)
-    value = tag;
-#else
-    value.tag = tag;
-    value.u.int32 = u_int32;
-    value.u.float64 = u_float64;
-    value.u.ptr = (void *) u_ptr;
-#endif
+const char *HandleTypeName(int type) {
+    switch (type) {
+        case TYPE_JS_ARRAY:
+            return "JSArray";
+        case TYPE_JS_OBJECT:
+            return "JSObject";
+        case TYPE_JS_FUNCTION:
+            return "JSFunction";
+        case TYPE_UNDEFINED:
+            return "Undefined";
+        default:
+            return "JSValue";
+    }
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_toJava(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                          jobject object_handle, jint depth_limit) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue value = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    GraphConversion c{env, ctx, depth_limit};
+    jobject result = JSGraphToJava(c, value, 0);
+    if (env->ExceptionCheck()) {
+        env->DeleteLocalRef(result);
+        return nullptr;
+    }
+    return result;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_fromJava(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                            jobject value, jint depth_limit) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    GraphConversion c{env, ctx, depth_limit};
+    JSValue result = JavaGraphToJS(c, value, 0);
+    if (JS_IsException(result)) {
+        return nullptr;
+    }
+    return To_JObject(env, context_ptr, TYPE_UNKNOWN, result);
+}
+
+// 上下文中尚未释放的句柄数量
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getHandleCount(JNIEnv *env, jobject clazz, jlong context_ptr) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    HandleTable *table = GetHandleTable(JS_GetRuntime(ctx));
+    jint count = 0;
+    for (const HandleSlot &slot : table->slots) {
+        if (slot.used && slot.ctx == ctx) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// 按创建位置和类型汇总上下文中尚未释放的句柄，每项形如 "executeScript JSObject x3"
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_quickjs_QuickJSNativeImpl_dumpLeaks(JNIEnv *env, jobject clazz, jlong context_ptr) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JS_FreeValue(ctx, value);
+    HandleTable *table = GetHandleTable(JS_GetRuntime(ctx));
+    static const char prefix[] = "Java_com_quickjs_QuickJSNativeImpl_";
+    std::map<std::string, int> groups;
+    for (const HandleSlot &slot : table->slots) {
+        if (!slot.used || slot.ctx != ctx) {
+            continue;
+        }
+        std::string site = slot.site != nullptr ? slot.site : "unknown";
+        if (site.compare(0, sizeof(prefix) - 1, prefix) == 0) {
+            site.erase(0, sizeof(prefix) - 1);
+        }
+        groups[site + " " + HandleTypeName(slot.type)]++;
+    }
+    jobjectArray report = env->NewObjectArray((jsize) groups.size(), stringCls, nullptr);
+    jsize i = 0;
+    for (const auto &group : groups) {
+        std::string line = group.first + " x" + std::to_string(group.second);
+        jstring item = env->NewStringUTF(line.c_str());
+        env->SetObjectArrayElement(report, i++, item);
+        env->DeleteLocalRef(item);
+    }
+    return report;
+}
+
+JSAtom NewAtomFromJString(JNIEnv *env, JSContext *ctx, jstring key) {
+    const char *key_ = env->GetStringUTFChars(key, nullptr);
+    JSAtom atom = JS_NewAtomLen(ctx, key_, env->GetStringUTFLength(key));
+    env->ReleaseStringUTFChars(key, key_);
+    return atom;
 }
 
 extern "C"
@@ -673,10 +2629,12 @@ JNIEXPORT jobject JNICALL
 Java_com_quickjs_QuickJSNativeImpl_get(JNIEnv *env, jobject clazz, jlong context_ptr,
                                          int expected_type,
                                          jobject object_handle, jstring key) {
-    const char *key_ = env->GetStringUTFChars(key, nullptr);
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    const char *key_ = env->GetStringUTFChars(key, nullptr);
     JSValue result = JS_GetPropertyStr(ctx, this_obj, key_);
+    env->ReleaseStringUTFChars(key, key_);
     jobject tmp = To_JObject(env, context_ptr, expected_type, result);
 //    JS_FreeValue(ctx, result);
     return tmp;
@@ -685,14 +2643,137 @@ extern "C"
 JNIEXPORT jobject JNICALL
 Java_com_quickjs_QuickJSNativeImpl_getValue(JNIEnv *env, jobject clazz, jlong context_ptr,
                                               jobject object_handle, jstring key) {
-    const char *key_ = env->GetStringUTFChars(key, nullptr);
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    const char *key_ = env->GetStringUTFChars(key, nullptr);
     JSValue result = JS_GetPropertyStr(ctx, this_obj, key_);
+    env->ReleaseStringUTFChars(key, key_);
     return TO_JAVA_OBJECT(env, ctx, result);
 }
 
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_quickjs_QuickJSNativeImpl_newAtom(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                           jstring key) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    return (jint) NewAtomFromJString(env, ctx, key);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_freeAtom(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                            jint atom) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JS_FreeAtom(ctx, (JSAtom) atom);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getAtom(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                           jint expected_type, jobject object_handle, jint atom) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    JSValue result = JS_GetProperty(ctx, this_obj, (JSAtom) atom);
+    return To_JObject(env, context_ptr, expected_type, result);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_setAtom(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                           jobject object_handle, jint atom, jobject value) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return;
+    JS_SetProperty(ctx, this_obj, (JSAtom) atom, JobjectToJSValue(env, ctx, value));
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_quickjs_QuickJSNativeImpl_containsAtom(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                                jobject object_handle, jint atom) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return JNI_FALSE;
+    return JS_HasProperty(ctx, this_obj, (JSAtom) atom) > 0;
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getManyAtoms(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                                jobject object_handle, jintArray atoms) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    jsize len = env->GetArrayLength(atoms);
+    std::vector<jint> atoms_(len);
+    env->GetIntArrayRegion(atoms, 0, len, atoms_.data());
+    jobjectArray values = env->NewObjectArray(len, objectCls, nullptr);
+    for (jsize i = 0; i < len; ++i) {
+        JSValue result = JS_GetProperty(ctx, this_obj, (JSAtom) atoms_[i]);
+        if (JS_IsException(result)) {
+            throwJSException(env, ctx);
+            return nullptr;
+        }
+        jobject value = To_JObject(env, context_ptr, TYPE_UNKNOWN, result);
+        env->SetObjectArrayElement(values, i, value);
+        env->DeleteLocalRef(value);
+    }
+    return values;
+}
+
+
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getMany(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                           jobject object_handle, jobjectArray keys) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    jsize len = env->GetArrayLength(keys);
+    jobjectArray values = env->NewObjectArray(len, objectCls, nullptr);
+    for (jsize i = 0; i < len; ++i) {
+        auto key = (jstring) env->GetObjectArrayElement(keys, i);
+        JSAtom atom = NewAtomFromJString(env, ctx, key);
+        JSValue result = JS_GetProperty(ctx, this_obj, atom);
+        JS_FreeAtom(ctx, atom);
+        env->DeleteLocalRef(key);
+        if (JS_IsException(result)) {
+            throwJSException(env, ctx);
+            return nullptr;
+        }
+        jobject value = To_JObject(env, context_ptr, TYPE_UNKNOWN, result);
+        env->SetObjectArrayElement(values, i, value);
+        env->DeleteLocalRef(value);
+    }
+    return values;
+}
 
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_setMany(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                           jobject object_handle, jobjectArray keys,
+                                           jobjectArray values) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return;
+    jsize len = env->GetArrayLength(keys);
+    for (jsize i = 0; i < len; ++i) {
+        auto key = (jstring) env->GetObjectArrayElement(keys, i);
+        jobject value = env->GetObjectArrayElement(values, i);
+        JSAtom atom = NewAtomFromJString(env, ctx, key);
+        int ret = JS_SetProperty(ctx, this_obj, atom, JobjectToJSValue(env, ctx, value));
+        JS_FreeAtom(ctx, atom);
+        env->DeleteLocalRef(key);
+        env->DeleteLocalRef(value);
+        if (ret < 0) {
+            throwJSException(env, ctx);
+            return;
+        }
+    }
+}
 
 extern "C"
 JNIEXPORT jobject JNICALL
@@ -700,7 +2781,8 @@ Java_com_quickjs_QuickJSNativeImpl_arrayGet(JNIEnv *env, jobject clazz, jlong co
                                               int expected_type,
                                               jobject object_handle, jint index) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
     JSValue result = JS_GetPropertyUint32(ctx, this_obj, index);
     jobject jo = To_JObject(env, context_ptr, expected_type, result);
 //    JS_FreeValue(ctx, result);
@@ -712,7 +2794,8 @@ JNIEXPORT jobject JNICALL
 Java_com_quickjs_QuickJSNativeImpl_arrayGetValue(JNIEnv *env, jobject clazz, jlong context_ptr,
                                                    jobject object_handle, jint index) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
     JSValue result = JS_GetPropertyUint32(ctx, this_obj, index);
     return TO_JAVA_OBJECT(env, ctx, result);
 }
@@ -722,9 +2805,9 @@ JNIEXPORT jboolean JNICALL
 Java_com_quickjs_QuickJSNativeImpl_contains(JNIEnv *env, jobject clazz, jlong context_ptr,
                                               jobject object_handle, jstring key) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
-    const char *key_ = env->GetStringUTFChars(key, nullptr);
-    JSAtom atom = JS_NewAtom(ctx, key_);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return JNI_FALSE;
+    JSAtom atom = NewAtomFromJString(env, ctx, key);
     int result = JS_HasProperty(ctx, this_obj, atom);
     JS_FreeAtom(ctx, atom);
     return result;
@@ -735,28 +2818,38 @@ JNIEXPORT jobjectArray JNICALL
 Java_com_quickjs_QuickJSNativeImpl_getKeys(JNIEnv *env, jobject clazz, jlong context_ptr,
                                              jobject object_handle) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
     JSPropertyEnum *tab;
     uint32_t len;
     JS_GetOwnPropertyNames(ctx, &tab, &len, this_obj, JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY);
     jobjectArray stringArray = env->NewObjectArray(len, stringCls, nullptr);
     for (int i = 0; i < len; ++i) {
-        jstring key = env->NewStringUTF(JS_AtomToCString(ctx, tab[i].atom));
+        JSValue name = JS_AtomToString(ctx, tab[i].atom);
+        jstring key = JSStringToJString(env, ctx, name);
+        JS_FreeValue(ctx, name);
         env->SetObjectArrayElement(stringArray, i, key);
+        env->DeleteLocalRef(key);
     }
+    JS_FreePropertyEnum(ctx, tab, len);
     return stringArray;
 }
 
 JSValue executeFunction(JNIEnv *env, jlong context_ptr, jobject object_handle, JSValue func,
                         jobjectArray args) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
+    BudgetScope budget_scope(ctx);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) {
+        JS_FreeValue(ctx, func);
+        return JS_UNDEFINED;
+    }
 
     JSValue *argv = nullptr;
     int argc = 0;
     if (args != nullptr) {
         // old parameters_handle is JSValue
-//        JSValue argArray = TO_JS_VALUE(env, parameters_handle);
+//        JSValue argArray = TO_JS_VALUE(env, ctx, parameters_handle);
 
         argc = env->GetArrayLength(args);
         argv = new JSValue[argc];
@@ -765,18 +2858,28 @@ JSValue executeFunction(JNIEnv *env, jlong context_ptr, jobject object_handle, J
             argv[i] = JavaToJSValue(ctx, env, ele);
         }
     }
+    // 参数中有已释放的 JSValue
+    if (env->ExceptionCheck()) {
+        for (int i = 0; i < argc; ++i) {
+            JS_FreeValue(ctx, argv[i]);
+        }
+        delete[] argv;
+        JS_FreeValue(ctx, func);
+        return JS_UNDEFINED;
+    }
     JSValue global = JS_GetGlobalObject(ctx);
 
     if (JS_Equals(this_obj, global)) {
         this_obj = JS_UNDEFINED;
     }
     JSValue result = JS_Call(ctx, func, this_obj, argc, argv);
-//    JS_FreeValue(ctx, func);
+    JS_FreeValue(ctx, func);
     JS_FreeValue(ctx, global);
     if (argv != nullptr) {
         for (int i = 0; i < argc; ++i) {
             JS_FreeValue(ctx, argv[i]);
         }
+        delete[] argv;
     }
 //    JS_FreeValue(ctx, result);
     return result;
@@ -790,9 +2893,11 @@ Java_com_quickjs_QuickJSNativeImpl_executeFunction2(JNIEnv *env, jobject clazz,
                                                       jobject functionHandle,
                                                       jobjectArray args) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue func_obj = TO_JS_VALUE(env, functionHandle);
+    JSValue func_obj = TO_JS_VALUE(env, ctx, functionHandle);
+    if (env->ExceptionCheck()) return nullptr;
     JS_DupValue(ctx, func_obj);
     JSValue value = executeFunction(env, context_ptr, object_handle, func_obj, args);
+    if (env->ExceptionCheck()) return nullptr;
     jobject result = To_JObject(env, context_ptr, expected_type, value);
     return result;
 }
@@ -804,11 +2909,148 @@ Java_com_quickjs_QuickJSNativeImpl_executeFunction(JNIEnv *env, jobject clazz, j
                                                      jint expected_type, jobject object_handle,
                                                      jstring name, jobjectArray args) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
-    JSValue func_obj = JS_GetPropertyStr(ctx, this_obj, env->GetStringUTFChars(name, nullptr));
-    JSValue value = executeFunction(env, context_ptr, object_handle, func_obj, args);
-    jobject result = To_JObject(env, context_ptr, expected_type, value);
-    return result;
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    const char *name_ = env->GetStringUTFChars(name, nullptr);
+    JSValue func_obj = JS_GetPropertyStr(ctx, this_obj, name_);
+    env->ReleaseStringUTFChars(name, name_);
+    JSValue value = executeFunction(env, context_ptr, object_handle, func_obj, args);
+    if (env->ExceptionCheck()) return nullptr;
+    jobject result = To_JObject(env, context_ptr, expected_type, value);
+    return result;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_executeFunctionAtom(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                                       jint expected_type, jobject object_handle,
+                                                       jint atom, jobjectArray args) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    JSValue func_obj = JS_GetProperty(ctx, this_obj, (JSAtom) atom);
+    JSValue value = executeFunction(env, context_ptr, object_handle, func_obj, args);
+    if (env->ExceptionCheck()) return nullptr;
+    jobject result = To_JObject(env, context_ptr, expected_type, value);
+    return result;
+}
+
+/*
+ * 类型化调用：参数与返回值都是基本类型，直接按句柄取函数和 this，
+ * 不经过 Object[] 装箱、JavaToJSValue 的类型判断和结果的包装对象。
+ * this_handle 为 0 表示 undefined；JS 抛出的异常直接转为 QuickJSException。
+ */
+JSValue CallByHandle(JNIEnv *env, JSContext *ctx, jlong this_handle, jlong func_handle,
+                     int argc, JSValue *argv) {
+    BudgetScope budget_scope(ctx);
+    JSValue func = HANDLE_TO_JS_VALUE(env, ctx, func_handle);
+    JSValue this_obj = HANDLE_TO_JS_VALUE(env, ctx, this_handle);
+    if (env->ExceptionCheck()) {
+        return JS_EXCEPTION;
+    }
+    JSValue result = JS_Call(ctx, func, this_obj, argc, argv);
+    if (JS_IsException(result)) {
+        throwJSException(env, ctx);
+    }
+    return result;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_quickjs_QuickJSNativeImpl_callII(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                          jlong this_handle, jlong func_handle, jint a, jint b) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue argv[] = {JS_NewInt32(ctx, a), JS_NewInt32(ctx, b)};
+    JSValue result = CallByHandle(env, ctx, this_handle, func_handle, 2, argv);
+    if (JS_IsException(result)) {
+        return 0;
+    }
+    int32_t ret = 0;
+    if (JS_VALUE_GET_TAG(result) == JS_TAG_INT) {
+        ret = JS_VALUE_GET_INT(result);
+    } else if (JS_ToInt32(ctx, &ret, result)) {
+        throwJSException(env, ctx);
+    }
+    JS_FreeValue(ctx, result);
+    return ret;
+}
+
+extern "C"
+JNIEXPORT jdouble JNICALL
+Java_com_quickjs_QuickJSNativeImpl_callDD(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                          jlong this_handle, jlong func_handle, jdouble a, jdouble b) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue argv[] = {JS_NewFloat64(ctx, a), JS_NewFloat64(ctx, b)};
+    JSValue result = CallByHandle(env, ctx, this_handle, func_handle, 2, argv);
+    if (JS_IsException(result)) {
+        return 0;
+    }
+    double ret = 0;
+    if (JS_ToFloat64(ctx, &ret, result)) {
+        throwJSException(env, ctx);
+    }
+    JS_FreeValue(ctx, result);
+    return ret;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_quickjs_QuickJSNativeImpl_callLL(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                          jlong this_handle, jlong func_handle, jlong a, jlong b) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    // JS number 只能精确表示 53 位整数，超出范围的参数按 double 舍入
+    JSValue argv[] = {JS_NewInt64(ctx, a), JS_NewInt64(ctx, b)};
+    JSValue result = CallByHandle(env, ctx, this_handle, func_handle, 2, argv);
+    if (JS_IsException(result)) {
+        return 0;
+    }
+    int64_t ret = 0;
+    if (JS_ToInt64(ctx, &ret, result)) {
+        throwJSException(env, ctx);
+    }
+    JS_FreeValue(ctx, result);
+    return ret;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_callVoid(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                            jlong this_handle, jlong func_handle) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue result = CallByHandle(env, ctx, this_handle, func_handle, 0, nullptr);
+    JS_FreeValue(ctx, result);
+}
+
+extern "C"
+JNIEXPORT jdouble JNICALL
+Java_com_quickjs_QuickJSNativeImpl_callDoubles(JNIEnv *env, jobject clazz, jlong context_ptr,
+                                               jlong this_handle, jlong func_handle,
+                                               jdoubleArray args) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    jsize argc = env->GetArrayLength(args);
+    // 常见的短参数列表放在栈上
+    JSValue stack_argv[8];
+    std::vector<JSValue> heap_argv;
+    JSValue *argv = stack_argv;
+    if (argc > 8) {
+        heap_argv.resize(argc);
+        argv = heap_argv.data();
+    }
+    auto *values = (jdouble *) env->GetPrimitiveArrayCritical(args, nullptr);
+    for (jsize i = 0; i < argc; ++i) {
+        argv[i] = JS_NewFloat64(ctx, values[i]);
+    }
+    env->ReleasePrimitiveArrayCritical(args, values, JNI_ABORT);
+    JSValue result = CallByHandle(env, ctx, this_handle, func_handle, argc, argv);
+    if (JS_IsException(result)) {
+        return 0;
+    }
+    double ret = 0;
+    if (JS_ToFloat64(ctx, &ret, result)) {
+        throwJSException(env, ctx);
+    }
+    JS_FreeValue(ctx, result);
+    return ret;
 }
 
 JSValue createJSException(JSContext *ctx, const char *errmsg) {
@@ -818,79 +3060,163 @@ JSValue createJSException(JSContext *ctx, const char *errmsg) {
     return JS_Throw(ctx, err);
 }
 
-JSValue
-callJavaCallback(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv, int magic, JSValue *func_data) {
-    JNIEnv *env;
-    jvm->GetEnv((void **) &env, JNI_VERSION_1_6);
-    int callbackId = JS_VALUE_GET_INT(func_data[0]);
-    bool void_method = JS_VALUE_GET_BOOL(func_data[1]);
-    auto context_ptr = (jlong) ctx;
+// 把挂起的 Java 异常转为 JS 异常
+JSValue JavaExceptionToJS(JNIEnv *env, JSContext *ctx) {
+    // 获取异常对象
+    jthrowable exc = env->ExceptionOccurred();
+    env->ExceptionClear(); // 清除 JVM 异常状态
+
+    // 调用 toString，方法 ID 已在 JNI_OnLoad 中缓存
+    auto msgStr = (jstring)env->CallObjectMethod(exc, objectToStringMethodID);
+
+    // 获取字符串内容
+    const char *errmsg = env->GetStringUTFChars(msgStr, nullptr);
 
+    // 用异常信息抛出 JS 异常
+    JSValue js_exc = createJSException(ctx, errmsg);
+
+    // 释放本地引用
+    env->ReleaseStringUTFChars(msgStr, errmsg);
+    env->DeleteLocalRef(msgStr);
+    env->DeleteLocalRef(exc);
+
+    return js_exc;
+}
+
+// 参数转换为 Java 对象后直接调用 JavaCallback.invoke(receiver, args)
+JSValue InvokeJavaCallback(JNIEnv *env, JSContext *ctx, jobject callback, JSValueConst this_val,
+                           int argc, JSValueConst *argv) {
+    if (callback == nullptr) {
+        return createJSException(ctx, "Java callback has been released");
+    }
     jobjectArray args = env->NewObjectArray(argc, objectCls, nullptr);
     if (argv != nullptr) {
         for (int i = 0; i < argc; i++) {
-            JSValue it = argv[i];
-            JS_DupValue(ctx, it);
-            jobject obj = JSValueToJava(ctx, env, it);
+            jobject obj = JSValueToJava(ctx, env, JS_DupValue(ctx, argv[i]));
             env->SetObjectArrayElement(args, i, obj);
+            env->DeleteLocalRef(obj);
         }
     }
-    jobject objectHandle = TO_JAVA_OBJECT(env, ctx, this_val);
-//    jobject argsHandle = TO_JAVA_OBJECT(env, ctx, args);
-    JSValue global = JS_GetGlobalObject(ctx);
-    if (!JS_Equals(global, this_val)) {
-        JS_DupValue(ctx, this_val);
+    // receiver 的类型是 JSObject?，基本类型的 this 传 null；句柄表持有引用，this 包括全局对象都需要 Dup
+    jobject receiver = nullptr;
+    if (JS_IsObject(this_val) || JS_IsUndefined(this_val)) {
+        receiver = TO_JAVA_OBJECT(env, ctx, JS_DupValue(ctx, this_val));
     }
-    JS_FreeValue(ctx, global);
-    jobject result = env->CallStaticObjectMethod(quickJSCls, callJavaCallbackMethodID,
-                                                 context_ptr,
-                                                 callbackId,
-                                                 objectHandle,
-                                                 args
-    );
+    jobject result = env->CallObjectMethod(callback, javaCallbackInvokeMethodID, receiver, args);
+    env->DeleteLocalRef(args);
+    env->DeleteLocalRef(receiver);
 
     if (env->ExceptionCheck()) {
-        // 获取异常对象
-        jthrowable exc = env->ExceptionOccurred();
-        env->ExceptionClear(); // 清除 JVM 异常状态
+        return JavaExceptionToJS(env, ctx);
+    }
 
-        // 获取异常类
-        jclass excClass = env->GetObjectClass(exc);
-        // 获取 toString 方法
-        jmethodID toStringID = env->GetMethodID(excClass, "toString", "()Ljava/lang/String;");
-        auto msgStr = (jstring)env->CallObjectMethod(exc, toStringID);
+    JSValue value = JobjectToJSValue(env, ctx, result);
+    env->DeleteLocalRef(result);
+    return value;
+}
 
-        // 获取字符串内容
-        const char *errmsg = env->GetStringUTFChars(msgStr, nullptr);
+JSValue
+callJavaCallback(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv, int magic, JSValue *func_data) {
+    JNIEnv *env;
+    jvm->GetEnv((void **) &env, JNI_VERSION_1_6);
+    return InvokeJavaCallback(env, ctx, GetCallback(ctx, func_data[0]), this_val, argc, argv);
+}
 
-        // 用异常信息抛出 JS 异常
-        JSValue js_exc = createJSException(ctx, errmsg);
+JSValue newFunction(JNIEnv *env, JSContext *ctx, jobject callback) {
+    JSValue holder = NewCallbackHolder(env, ctx, callback);
+    JSValue func = JS_NewCFunctionData(ctx, callJavaCallback, 1, 0, 1, &holder);
+    JS_FreeValue(ctx, holder);
+    return func;
+}
 
-        // 释放本地引用
-        env->ReleaseStringUTFChars(msgStr, errmsg);
-        env->DeleteLocalRef(msgStr);
-        env->DeleteLocalRef(excClass);
-        env->DeleteLocalRef(exc);
+/*
+ * 基本类型签名的 Java 回调：回调对象的全局引用保存在一个 JS 对象的 opaque 中，作为函数的 func_data，
+ * 函数被回收时由 finalizer 释放全局引用。调用时直接用缓存的 jmethodID 调用接口方法，
+ * 不分配 Object[]、不装箱，也不经过 QuickJS.callJavaCallback 的注册表查找。
+ */
+const int TYPED_CALLBACK_DOUBLE_UNARY = 0;
+const int TYPED_CALLBACK_DOUBLE_BINARY = 1;
+const int TYPED_CALLBACK_INT_BINARY = 2;
+const int TYPED_CALLBACK_STRING = 3;
 
-        return js_exc;
-    }
+// 缺省参数按 undefined 处理，即 NaN / 0；转换抛出异常时返回 -1
+int ArgToFloat64(JSContext *ctx, double *d, int argc, JSValueConst *argv, int i) {
+    return JS_ToFloat64(ctx, d, i < argc ? argv[i] : JS_UNDEFINED);
+}
 
-    JSValue value = JobjectToJSValue(env, ctx, result);
+int ArgToInt32(JSContext *ctx, int32_t *n, int argc, JSValueConst *argv, int i) {
+    return JS_ToInt32(ctx, n, i < argc ? argv[i] : JS_UNDEFINED);
+}
 
-    if (env->IsInstanceOf(result, jsValueCls)) {
-//        JS_FreeValue(ctx,value);
-//        JS_DupValue(ctx, value);
+JSValue callTypedJavaCallback(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv,
+                              int magic, JSValue *func_data) {
+    JNIEnv *env;
+    jvm->GetEnv((void **) &env, JNI_VERSION_1_6);
+    jobject callback = GetCallback(ctx, func_data[0]);
+    if (callback == nullptr) {
+        return createJSException(ctx, "Java callback has been released");
     }
-    return value;
+    JSValue result = JS_UNDEFINED;
+    switch (magic) {
+        case TYPED_CALLBACK_DOUBLE_UNARY: {
+            double a;
+            if (ArgToFloat64(ctx, &a, argc, argv, 0)) return JS_EXCEPTION;
+            result = JS_NewFloat64(ctx, env->CallDoubleMethod(callback, doubleUnaryInvokeMethodID, a));
+            break;
+        }
+        case TYPED_CALLBACK_DOUBLE_BINARY: {
+            double a, b;
+            if (ArgToFloat64(ctx, &a, argc, argv, 0) || ArgToFloat64(ctx, &b, argc, argv, 1)) {
+                return JS_EXCEPTION;
+            }
+            result = JS_NewFloat64(ctx, env->CallDoubleMethod(callback, doubleBinaryInvokeMethodID, a, b));
+            break;
+        }
+        case TYPED_CALLBACK_INT_BINARY: {
+            int32_t a, b;
+            if (ArgToInt32(ctx, &a, argc, argv, 0) || ArgToInt32(ctx, &b, argc, argv, 1)) {
+                return JS_EXCEPTION;
+            }
+            result = JS_NewInt32(ctx, env->CallIntMethod(callback, intBinaryInvokeMethodID, a, b));
+            break;
+        }
+        case TYPED_CALLBACK_STRING: {
+            JSValue str = JS_ToString(ctx, argc > 0 ? argv[0] : JS_UNDEFINED);
+            if (JS_IsException(str)) return str;
+            jstring s = JSStringToJString(env, ctx, str);
+            JS_FreeValue(ctx, str);
+            env->CallVoidMethod(callback, stringInvokeMethodID, s);
+            env->DeleteLocalRef(s);
+            break;
+        }
+        default:
+            break;
+    }
+    if (env->ExceptionCheck()) {
+        return JavaExceptionToJS(env, ctx);
+    }
+    return result;
 }
 
-JSValue newFunction(jlong context_ptr, int callbackId) {
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_registerTypedJavaMethod(JNIEnv *env, jobject clazz,
+                                                           jlong context_ptr,
+                                                           jobject object_handle,
+                                                           jstring function_name,
+                                                           jint kind,
+                                                           jobject callback) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValueConst func_data[2];
-    func_data[0] = JS_NewInt32(ctx, callbackId);
-    func_data[1] = JS_NewBool(ctx, 0);
-    JSValue func = JS_NewCFunctionData(ctx, callJavaCallback, 1, 0, 2, func_data);
-    return func;
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    JSValue holder = NewCallbackHolder(env, ctx, callback);
+    int length = kind == TYPED_CALLBACK_DOUBLE_BINARY || kind == TYPED_CALLBACK_INT_BINARY ? 2 : 1;
+    JSValue func = JS_NewCFunctionData(ctx, callTypedJavaCallback, length, kind, 1, &holder);
+    JS_FreeValue(ctx, holder);
+    const char *name_ = env->GetStringUTFChars(function_name, nullptr);
+    JS_SetPropertyStr(ctx, this_obj, name_, JS_DupValue(ctx, func));
+    env->ReleaseStringUTFChars(function_name, name_);
+    return TO_JAVA_OBJECT(env, ctx, func);
 }
 
 extern "C"
@@ -898,9 +3224,9 @@ JNIEXPORT jobject JNICALL
 Java_com_quickjs_QuickJSNativeImpl_initNewJSFunction(JNIEnv *env,
                                                      jobject clazz,
                                                        jlong context_ptr,
-                                                       jint callbackId) {
+                                                       jobject callback) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue func = newFunction(context_ptr, callbackId);
+    JSValue func = newFunction(env, ctx, callback);
     return TO_JAVA_OBJECT(env, ctx, func);
 }
 extern "C"
@@ -909,31 +3235,242 @@ Java_com_quickjs_QuickJSNativeImpl_registerJavaMethod(JNIEnv *env, jobject clazz
                                                         jlong context_ptr,
                                                         jobject object_handle,
                                                         jstring function_name,
-                                                        jint callbackId) {
-    const char *name_ = env->GetStringUTFChars(function_name, nullptr);
+                                                        jobject callback) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue func = newFunction(context_ptr, callbackId);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return nullptr;
+    JSValue func = newFunction(env, ctx, callback);
+    const char *name_ = env->GetStringUTFChars(function_name, nullptr);
     JS_SetPropertyStr(ctx, this_obj, name_, JS_DupValue(ctx, func));
+    env->ReleaseStringUTFChars(function_name, name_);
     return TO_JAVA_OBJECT(env, ctx, func);
 }
 
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_setMemoryLimit(JNIEnv *env, jobject clazz, jlong runtime_ptr, jlong limit) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    // QuickJS 以 (size_t) -1 表示不限制
+    JS_SetMemoryLimit(rt, limit > 0 ? (size_t) limit : (size_t) -1);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_setGCThreshold(JNIEnv *env, jobject clazz, jlong runtime_ptr,
+                                                  jlong threshold) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    JS_SetGCThreshold(rt, threshold > 0 ? (size_t) threshold : (size_t) -1);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_setMaxStackSize(JNIEnv *env, jobject clazz, jlong runtime_ptr,
+                                                   jlong stack_size) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    JS_SetMaxStackSize(rt, stack_size > 0 ? (size_t) stack_size : 0);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_runGC(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    JS_RunGC(reinterpret_cast<JSRuntime *>(runtime_ptr));
+}
+
+/*
+ * 按 JSMemoryUsage 的字段顺序返回 long[]，由 MemoryUsage.fromArray 解析。
+ * JS_ComputeMemoryUsage 遍历运行时中的全部对象、形状和原子，开销与堆大小成正比
+ */
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getMemoryUsage(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    JSMemoryUsage usage;
+    JS_ComputeMemoryUsage(rt, &usage);
+    static_assert(sizeof(JSMemoryUsage) % sizeof(int64_t) == 0, "JSMemoryUsage must only hold int64_t fields");
+    const auto count = (jsize) (sizeof(JSMemoryUsage) / sizeof(int64_t));
+    jlongArray result = env->NewLongArray(count);
+    env->SetLongArrayRegion(result, 0, count, reinterpret_cast<const jlong *>(&usage));
+    return result;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getInlineCacheStats(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    JSInlineCacheStats stats;
+    JS_GetInlineCacheStats(rt, &stats);
+    static_assert(sizeof(JSInlineCacheStats) % sizeof(int64_t) == 0,
+                  "JSInlineCacheStats must only hold int64_t fields");
+    const auto count = (jsize) (sizeof(JSInlineCacheStats) / sizeof(int64_t));
+    jlongArray result = env->NewLongArray(count);
+    env->SetLongArrayRegion(result, 0, count, reinterpret_cast<const jlong *>(&stats));
+    return result;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_resetInlineCacheStats(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    JS_ResetInlineCacheStats(reinterpret_cast<JSRuntime *>(runtime_ptr));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_setOpcodeProfiling(JNIEnv *env, jobject clazz, jlong runtime_ptr,
+                                                      jboolean enable) {
+    JS_SetOpcodeProfiling(reinterpret_cast<JSRuntime *>(runtime_ptr), enable);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_resetOpcodeProfile(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    JS_ResetOpcodeProfile(reinterpret_cast<JSRuntime *>(runtime_ptr));
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_quickjs_QuickJSNativeImpl_startCPUProfiler(JNIEnv *env, jobject clazz, jlong runtime_ptr,
+                                                    jint interval_micros) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    HandleTable *table = GetHandleTable(rt);
+    StopCpuSampler(table);
+    if (JS_StartCPUProfiler(rt, interval_micros) < 0) {
+        return JNI_FALSE;
+    }
+    auto *sampler = new CpuSampler();
+    sampler->thread = std::thread([sampler, rt, interval_micros]() {
+        std::unique_lock<std::mutex> lock(sampler->mutex);
+        while (!sampler->cv.wait_for(lock, std::chrono::microseconds(interval_micros),
+                                     [sampler] { return sampler->stop; })) {
+            JS_RequestCPUProfileSample(rt);
+        }
+    });
+    table->sampler = sampler;
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_stopCPUProfiler(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    StopCpuSampler(GetHandleTable(rt));
+    JS_StopCPUProfiler(rt);
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getCPUProfile(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    char *profile = JS_GetCPUProfile(rt, nullptr);
+    if (profile == nullptr) {
+        return nullptr;
+    }
+    jstring result = env->NewStringUTF(profile);
+    js_free_rt(rt, profile);
+    return result;
+}
+
+// 返回 {String[] 名称, long[] 数值}，布局见 OpcodeProfile.fromArrays；从未开启过剖析时返回 null
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getOpcodeProfile(JNIEnv *env, jobject clazz, jlong runtime_ptr,
+                                                    jint max_entries) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    JSOpcodeProfile *profile = JS_GetOpcodeProfile(rt, max_entries);
+    if (profile == nullptr) {
+        return nullptr;
+    }
+    std::vector<const char *> names;
+    std::vector<jlong> values;
+    values.push_back(profile->total);
+    values.push_back(profile->opcode_count);
+    values.push_back(profile->pair_count);
+    values.push_back(profile->function_count);
+    for (int i = 0; i < profile->opcode_count; i++) {
+        names.push_back(JS_GetOpcodeName(profile->opcodes[i].opcode));
+        values.push_back(profile->opcodes[i].count);
+    }
+    for (int i = 0; i < profile->pair_count; i++) {
+        names.push_back(JS_GetOpcodeName(profile->pairs[i].opcode));
+        names.push_back(JS_GetOpcodeName(profile->pairs[i].next_opcode));
+        values.push_back(profile->pairs[i].count);
+    }
+    for (int i = 0; i < profile->function_count; i++) {
+        const JSFunctionProfileEntry &fn = profile->functions[i];
+        names.push_back(fn.func_name);
+        names.push_back(fn.filename);
+        values.push_back(fn.line_num);
+        values.push_back(fn.col_num);
+        values.push_back(fn.call_count);
+        values.push_back(fn.loop_count);
+        values.push_back(fn.exec_count);
+    }
+    jobjectArray nameArray = env->NewObjectArray((jsize) names.size(), stringCls, nullptr);
+    for (size_t i = 0; i < names.size(); i++) {
+        jstring item = env->NewStringUTF(names[i]);
+        env->SetObjectArrayElement(nameArray, (jsize) i, item);
+        env->DeleteLocalRef(item);
+    }
+    JS_FreeOpcodeProfile(rt, profile);
+    jlongArray valueArray = env->NewLongArray((jsize) values.size());
+    env->SetLongArrayRegion(valueArray, 0, (jsize) values.size(), values.data());
+    jobjectArray result = env->NewObjectArray(2, objectCls, nullptr);
+    env->SetObjectArrayElement(result, 0, nameArray);
+    env->SetObjectArrayElement(result, 1, valueArray);
+    return result;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_setExecutionLimits(JNIEnv *env, jobject clazz, jlong runtime_ptr,
+                                                      jlong timeout_millis, jlong instruction_budget) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    ExecutionBudget &budget = GetHandleTable(rt)->budget;
+    budget.default_timeout_ns = timeout_millis > 0 ? timeout_millis * 1000000 : 0;
+    budget.default_ticks = instruction_budget > 0 ? instruction_budget : 0;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_beginExecutionBudget(JNIEnv *env, jobject clazz, jlong runtime_ptr,
+                                                        jlong timeout_millis, jlong instruction_budget) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    EnterBudget(GetHandleTable(rt)->budget, timeout_millis > 0 ? timeout_millis * 1000000 : 0,
+                instruction_budget > 0 ? instruction_budget : 0);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_QuickJSNativeImpl_endExecutionBudget(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    auto *rt = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    LeaveBudget(GetHandleTable(rt)->budget);
+}
+
+// 运行时中尚未被 JS 回收的 Java 回调数量
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_quickjs_QuickJSNativeImpl_getCallbackCount(JNIEnv *env, jobject clazz, jlong runtime_ptr) {
+    auto *runtime = reinterpret_cast<JSRuntime *>(runtime_ptr);
+    return (jint) GetHandleTable(runtime)->live_callbacks;
+}
+
 
 extern "C"
 JNIEXPORT jint JNICALL
 Java_com_quickjs_QuickJSNativeImpl_getObjectType(JNIEnv *env, jobject clazz, jlong context_ptr,
                                                    jobject object_handle) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue value = TO_JS_VALUE(env, object_handle);
+    JSValue value = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return 0;
     return GetObjectType(ctx, value);
 }
 extern "C"
 JNIEXPORT void JNICALL
 Java_com_quickjs_QuickJSNativeImpl_set(JNIEnv *env, jobject clazz, jlong context_ptr,
                                          jobject object_handle, jstring key, jobject value) {
-    const char *key_ = env->GetStringUTFChars(key, nullptr);
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return;
+    const char *key_ = env->GetStringUTFChars(key, nullptr);
     JS_SetPropertyStr(ctx, this_obj, key_, JobjectToJSValue(env, ctx, value));
     env->ReleaseStringUTFChars(key, key_);
 }
@@ -943,7 +3480,8 @@ JNIEXPORT void JNICALL
 Java_com_quickjs_QuickJSNativeImpl_arrayAdd(JNIEnv *env, jobject clazz, jlong context_ptr,
                                               jobject object_handle, jobject value) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue this_obj = TO_JS_VALUE(env, object_handle);
+    JSValue this_obj = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) return;
     int len = GetArrayLength(ctx, this_obj);
     JS_SetPropertyUint32(ctx, this_obj, len, JobjectToJSValue(env, ctx, value));
 }
@@ -951,7 +3489,9 @@ extern "C"
 JNIEXPORT jboolean JNICALL
 Java_com_quickjs_QuickJSNativeImpl_isUndefined(JNIEnv *env, jobject clazz, jlong context_ptr,
                                                  jobject js_value) {
-    JSValue value = TO_JS_VALUE(env, js_value);
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue value = TO_JS_VALUE(env, ctx, js_value);
+    if (env->ExceptionCheck()) return JNI_FALSE;
     return JS_IsUndefined(value);
 }
 
@@ -973,6 +3513,10 @@ extern "C"
 JNIEXPORT jobjectArray JNICALL
 Java_com_quickjs_QuickJSNativeImpl_getException(JNIEnv *env, jobject clazz, jlong context_ptr) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    if (ThrowIfBudgetExhausted(env, ctx)) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        return nullptr;
+    }
     JSValue exc = JS_GetException(ctx);
     if (!JS_IsError(ctx, exc)) {
         return nullptr;
@@ -1024,8 +3568,8 @@ JSModuleDef *ES6JSModuleLoaderFunc(JSContext *ctx, const char *module_name, void
         return nullptr;
     }
 
-    JSValue func_val = JS_Eval(ctx, script, scriptLen, module_name,
-                                 JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    JSValue func_val = evalWithBytecodeCache(ctx, script, scriptLen, module_name,
+                                             JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
     m = JS_VALUE_GET_PTR(func_val);
     JS_FreeValue(ctx, func_val);
     return (JSModuleDef *) m;
@@ -1077,34 +3621,11 @@ JSValue js_worker_constructor(JSContext *ctx, JSValueConst this_val, int argc, J
                               int me) {
     JNIEnv *env;
     jvm->GetEnv((void **) &env, JNI_VERSION_1_6);
-    auto context_ptr = (jlong) ctx;
-    int callbackId = JS_VALUE_GET_INT(JS_GetPropertyStr(ctx, this_val, "java_caller_id"));
-
-    jobjectArray args = env->NewObjectArray(argc, objectCls, nullptr);
-
-    if (argv != nullptr) {
-        for (int i = 0; i < argc; ++i) {
-            JSValue it = argv[i];
-            jobject obj = JSValueToJava(ctx, env, it);
-            env->SetObjectArrayElement(args, i, obj);
-        }
-    }
-
-    jobject objectHandle = TO_JAVA_OBJECT(env, ctx, this_val);
-//    jobject argsHandle = TO_JAVA_OBJECT(env, ctx, args);
-    JSValue global = JS_GetGlobalObject(ctx);
-    if (!JS_Equals(global, this_val)) {
-        JS_DupValue(ctx, this_val);
-    }
-    JS_FreeValue(ctx, global);
-    jobject result = env->CallStaticObjectMethod(quickJSCls, callJavaCallbackMethodID,
-                                                 context_ptr,
-                                                 callbackId,
-                                                 objectHandle,
-                                                 args
-    );
-    JSValue value = JobjectToJSValue(env, ctx, result);
-    return value;
+    // 构造调用时 this_val 是 new.target，即构造函数本身
+    JSValue holder = JS_GetPropertyStr(ctx, this_val, "java_caller_id");
+    jobject callback = GetCallback(ctx, holder);
+    JS_FreeValue(ctx, holder);
+    return InvokeJavaCallback(env, ctx, callback, this_val, argc, argv);
 }
 
 void newWorker(JSContext *ctx, int callbackId) {
@@ -1121,60 +3642,217 @@ void newWorker(JSContext *ctx, int callbackId) {
 extern "C"
 JNIEXPORT jobject JNICALL
 Java_com_quickjs_QuickJSNativeImpl_newClass(JNIEnv *env, jobject thiz, jlong context_ptr,
-                                              jint java_caller_id) {
+                                              jobject callback) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
     JSValue func = JS_NewCFunctionMagic(ctx, js_worker_constructor, "Worker", 1,
-                                        JS_CFUNC_constructor, java_caller_id);
-    JS_SetPropertyStr(ctx, func, "java_caller_id", JS_NewInt32(ctx, java_caller_id));
+                                        JS_CFUNC_constructor, 0);
+    // 持有对象只被构造函数引用，构造函数回收时一并释放回调
+    JS_DefinePropertyValueStr(ctx, func, "java_caller_id", NewCallbackHolder(env, ctx, callback), 0);
     return TO_JAVA_OBJECT(env, ctx, func);
 }
 
-extern "C"
-JNIEXPORT jstring JNICALL
-Java_com_quickjs_QuickJSNativeImpl_stringify(JNIEnv *env, jobject thiz, jlong context_ptr, jlong js_object) {
-    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue obj = JS_JSONStringify(ctx, JS_MKPTR(JS_TAG_OBJECT, reinterpret_cast<void *>(js_object)), JS_UNDEFINED, JS_UNDEFINED);
-    const auto str = JS_ToCString(ctx, obj);
-    jstring result = env->NewStringUTF(str);
-    JS_FreeCString(ctx, str);
-    return result;
-}
-
 extern "C"
 JNIEXPORT jstring JNICALL
 Java_com_quickjs_QuickJSNativeImpl_toString(JNIEnv *env, jobject thiz, jlong context_ptr, jlong js_object) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
     JSValue obj = JS_MKPTR(JS_TAG_OBJECT, reinterpret_cast<void *>(js_object));
-    const char* str = JS_ToCString(ctx, obj);
-    jstring result = env->NewStringUTF(str);
-    JS_FreeCString(ctx, str);
+    jstring result = JSStringToJString(env, ctx, obj);
     JS_FreeValue(ctx, obj);
     return result;
 }
 
+/*
+ * JSON 快速通道：UTF-8 字节直接交给 JS_ParseJSON2，序列化结果直接写入 byte[] 或可复用的 direct ByteBuffer，
+ * 不经过 Java String 与 modified UTF-8 的转换。
+ * JS_ParseJSON2 要求输入以 '\0' 结尾，输入不满足时复制到运行时的可复用缓冲区。
+ */
+JSValue ParseJSONBytes(JSContext *ctx, const char *data, size_t length, bool terminated) {
+    if (!terminated) {
+        std::vector<char> &scratch = GetHandleTable(JS_GetRuntime(ctx))->json_scratch;
+        scratch.resize(length + 1);
+        memcpy(scratch.data(), data, length);
+        scratch[length] = '\0';
+        data = scratch.data();
+    }
+    return JS_ParseJSON2(ctx, data, length, "parseJSON.js", 0);
+}
+
+jobject ParseJSONResult(JNIEnv *env, JSContext *ctx, JSValue value) {
+    if (JS_IsException(value)) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    return To_JObject(env, reinterpret_cast<jlong>(ctx), TYPE_UNKNOWN, value);
+}
+
 extern "C"
 JNIEXPORT jobject JNICALL
 Java_com_quickjs_QuickJSNativeImpl_parseJSON(JNIEnv *env, jobject thiz, jlong context_ptr, jstring json) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    // 先按 UTF-16 建立 JS 字符串再取 UTF-8，代理对与 '\0' 都能正确处理
+    JSValue str = JStringToJSValue(env, ctx, json);
+    if (JS_IsException(str)) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    size_t length;
+    const char *utf8 = JS_ToCStringLen(ctx, &length, str);
+    JS_FreeValue(ctx, str);
+    if (utf8 == nullptr) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    JSValue value = ParseJSONBytes(ctx, utf8, length, true);
+    JS_FreeCString(ctx, utf8);
+    return ParseJSONResult(env, ctx, value);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_parseJSONBytes(JNIEnv *env, jobject thiz, jlong context_ptr,
+                                                  jbyteArray bytes, jint offset, jint length) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    if (offset < 0 || length < 0 || offset > env->GetArrayLength(bytes) - length) {
+        throwJSException(env, "parseJSONBytes: range out of bounds");
+        return nullptr;
+    }
+    // 直接复制到可复用缓冲区，省去一次中间拷贝
+    std::vector<char> &scratch = GetHandleTable(JS_GetRuntime(ctx))->json_scratch;
+    scratch.resize((size_t) length + 1);
+    env->GetByteArrayRegion(bytes, offset, length, reinterpret_cast<jbyte *>(scratch.data()));
+    scratch[length] = '\0';
+    JSValue value = ParseJSONBytes(ctx, scratch.data(), (size_t) length, true);
+    return ParseJSONResult(env, ctx, value);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_parseJSONBuffer(JNIEnv *env, jobject thiz, jlong context_ptr,
+                                                   jobject buffer, jint offset, jint length) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    auto *data = static_cast<char *>(env->GetDirectBufferAddress(buffer));
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (data == nullptr || capacity < 0) {
+        throwJSException(env, "parseJSONBuffer: ByteBuffer must be a direct buffer");
+        return nullptr;
+    }
+    if (offset < 0 || length < 0 || offset > capacity - length) {
+        throwJSException(env, "parseJSONBuffer: range out of bounds");
+        return nullptr;
+    }
+    // 数据之后紧跟 '\0' 时原地解析，零拷贝
+    bool terminated = offset + length < capacity && data[offset + length] == '\0';
+    JSValue value = ParseJSONBytes(ctx, data + offset, (size_t) length, terminated);
+    return ParseJSONResult(env, ctx, value);
+}
+
+// 按 JSON.stringify 的规则序列化，indent 大于 0 时缩进；结果为 undefined 时表示值无法序列化（如函数）
+JSValue StringifyHandle(JNIEnv *env, JSContext *ctx, jobject object_handle, jint indent) {
+    JSValue value = TO_JS_VALUE(env, ctx, object_handle);
+    if (env->ExceptionCheck()) {
+        return JS_UNDEFINED;
+    }
+    JSValue space = indent > 0 ? JS_NewInt32(ctx, indent) : JS_UNDEFINED;
+    JSValue json = JS_JSONStringify(ctx, value, JS_UNDEFINED, space);
+    if (JS_IsException(json)) {
+        throwJSException(env, ctx);
+        return JS_UNDEFINED;
+    }
+    return json;
+}
 
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_quickjs_QuickJSNativeImpl_stringify(JNIEnv *env, jobject thiz, jlong context_ptr,
+                                             jobject object_handle, jint indent) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    const char *c_json = env->GetStringUTFChars(json, JNI_FALSE);
+    JSValue json = StringifyHandle(env, ctx, object_handle, indent);
+    if (JS_IsUndefined(json)) {
+        return nullptr;
+    }
+    jstring result = JSStringToJString(env, ctx, json);
+    JS_FreeValue(ctx, json);
+    return result;
+}
 
-    auto jsonObj = JS_ParseJSON(ctx, c_json, strlen(c_json), "parseJSON.js");
-    if (JS_IsException(jsonObj)) {
-        JS_ThrowSyntaxError(ctx, "");
+extern "C"
+JNIEXPORT jbyteArray JNICALL
+Java_com_quickjs_QuickJSNativeImpl_stringifyToBytes(JNIEnv *env, jobject thiz, jlong context_ptr,
+                                                    jobject object_handle, jint indent) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue json = StringifyHandle(env, ctx, object_handle, indent);
+    if (JS_IsUndefined(json)) {
         return nullptr;
     }
-    jobject result = To_JObject(env, context_ptr, JS_TAG_OBJECT, jsonObj);
-    env->ReleaseStringUTFChars(json, c_json);
+    size_t length;
+    const char *utf8 = JS_ToCStringLen(ctx, &length, json);
+    JS_FreeValue(ctx, json);
+    if (utf8 == nullptr) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    jbyteArray result = env->NewByteArray((jsize) length);
+    if (result != nullptr) {
+        env->SetByteArrayRegion(result, 0, (jsize) length, reinterpret_cast<const jbyte *>(utf8));
+    }
+    JS_FreeCString(ctx, utf8);
     return result;
 }
 
+/*
+ * 序列化到可复用的 direct ByteBuffer：容量足够时写入 reuse，否则按 2 的幂分配新的缓冲区，
+ * 返回的缓冲区 position 为 0，limit 为 UTF-8 字节数。
+ */
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_quickjs_QuickJSNativeImpl_stringifyToBuffer(JNIEnv *env, jobject thiz, jlong context_ptr,
+                                                     jobject object_handle, jint indent, jobject reuse) {
+    auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    JSValue json = StringifyHandle(env, ctx, object_handle, indent);
+    if (JS_IsUndefined(json)) {
+        return nullptr;
+    }
+    size_t length;
+    const char *utf8 = JS_ToCStringLen(ctx, &length, json);
+    JS_FreeValue(ctx, json);
+    if (utf8 == nullptr) {
+        throwJSException(env, ctx);
+        return nullptr;
+    }
+    jobject buffer = reuse;
+    if (buffer == nullptr || env->GetDirectBufferAddress(buffer) == nullptr ||
+        (size_t) env->GetDirectBufferCapacity(buffer) < length) {
+        size_t capacity = 4096;
+        while (capacity < length) {
+            capacity <<= 1;
+        }
+        if (capacity > INT32_MAX) {
+            capacity = length;
+        }
+        if (capacity > INT32_MAX) {
+            JS_FreeCString(ctx, utf8);
+            throwJSException(env, "stringifyToBuffer: result too large");
+            return nullptr;
+        }
+        buffer = env->CallStaticObjectMethod(byteBufferCls, byteBufferAllocateDirectMethodID, (jint) capacity);
+        if (env->ExceptionCheck()) {
+            JS_FreeCString(ctx, utf8);
+            return nullptr;
+        }
+    }
+    memcpy(env->GetDirectBufferAddress(buffer), utf8, length);
+    JS_FreeCString(ctx, utf8);
+    env->DeleteLocalRef(env->CallObjectMethod(buffer, bufferClearMethodID));
+    env->DeleteLocalRef(env->CallObjectMethod(buffer, bufferLimitMethodID, (jint) length));
+    return buffer;
+}
 
 extern "C"
 JNIEXPORT void JNICALL
 Java_com_quickjs_QuickJSNativeImpl_executePendingJobs(JNIEnv *env, jobject thiz,
                                                       jlong context_ptr) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
+    BudgetScope budget_scope(ctx);
 
     JSRuntime *rt = JS_GetRuntime(ctx);
     executePendingJobLoop(env, rt, ctx);
@@ -1194,11 +3872,9 @@ Java_com_quickjs_QuickJSNativeImpl_getPrototype(JNIEnv *env, jobject thiz, jlong
                                                 jobject value) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
 
-    JSValue jsValue = TO_JS_VALUE(env, value);
+    JSValue jsValue = TO_JS_VALUE(env, ctx, value);
+    if (env->ExceptionCheck()) return nullptr;
     JSValue proto = JS_GetPrototype(ctx, jsValue);
-    JS_FreeValue(ctx, jsValue);
-
-
     return TO_JAVA_OBJECT(env, ctx, proto);
 }
 extern "C"
@@ -1206,32 +3882,27 @@ JNIEXPORT jobject JNICALL
 Java_com_quickjs_QuickJSNativeImpl_getObject(JNIEnv *env, jobject thiz, jlong context_ptr,
                                              jobject value) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue val = TO_JS_VALUE(env, value);
-    jobject result = TO_JAVA_OBJECT(env, ctx, val);
-
-    JS_FreeValue(ctx, val);
-    return result;
+    JSValue val = TO_JS_VALUE(env, ctx, value);
+    if (env->ExceptionCheck()) return nullptr;
+    // 句柄表持有原引用，新的 Java 对象需要自己的引用
+    return TO_JAVA_OBJECT(env, ctx, JS_DupValue(ctx, val));
 }
 extern "C"
 JNIEXPORT jstring JNICALL
 Java_com_quickjs_QuickJSNativeImpl_toJSString(JNIEnv *env, jobject thiz, jlong context_ptr, jobject value) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue val = TO_JS_VALUE(env, value);
-    JSValue str = JS_ToString(ctx, val);
-    const char *obj_str = JS_ToCString(ctx, str);
-    jstring result = env->NewStringUTF(obj_str);
-    JS_FreeCString(ctx, obj_str);
-    JS_FreeValue(ctx, str);
-    JS_FreeValue(ctx, val);
-    return result;
+    JSValue val = TO_JS_VALUE(env, ctx, value);
+    if (env->ExceptionCheck()) return nullptr;
+    return JSStringToJString(env, ctx, val);
 }
 extern "C"
 JNIEXPORT void JNICALL
 Java_com_quickjs_QuickJSNativeImpl_setPrototype(JNIEnv *env, jobject thiz, jlong context_ptr,
                                                 jobject obj, jobject prototype) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue jsObj = TO_JS_VALUE(env, obj);
-    JSValue jsPrototype = TO_JS_VALUE(env, prototype);
+    JSValue jsObj = TO_JS_VALUE(env, ctx, obj);
+    JSValue jsPrototype = TO_JS_VALUE(env, ctx, prototype);
+    if (env->ExceptionCheck()) return;
     JS_SetPrototype(ctx, jsObj, jsPrototype);
 }
 extern "C"
@@ -1239,8 +3910,9 @@ JNIEXPORT void JNICALL
 Java_com_quickjs_QuickJSNativeImpl_setConstructor(JNIEnv *env, jobject thiz, jlong context_ptr,
                                                 jobject obj, jobject constructor) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue jsObj = TO_JS_VALUE(env, obj);
-    JSValue jsConstructor = TO_JS_VALUE(env, constructor);
+    JSValue jsObj = TO_JS_VALUE(env, ctx, obj);
+    JSValue jsConstructor = TO_JS_VALUE(env, ctx, constructor);
+    if (env->ExceptionCheck()) return;
     JS_SetConstructor(ctx, jsObj, jsConstructor);
 }
 
@@ -1259,7 +3931,47 @@ JNIEXPORT jboolean JNICALL
 Java_com_quickjs_QuickJSNativeImpl_isError(JNIEnv *env, jobject thiz, jlong context_ptr,
                                            jobject value) {
     auto *ctx = reinterpret_cast<JSContext *>(context_ptr);
-    JSValue jsValue = TO_JS_VALUE(env, value);
+    JSValue jsValue = TO_JS_VALUE(env, ctx, value);
+    if (env->ExceptionCheck()) return JNI_FALSE;
     bool isError = JS_IsError(ctx, jsValue);
     return isError;
-}
\ No newline at end of file
+}
+
+// 仅供 ConversionBenchmarkTest 对照：按缓存前 JavaToJSValue 的顺序重做一次 List/Map 转换中的
+// FindClass/GetMethodID（List 每次 2 个、Map 每次 3 个类 6 个方法，另外每个元素 1 个拆箱方法），
+// 元素类型与基准数据一致：List 交替 Integer/Double，Map 交替 Boolean/Integer
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_quickjs_benchmark_ConversionBenchmarkTest_uncachedLookups(JNIEnv *env, jclass clazz,
+                                                                   jint elements, jboolean map) {
+    if (map) {
+        env->GetMethodID(mapClass, "entrySet", "()Ljava/util/Set;");
+        jclass setClass = env->FindClass("java/util/Set");
+        env->GetMethodID(setClass, "iterator", "()Ljava/util/Iterator;");
+        jclass iteratorClass = env->FindClass("java/util/Iterator");
+        env->GetMethodID(iteratorClass, "hasNext", "()Z");
+        env->GetMethodID(iteratorClass, "next", "()Ljava/lang/Object;");
+        jclass entryClass = env->FindClass("java/util/Map$Entry");
+        env->GetMethodID(entryClass, "getKey", "()Ljava/lang/Object;");
+        env->GetMethodID(entryClass, "getValue", "()Ljava/lang/Object;");
+        env->DeleteLocalRef(setClass);
+        env->DeleteLocalRef(iteratorClass);
+        env->DeleteLocalRef(entryClass);
+    } else {
+        env->GetMethodID(listCls, "size", "()I");
+        env->GetMethodID(listCls, "get", "(I)Ljava/lang/Object;");
+    }
+    for (jint i = 0; i < elements; i++) {
+        if (i % 2 == 0) {
+            if (map) {
+                env->GetMethodID(booleanCls, "booleanValue", "()Z");
+            } else {
+                env->GetMethodID(integerCls, "intValue", "()I");
+            }
+        } else if (map) {
+            env->GetMethodID(integerCls, "intValue", "()I");
+        } else {
+            env->GetMethodID(doubleCls, "doubleValue", "()D");
+        }
+    }
+}
@@ -32,6 +32,10 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <time.h>
+#if !defined(_WIN32)
+#include <signal.h>
+#include <sys/time.h>
+#endif
 #if defined(__APPLE__)
 #include <malloc/malloc.h>
 #elif defined(__linux__) || defined(__GLIBC__)
@@ -283,6 +287,60 @@ static size_t get_suffixed_size(const char *str)
     return v;
 }
 
+#if !defined(_WIN32)
+/* the CPU profiler is sampled when the process consumed 'interval_us'
+   of CPU time */
+static JSRuntime *profile_rt;
+
+static void profile_signal_handler(int sig)
+{
+    JS_RequestCPUProfileSample(profile_rt);
+}
+
+static int profile_start(JSRuntime *rt, int interval_us)
+{
+    struct sigaction sa;
+    struct itimerval it;
+
+    if (JS_StartCPUProfiler(rt, interval_us))
+        return -1;
+    profile_rt = rt;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = profile_signal_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, NULL);
+    it.it_interval.tv_sec = interval_us / 1000000;
+    it.it_interval.tv_usec = interval_us % 1000000;
+    it.it_value = it.it_interval;
+    return setitimer(ITIMER_PROF, &it, NULL);
+}
+
+static void profile_stop(JSRuntime *rt, const char *filename)
+{
+    struct itimerval it;
+    char *buf;
+    size_t len;
+    FILE *f;
+
+    memset(&it, 0, sizeof(it));
+    setitimer(ITIMER_PROF, &it, NULL);
+    JS_StopCPUProfiler(rt);
+    buf = JS_GetCPUProfile(rt, &len);
+    if (!buf) {
+        fprintf(stderr, "qjs: could not build the CPU profile\n");
+        return;
+    }
+    f = fopen(filename, "wb");
+    if (!f || fwrite(buf, 1, len, f) != len) {
+        perror(filename);
+    }
+    if (f)
+        fclose(f);
+    js_free_rt(rt, buf);
+}
+#endif
+
 #define PROG_NAME "qjs"
 
 void help(void)
@@ -298,6 +356,8 @@ void help(void)
            "    --std          make 'std' and 'os' available to the loaded script\n"
            "-T  --trace        trace memory allocation\n"
            "-d  --dump         dump the memory usage stats\n"
+           "    --opcode-profile  dump the most executed opcodes, opcode pairs and functions\n"
+           "    --profile file    write a sampled CPU profile (.cpuprofile format) to 'file'\n"
            "    --memory-limit n  limit the memory usage to 'n' bytes (SI suffixes allowed)\n"
            "    --stack-size n    limit the stack size to 'n' bytes (SI suffixes allowed)\n"
            "    --no-unhandled-rejection  ignore unhandled promise rejections\n"
@@ -316,6 +376,8 @@ int main(int argc, char **argv)
     char *expr = NULL;
     int interactive = 0;
     int dump_memory = 0;
+    int opcode_profile = 0;
+    const char *profile_filename = NULL;
     int trace_memory = 0;
     int empty_run = 0;
     int module = -1;
@@ -392,6 +454,18 @@ int main(int argc, char **argv)
                 dump_memory++;
                 continue;
             }
+            if (!strcmp(longopt, "opcode-profile")) {
+                opcode_profile = 1;
+                continue;
+            }
+            if (!strcmp(longopt, "profile")) {
+                if (optind >= argc) {
+                    fprintf(stderr, "expecting profile filename");
+                    exit(1);
+                }
+                profile_filename = argv[optind++];
+                continue;
+            }
             if (opt == 'T' || !strcmp(longopt, "trace")) {
                 trace_memory++;
                 continue;
@@ -456,6 +530,19 @@ int main(int argc, char **argv)
     if (stack_size != 0)
         JS_SetMaxStackSize(rt, stack_size);
     JS_SetStripInfo(rt, strip_flags);
+    if (opcode_profile)
+        JS_SetOpcodeProfiling(rt, TRUE);
+    if (profile_filename) {
+#if !defined(_WIN32)
+        if (profile_start(rt, 1000)) {
+            fprintf(stderr, "qjs: cannot start the CPU profiler\n");
+            exit(2);
+        }
+#else
+        fprintf(stderr, "qjs: --profile is not supported on this platform\n");
+        exit(2);
+#endif
+    }
     js_std_set_worker_new_context_func(JS_NewCustomContext);
     js_std_init_handlers(rt);
     ctx = JS_NewCustomContext(rt);
@@ -514,6 +601,17 @@ int main(int argc, char **argv)
         JS_ComputeMemoryUsage(rt, &stats);
         JS_DumpMemoryUsage(stdout, &stats, rt);
     }
+#if !defined(_WIN32)
+    if (profile_filename)
+        profile_stop(rt, profile_filename);
+#endif
+    if (opcode_profile) {
+        JSOpcodeProfile *prof = JS_GetOpcodeProfile(rt, 30);
+        if (prof) {
+            JS_DumpOpcodeProfile(stdout, prof);
+            JS_FreeOpcodeProfile(rt, prof);
+        }
+    }
     js_std_free_handlers(rt);
     JS_FreeContext(ctx);
     JS_FreeRuntime(rt);
@@ -53,6 +53,7 @@ FMT(atom_u16)
 FMT(atom_label_u8)
 FMT(atom_label_u16)
 FMT(label_u16)
+FMT(loc8_label16)
 #undef FMT
 #endif /* FMT */
 
@@ -365,6 +366,27 @@ DEF(typeof_is_undefined, 1, 1, 1, none)
 DEF( typeof_is_function, 1, 1, 1, none)
 #endif
 
+/* inline cache forms of get_field, get_field2, put_field and of the
+   global variable accesses, created by js_init_inline_caches(). The
+   operand is an index in JSFunctionBytecode.ic which holds the atom
+   and the original opcode. They are never written to the bytecode
+   files. */
+DEF(   get_field_ic, 5, 1, 1, u32)
+DEF(  get_field2_ic, 5, 1, 2, u32)
+DEF(   put_field_ic, 5, 2, 0, u32)
+DEF(     get_var_ic, 5, 0, 1, u32) /* check_var, get_var_undef or get_var */
+DEF(     put_var_ic, 5, 1, 0, u32)
+DEF(put_var_strict_ic, 5, 2, 0, u32)
+
+#if SUPER_OPCODES
+/* superinstructions replacing the most frequent opcode pairs, created
+   by js_fuse_superinstructions(). They have the size of the pair they
+   replace and are never written to the bytecode files. The opcode
+   space is full after them. */
+DEF(    lt_if_false, 3, 2, 0, label16) /* lt if_false8 */
+DEF(   inc_loc_goto, 4, 0, 0, loc8_label16) /* inc_loc goto8 */
+#endif
+
 #undef DEF
 #undef def
 #endif  /* DEF */
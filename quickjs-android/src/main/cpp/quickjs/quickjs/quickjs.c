@@ -49,6 +49,11 @@
 
 #define OPTIMIZE         1
 #define SHORT_OPCODES    1
+/* fuse frequent opcode pairs into superinstructions at function
+   creation. Can be disabled with -DSUPER_OPCODES=0 */
+#ifndef SUPER_OPCODES
+#define SUPER_OPCODES    1
+#endif
 #if defined(EMSCRIPTEN)
 #define DIRECT_DISPATCH  0
 #else
@@ -304,6 +309,13 @@ struct JSRuntime {
     int shape_hash_size;
     int shape_hash_count; /* number of hashed shapes */
     JSShape **shape_hash;
+    JSInlineCacheStats ic_stats;
+    /* see JS_SetOpcodeProfiling() */
+    BOOL opcode_profiling;
+    struct JSOpcodeProfileData *opcode_profile;
+    /* see JS_StartCPUProfiler() */
+    struct JSCPUProfiler *cpu_profiler;
+    uint32_t cpu_sample_request; /* time of the pending request, 0 if none */
     void *user_opaque;
 };
 
@@ -437,6 +449,8 @@ typedef enum {
 /* must be large enough to have a negligible runtime cost and small
    enough to call the interrupt callback often. */
 #define JS_INTERRUPT_COUNTER_INIT 10000
+/* interrupt check period while the CPU profiler is running */
+#define JS_CPU_PROFILE_COUNTER_INIT 1000
 
 struct JSContext {
     JSGCObjectHeader header; /* must come first */
@@ -468,6 +482,9 @@ struct JSContext {
 
     /* when the counter reaches zero, JSRutime.interrupt_handler is called */
     int interrupt_counter;
+    /* ticks since the last interrupt_handler call when the CPU profiler
+       shortens the counter */
+    int interrupt_ticks;
 
     struct list_head loaded_modules; /* list of JSModuleDef.link */
 
@@ -612,6 +629,33 @@ typedef enum JSFunctionKindEnum {
     JS_FUNC_ASYNC_GENERATOR = (JS_FUNC_GENERATOR | JS_FUNC_ASYNC),
 } JSFunctionKindEnum;
 
+#define IC_MAX_ENTRIES 4  /* polymorphic degree of the inline caches */
+#define IC_MAX_DEPTH   3  /* maximum prototype level of a cached property */
+#define IC_MAX_UPDATES 16 /* the cache is megamorphic after this number of updates */
+
+typedef struct JSInlineCacheEntry {
+    /* shapes[0] is the receiver shape and shapes[1..depth] are the
+       shapes of its prototypes up to the object holding the
+       property. The shapes are referenced, hence they are never
+       modified (see js_shape_prepare_update()). */
+    JSShape *shapes[IC_MAX_DEPTH + 1];
+    /* put_field_ic: shape after adding the property, NULL if it is an
+       own property */
+    JSShape *new_shape;
+    uint32_t prop_index; /* property index in the holder */
+    uint8_t depth;
+} JSInlineCacheEntry;
+
+/* inline cache of a get_field_ic, get_field2_ic, put_field_ic,
+   get_var_ic, put_var_ic or put_var_strict_ic instruction */
+typedef struct JSInlineCache {
+    JSAtom atom;
+    uint8_t opcode; /* opcode replaced by the cache */
+    uint8_t count; /* number of entries */
+    uint8_t updates; /* no more entries are recorded at IC_MAX_UPDATES */
+    JSInlineCacheEntry *entries;
+} JSInlineCache;
+
 typedef struct JSFunctionBytecode {
     JSGCObjectHeader header; /* must come first */
     uint8_t js_mode;
@@ -642,6 +686,9 @@ typedef struct JSFunctionBytecode {
     JSValue *cpool; /* constant pool (self pointer) */
     int cpool_count;
     int closure_var_count;
+    int ic_count;
+    struct JSInlineCache *ic; /* see js_init_inline_caches() */
+    struct JSFunctionProfile *profile; /* see JS_SetOpcodeProfiling() */
     struct {
         /* debug info, move to separate structure to save memory? */
         JSAtom filename;
@@ -1070,6 +1117,13 @@ static JSAtom __JS_NewAtomInit(JSRuntime *rt, const char *str, int len,
                                int atom_type);
 static void JS_FreeAtomStruct(JSRuntime *rt, JSAtomStruct *p);
 static void free_function_bytecode(JSRuntime *rt, JSFunctionBytecode *b);
+static void js_init_inline_caches(JSRuntime *rt, JSFunctionBytecode *b);
+static void js_free_inline_caches(JSRuntime *rt, JSFunctionBytecode *b);
+static void js_free_opcode_profile(JSRuntime *rt);
+static void js_free_cpu_profiler(JSRuntime *rt);
+static void js_cpu_profile_enter(JSRuntime *rt);
+static void js_inline_cache_mark(JSRuntime *rt, JSInlineCache *ic,
+                                 JS_MarkFunc *mark_func);
 static JSValue js_call_c_function(JSContext *ctx, JSValueConst func_obj,
                                   JSValueConst this_obj,
                                   int argc, JSValueConst *argv, int flags);
@@ -1936,6 +1990,9 @@ void JS_FreeRuntime(JSRuntime *rt)
        FinalizationRegistry */
     JS_RunGCInternal(rt, FALSE);
 
+    js_free_opcode_profile(rt);
+    js_free_cpu_profiler(rt);
+
 #ifdef DUMP_LEAKS
     /* leaking objects */
     {
@@ -3913,6 +3970,57 @@ static JSValue JS_ConcatString3(JSContext *ctx, const char *str1,
     return JS_EXCEPTION;
 }
 
+/* create a string from a UTF-16 buffer. The string is stored with 8
+   bit characters if all the code units are Latin-1. */
+JSValue JS_NewStringUTF16(JSContext *ctx, const uint16_t *buf, size_t len)
+{
+    JSString *str;
+    size_t i;
+
+    if (len > JS_STRING_LEN_MAX)
+        return JS_ThrowInternalError(ctx, "string too long");
+    for(i = 0; i < len; i++) {
+        if (buf[i] >= 0x100)
+            return js_new_string16_len(ctx, buf, len);
+    }
+    if (len == 0)
+        return JS_AtomToString(ctx, JS_ATOM_empty_string);
+    str = js_alloc_string(ctx, len, 0);
+    if (!str)
+        return JS_EXCEPTION;
+    for(i = 0; i < len; i++)
+        str->u.str8[i] = buf[i];
+    str->u.str8[len] = '\0';
+    return JS_MKPTR(JS_TAG_STRING, str);
+}
+
+/* create a string from a Latin-1 buffer */
+JSValue JS_NewStringLatin1(JSContext *ctx, const uint8_t *buf, size_t len)
+{
+    if (len > JS_STRING_LEN_MAX)
+        return JS_ThrowInternalError(ctx, "string too long");
+    return js_new_string8_len(ctx, (const char *)buf, len);
+}
+
+/* return the internal characters of a string value without copying:
+   Latin-1 bytes if '*pis_wide_char' is FALSE, UTF-16 code units
+   otherwise. Return NULL if 'val' is not a linear string (use
+   JS_ToString() first). The pointer is valid while 'val' is alive. */
+const void *JS_GetStringBuffer(JSValueConst val, size_t *plen, JS_BOOL *pis_wide_char)
+{
+    JSString *p;
+
+    if (JS_VALUE_GET_TAG(val) != JS_TAG_STRING)
+        return NULL;
+    p = JS_VALUE_GET_STRING(val);
+    *plen = p->len;
+    *pis_wide_char = p->is_wide_char;
+    if (p->is_wide_char)
+        return p->u.str16;
+    else
+        return p->u.str8;
+}
+
 JSValue JS_NewAtomString(JSContext *ctx, const char *str)
 {
     JSAtom atom = JS_NewAtom(ctx, str);
@@ -6027,6 +6135,10 @@ static void mark_children(JSRuntime *rt, JSGCObjectHeader *gp,
             }
             if (b->realm)
                 mark_func(rt, &b->realm->header);
+            /* the cached shapes reference their prototypes */
+            for(i = 0; i < b->ic_count; i++) {
+                js_inline_cache_mark(rt, &b->ic[i], mark_func);
+            }
         }
         break;
     case JS_GC_OBJ_TYPE_VAR_REF:
@@ -6296,6 +6408,16 @@ static void compute_bytecode_size(JSFunctionBytecode *b, JSMemoryUsage_helper *h
     if (b->closure_var) {
         js_func_size += b->closure_var_count * sizeof(*b->closure_var);
     }
+    if (b->ic) {
+        memory_used_count++;
+        js_func_size += b->ic_count * sizeof(*b->ic);
+        for (i = 0; i < b->ic_count; i++) {
+            if (b->ic[i].entries) {
+                memory_used_count++;
+                js_func_size += b->ic[i].count * sizeof(*b->ic[i].entries);
+            }
+        }
+    }
     if (!b->read_only_bytecode && b->byte_code_buf) {
         hp->js_func_code_size += b->byte_code_len;
     }
@@ -6733,6 +6855,30 @@ void JS_DumpMemoryUsage(FILE *fp, const JSMemoryUsage *s, JSRuntime *rt)
         fprintf(fp, "%-20s %8"PRId64" %8"PRId64"\n",
                 "binary objects", s->binary_object_count, s->binary_object_size);
     }
+    if (rt) {
+        const JSInlineCacheStats *ic = &rt->ic_stats;
+        if (ic->get_hits + ic->get_misses + ic->put_hits + ic->put_misses +
+            ic->global_hits + ic->global_misses) {
+            fprintf(fp, "\n%-20s %8s %8s\n", "INLINE CACHES", "HITS", "MISSES");
+            fprintf(fp, "%-20s %8"PRId64" %8"PRId64"\n",
+                    "get_field", ic->get_hits, ic->get_misses);
+            fprintf(fp, "%-20s %8"PRId64" %8"PRId64"\n",
+                    "put_field", ic->put_hits, ic->put_misses);
+            fprintf(fp, "%-20s %8"PRId64" %8"PRId64"\n",
+                    "global var", ic->global_hits, ic->global_misses);
+            fprintf(fp, "%-20s %8"PRId64"\n", "megamorphic", ic->megamorphic_count);
+        }
+    }
+}
+
+void JS_GetInlineCacheStats(JSRuntime *rt, JSInlineCacheStats *s)
+{
+    *s = rt->ic_stats;
+}
+
+void JS_ResetInlineCacheStats(JSRuntime *rt)
+{
+    memset(&rt->ic_stats, 0, sizeof(rt->ic_stats));
 }
 
 JSValue JS_GetGlobalObject(JSContext *ctx)
@@ -7224,10 +7370,432 @@ static void JS_ThrowInterrupted(JSContext *ctx)
     JS_SetUncatchableException(ctx, TRUE);
 }
 
+/* sampling CPU profiler */
+
+#define JS_CPU_PROFILE_MAX_DEPTH   128
+/* about 17 minutes at a 1 ms interval */
+#define JS_CPU_PROFILE_MAX_SAMPLES (1 << 20)
+
+typedef struct JSCPUProfileTick {
+    int line_num;
+    int count;
+} JSCPUProfileTick;
+
+/* node of the call tree. The frames are identified by the function
+   name and definition position. */
+typedef struct JSCPUProfileNode {
+    int parent; /* -1 for the root */
+    int first_child, next_sibling; /* -1 if none */
+    JSAtom func_name;
+    JSAtom filename; /* JS_ATOM_NULL for the native functions */
+    int line_num, col_num; /* function position, 0 if unknown */
+    int hit_count;
+    /* samples of the node per source line */
+    int tick_count, tick_size;
+    JSCPUProfileTick *ticks;
+} JSCPUProfileNode;
+
+typedef struct JSCPUProfileSample {
+    int node;
+    int time_delta; /* in us, since the previous sample */
+} JSCPUProfileSample;
+
+/* node indexes */
+#define JS_CPU_PROFILE_ROOT 0
+#define JS_CPU_PROFILE_IDLE 1
+
+typedef struct JSCPUProfiler {
+    BOOL running;
+    int interval_us;
+    /* in us */
+    int64_t start_time, end_time;
+    int64_t last_time; /* time of the last sample */
+    int64_t enter_time; /* last time the JS code was entered */
+    int node_count, node_size;
+    JSCPUProfileNode *nodes;
+    int sample_count, sample_size;
+    JSCPUProfileSample *samples;
+} JSCPUProfiler;
+
+typedef struct JSCPUProfileFrame {
+    JSAtom func_name;
+    JSAtom filename;
+    int line_num, col_num;
+    int cur_line_num; /* 0 if unknown */
+} JSCPUProfileFrame;
+
+static int64_t js_cpu_profile_time_us(void)
+{
+#if defined(_WIN32)
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/* the profiler must not throw exceptions, so js_resize_array() is not used */
+static int js_cpu_profile_resize(JSRuntime *rt, void **parray, int elem_size,
+                                 int *psize, int req_size)
+{
+    int new_size;
+    void *new_array;
+
+    if (req_size <= *psize)
+        return 0;
+    new_size = max_int(req_size, *psize * 3 / 2);
+    new_size = max_int(new_size, 16);
+    new_array = js_realloc_rt(rt, *parray, (size_t)new_size * elem_size);
+    if (!new_array)
+        return -1;
+    *parray = new_array;
+    *psize = new_size;
+    return 0;
+}
+
+static void js_free_cpu_profiler(JSRuntime *rt)
+{
+    JSCPUProfiler *prof = rt->cpu_profiler;
+    int i;
+
+    if (!prof)
+        return;
+    for(i = 0; i < prof->node_count; i++) {
+        JS_FreeAtomRT(rt, prof->nodes[i].func_name);
+        JS_FreeAtomRT(rt, prof->nodes[i].filename);
+        js_free_rt(rt, prof->nodes[i].ticks);
+    }
+    js_free_rt(rt, prof->nodes);
+    js_free_rt(rt, prof->samples);
+    js_free_rt(rt, prof);
+    rt->cpu_profiler = NULL;
+}
+
+/* return the node index or -1 if no memory */
+static int js_cpu_profile_add_node(JSRuntime *rt, JSCPUProfiler *prof,
+                                   int parent, JSAtom func_name,
+                                   JSAtom filename, int line_num, int col_num)
+{
+    JSCPUProfileNode *n;
+    int idx;
+
+    if (js_cpu_profile_resize(rt, (void **)&prof->nodes, sizeof(prof->nodes[0]),
+                              &prof->node_size, prof->node_count + 1))
+        return -1;
+    idx = prof->node_count++;
+    n = &prof->nodes[idx];
+    memset(n, 0, sizeof(*n));
+    n->parent = parent;
+    n->first_child = -1;
+    n->next_sibling = -1;
+    n->func_name = JS_DupAtomRT(rt, func_name);
+    n->filename = JS_DupAtomRT(rt, filename);
+    n->line_num = line_num;
+    n->col_num = col_num;
+    if (parent >= 0) {
+        n->next_sibling = prof->nodes[parent].first_child;
+        prof->nodes[parent].first_child = idx;
+    }
+    return idx;
+}
+
+int JS_StartCPUProfiler(JSRuntime *rt, int interval_us)
+{
+    JSCPUProfiler *prof;
+
+    js_free_cpu_profiler(rt);
+    prof = js_mallocz_rt(rt, sizeof(*prof));
+    if (!prof)
+        return -1;
+    rt->cpu_profiler = prof;
+    if (js_cpu_profile_add_node(rt, prof, -1, JS_ATOM_NULL, JS_ATOM_NULL,
+                                0, 0) != JS_CPU_PROFILE_ROOT ||
+        js_cpu_profile_add_node(rt, prof, JS_CPU_PROFILE_ROOT, JS_ATOM_NULL,
+                                JS_ATOM_NULL, 0, 0) != JS_CPU_PROFILE_IDLE) {
+        js_free_cpu_profiler(rt);
+        return -1;
+    }
+    prof->interval_us = max_int(interval_us, 1);
+    prof->start_time = js_cpu_profile_time_us();
+    prof->last_time = prof->start_time;
+    prof->enter_time = prof->start_time;
+    prof->end_time = prof->start_time;
+    rt->cpu_sample_request = 0;
+    prof->running = TRUE;
+    return 0;
+}
+
+void JS_StopCPUProfiler(JSRuntime *rt)
+{
+    JSCPUProfiler *prof = rt->cpu_profiler;
+    if (prof && prof->running) {
+        prof->running = FALSE;
+        prof->end_time = js_cpu_profile_time_us();
+    }
+}
+
+BOOL JS_IsCPUProfilerRunning(JSRuntime *rt)
+{
+    return rt->cpu_profiler && rt->cpu_profiler->running;
+}
+
+/* Only stores the request time (a 32 bit atomic), so it can be called
+   from a signal handler or from another thread. The sample is taken by
+   the JS thread at its next interrupt check, i.e. at a function call
+   or at a backward jump. */
+void JS_RequestCPUProfileSample(JSRuntime *rt)
+{
+    uint32_t t = (uint32_t)js_cpu_profile_time_us();
+    __atomic_store_n(&rt->cpu_sample_request, t ? t : 1, __ATOMIC_RELAXED);
+}
+
+/* called when the JS code is entered from outside */
+static no_inline void js_cpu_profile_enter(JSRuntime *rt)
+{
+    rt->cpu_profiler->enter_time = js_cpu_profile_time_us();
+}
+
+static int js_cpu_profile_add_sample(JSRuntime *rt, JSCPUProfiler *prof,
+                                     int node, int64_t time)
+{
+    JSCPUProfileSample *sample;
+
+    if (js_cpu_profile_resize(rt, (void **)&prof->samples, sizeof(prof->samples[0]),
+                              &prof->sample_size, prof->sample_count + 1))
+        return -1;
+    sample = &prof->samples[prof->sample_count++];
+    sample->node = node;
+    sample->time_delta = time - prof->last_time;
+    prof->last_time = time;
+    prof->nodes[node].hit_count++;
+    return 0;
+}
+
+static void js_cpu_profile_get_frame(JSContext *ctx, JSStackFrame *sf,
+                                     JSCPUProfileFrame *f)
+{
+    JSObject *p;
+    const char *name;
+
+    f->func_name = JS_ATOM_NULL;
+    f->filename = JS_ATOM_NULL;
+    f->line_num = 0;
+    f->col_num = 0;
+    f->cur_line_num = 0;
+    if (JS_VALUE_GET_TAG(sf->cur_func) != JS_TAG_OBJECT)
+        return;
+    p = JS_VALUE_GET_OBJ(sf->cur_func);
+    if (js_class_has_bytecode(p->class_id)) {
+        JSFunctionBytecode *b = p->u.func.function_bytecode;
+        int col_num;
+        f->func_name = JS_DupAtom(ctx, b->func_name);
+        if (b->has_debug) {
+            f->filename = JS_DupAtom(ctx, b->debug.filename);
+            f->line_num = find_line_num(ctx, b, -1, &f->col_num);
+            if (sf->cur_pc) {
+                f->cur_line_num = find_line_num(ctx, b,
+                                                sf->cur_pc - b->byte_code_buf - 1,
+                                                &col_num);
+            }
+        }
+    } else {
+        name = get_func_name(ctx, sf->cur_func);
+        if (name) {
+            f->func_name = JS_NewAtom(ctx, name);
+            JS_FreeCString(ctx, name);
+        }
+    }
+}
+
+/* called by the JS thread when a sample was requested */
+static void js_cpu_profile_sample(JSContext *ctx, uint32_t request_time)
+{
+    JSRuntime *rt = ctx->rt;
+    JSCPUProfiler *prof = rt->cpu_profiler;
+    JSCPUProfileFrame frames[JS_CPU_PROFILE_MAX_DEPTH], *f;
+    JSCPUProfileNode *n;
+    JSStackFrame *sf;
+    int64_t now;
+    int depth, i, idx, child;
+
+    if (!prof || !prof->running ||
+        prof->sample_count >= JS_CPU_PROFILE_MAX_SAMPLES - 1 ||
+        !rt->current_stack_frame)
+        return;
+    /* a request made while no JS code was running is ignored */
+    if ((int32_t)(request_time - (uint32_t)prof->enter_time) < 0)
+        return;
+    now = js_cpu_profile_time_us();
+    if (prof->enter_time > prof->last_time + prof->interval_us) {
+        /* the time between the previous sample and this one was
+           mostly spent outside of JS */
+        if (js_cpu_profile_add_sample(rt, prof, JS_CPU_PROFILE_IDLE,
+                                      prof->last_time + prof->interval_us))
+            return;
+    }
+
+    /* innermost frames first */
+    depth = 0;
+    for(sf = rt->current_stack_frame; sf != NULL && depth < countof(frames);
+        sf = sf->prev_frame) {
+        js_cpu_profile_get_frame(ctx, sf, &frames[depth++]);
+    }
+
+    idx = JS_CPU_PROFILE_ROOT;
+    for(i = depth - 1; i >= 0; i--) {
+        f = &frames[i];
+        for(child = prof->nodes[idx].first_child; child >= 0;
+            child = prof->nodes[child].next_sibling) {
+            n = &prof->nodes[child];
+            if (child != JS_CPU_PROFILE_IDLE &&
+                n->func_name == f->func_name && n->filename == f->filename &&
+                n->line_num == f->line_num && n->col_num == f->col_num)
+                break;
+        }
+        if (child < 0) {
+            child = js_cpu_profile_add_node(rt, prof, idx, f->func_name,
+                                            f->filename, f->line_num,
+                                            f->col_num);
+            if (child < 0)
+                goto done;
+        }
+        idx = child;
+    }
+
+    if (js_cpu_profile_add_sample(rt, prof, idx, now))
+        goto done;
+    n = &prof->nodes[idx];
+    if (depth > 0 && frames[0].cur_line_num > 0) {
+        for(i = 0; i < n->tick_count; i++) {
+            if (n->ticks[i].line_num == frames[0].cur_line_num)
+                break;
+        }
+        if (i == n->tick_count) {
+            if (js_cpu_profile_resize(rt, (void **)&n->ticks, sizeof(n->ticks[0]),
+                                      &n->tick_size, n->tick_count + 1))
+                goto done;
+            n->ticks[i].line_num = frames[0].cur_line_num;
+            n->ticks[i].count = 0;
+            n->tick_count++;
+        }
+        n->ticks[i].count++;
+    }
+ done:
+    for(i = 0; i < depth; i++) {
+        JS_FreeAtom(ctx, frames[i].func_name);
+        JS_FreeAtom(ctx, frames[i].filename);
+    }
+}
+
+static void js_cpu_profile_put_atom(JSRuntime *rt, DynBuf *s, JSAtom atom)
+{
+    char buf[256];
+    const char *str;
+    int c;
+
+    str = atom == JS_ATOM_NULL ? "" : JS_AtomGetStrRT(rt, buf, sizeof(buf), atom);
+    dbuf_putc(s, '\"');
+    for(; *str; str++) {
+        c = (uint8_t)*str;
+        if (c == '\"' || c == '\\')
+            dbuf_printf(s, "\\%c", c);
+        else if (c < 0x20)
+            dbuf_printf(s, "\\u%04x", c);
+        else
+            dbuf_putc(s, c);
+    }
+    dbuf_putc(s, '\"');
+}
+
+/* Chrome DevTools .cpuprofile format */
+char *JS_GetCPUProfile(JSRuntime *rt, size_t *plen)
+{
+    JSCPUProfiler *prof = rt->cpu_profiler;
+    JSCPUProfileNode *n;
+    DynBuf dbuf, *s = &dbuf;
+    int i, j, child;
+    int64_t end_time;
+
+    if (!prof)
+        return NULL;
+    end_time = prof->running ? js_cpu_profile_time_us() : prof->end_time;
+    dbuf_init2(s, rt, (DynBufReallocFunc *)js_realloc_rt);
+    dbuf_putstr(s, "{\"nodes\":[");
+    for(i = 0; i < prof->node_count; i++) {
+        n = &prof->nodes[i];
+        if (i != 0)
+            dbuf_putc(s, ',');
+        dbuf_printf(s, "{\"id\":%d,\"callFrame\":{\"functionName\":", i + 1);
+        if (i == JS_CPU_PROFILE_ROOT) {
+            dbuf_putstr(s, "\"(root)\"");
+        } else if (i == JS_CPU_PROFILE_IDLE) {
+            dbuf_putstr(s, "\"(idle)\"");
+        } else if (n->func_name == JS_ATOM_NULL && n->filename == JS_ATOM_NULL) {
+            /* anonymous native function */
+            dbuf_putstr(s, "\"(native)\"");
+        } else {
+            js_cpu_profile_put_atom(rt, s, n->func_name);
+        }
+        /* the script ids only need to be consistent with the urls */
+        dbuf_printf(s, ",\"scriptId\":\"%u\",\"url\":", n->filename);
+        js_cpu_profile_put_atom(rt, s, n->filename);
+        dbuf_printf(s, ",\"lineNumber\":%d,\"columnNumber\":%d},\"hitCount\":%d",
+                    n->line_num - 1, n->col_num - 1, n->hit_count);
+        dbuf_putstr(s, ",\"children\":[");
+        for(child = n->first_child; child >= 0; child = prof->nodes[child].next_sibling) {
+            dbuf_printf(s, "%s%d", child == n->first_child ? "" : ",", child + 1);
+        }
+        dbuf_putc(s, ']');
+        if (n->tick_count != 0) {
+            dbuf_putstr(s, ",\"positionTicks\":[");
+            for(j = 0; j < n->tick_count; j++) {
+                dbuf_printf(s, "%s{\"line\":%d,\"ticks\":%d}", j == 0 ? "" : ",",
+                            n->ticks[j].line_num, n->ticks[j].count);
+            }
+            dbuf_putc(s, ']');
+        }
+        dbuf_putc(s, '}');
+    }
+    dbuf_printf(s, "],\"startTime\":%" PRId64 ",\"endTime\":%" PRId64 ",\"samples\":[",
+                prof->start_time, end_time);
+    for(i = 0; i < prof->sample_count; i++)
+        dbuf_printf(s, "%s%d", i == 0 ? "" : ",", prof->samples[i].node + 1);
+    dbuf_putstr(s, "],\"timeDeltas\":[");
+    for(i = 0; i < prof->sample_count; i++)
+        dbuf_printf(s, "%s%d", i == 0 ? "" : ",", prof->samples[i].time_delta);
+    dbuf_putstr(s, "]}");
+    dbuf_putc(s, '\0');
+    if (dbuf_error(s)) {
+        dbuf_free(s);
+        return NULL;
+    }
+    if (plen)
+        *plen = s->size - 1;
+    return (char *)s->buf;
+}
+
 static no_inline __exception int __js_poll_interrupts(JSContext *ctx)
 {
     JSRuntime *rt = ctx->rt;
-    ctx->interrupt_counter = JS_INTERRUPT_COUNTER_INIT;
+    if (rt->cpu_profiler && rt->cpu_profiler->running) {
+        uint32_t request_time;
+        request_time = __atomic_exchange_n(&rt->cpu_sample_request, 0,
+                                           __ATOMIC_RELAXED);
+        if (request_time)
+            js_cpu_profile_sample(ctx, request_time);
+        /* the requests are checked more often, but interrupt_handler
+           is still called every JS_INTERRUPT_COUNTER_INIT ticks */
+        ctx->interrupt_counter = JS_CPU_PROFILE_COUNTER_INIT;
+        ctx->interrupt_ticks += JS_CPU_PROFILE_COUNTER_INIT;
+        if (ctx->interrupt_ticks < JS_INTERRUPT_COUNTER_INIT)
+            return 0;
+        ctx->interrupt_ticks = 0;
+    } else {
+        ctx->interrupt_counter = JS_INTERRUPT_COUNTER_INIT;
+    }
     if (rt->interrupt_handler) {
         if (rt->interrupt_handler(rt, rt->interrupt_opaque)) {
             JS_ThrowInterrupted(ctx);
@@ -7246,6 +7814,20 @@ static inline __exception int js_poll_interrupts(JSContext *ctx)
     }
 }
 
+/* same as js_poll_interrupts() but the PC of the running bytecode
+   function is saved so that the CPU profiler can find its line */
+static inline __exception int js_poll_interrupts_pc(JSContext *ctx,
+                                                    JSStackFrame *sf,
+                                                    const uint8_t *pc)
+{
+    if (unlikely(--ctx->interrupt_counter <= 0)) {
+        sf->cur_pc = pc;
+        return __js_poll_interrupts(ctx);
+    } else {
+        return 0;
+    }
+}
+
 static void JS_SetImmutablePrototype(JSContext *ctx, JSValueConst obj)
 {
     JSObject *p;
@@ -8547,6 +9129,14 @@ static JSProperty *add_property(JSContext *ctx,
             js_free_shape(ctx->rt, p->shape);
             p->shape = new_sh;
         }
+    } else if (sh->header.ref_count != 1) {
+        /* the shape is referenced by an inline cache: it must not be
+           modified */
+        new_sh = js_clone_shape(ctx, sh);
+        if (!new_sh)
+            return NULL;
+        js_free_shape(ctx->rt, p->shape);
+        p->shape = new_sh;
     }
     assert(p->shape->header.ref_count == 1);
     if (add_shape_property(ctx, &p->shape, p, prop, prop_flags))
@@ -9495,22 +10085,21 @@ static int js_shape_prepare_update(JSContext *ctx, JSObject *p,
     uint32_t idx = 0;    /* prevent warning */
 
     sh = p->shape;
-    if (sh->is_hashed) {
-        if (sh->header.ref_count != 1) {
-            if (pprs)
-                idx = *pprs - get_shape_prop(sh);
-            /* clone the shape (the resulting one is no longer hashed) */
-            sh = js_clone_shape(ctx, sh);
-            if (!sh)
-                return -1;
-            js_free_shape(ctx->rt, p->shape);
-            p->shape = sh;
-            if (pprs)
-                *pprs = get_shape_prop(sh) + idx;
-        } else {
-            js_shape_hash_unlink(ctx->rt, sh);
-            sh->is_hashed = FALSE;
-        }
+    /* a non hashed shape can be shared with the inline caches */
+    if (sh->header.ref_count != 1) {
+        if (pprs)
+            idx = *pprs - get_shape_prop(sh);
+        /* clone the shape (the resulting one is no longer hashed) */
+        sh = js_clone_shape(ctx, sh);
+        if (!sh)
+            return -1;
+        js_free_shape(ctx->rt, p->shape);
+        p->shape = sh;
+        if (pprs)
+            *pprs = get_shape_prop(sh) + idx;
+    } else if (sh->is_hashed) {
+        js_shape_hash_unlink(ctx->rt, sh);
+        sh->is_hashed = FALSE;
     }
     return 0;
 }
@@ -16583,6 +17172,8 @@ static JSValue js_call_c_function(JSContext *ctx, JSValueConst func_obj,
         return JS_ThrowStackOverflow(ctx);
 
     prev_sf = rt->current_stack_frame;
+    if (unlikely(!prev_sf && rt->cpu_profiler))
+        js_cpu_profile_enter(rt);
     sf->prev_frame = prev_sf;
     rt->current_stack_frame = sf;
     ctx = p->u.cfunc.realm; /* change the current realm */
@@ -16723,6 +17314,798 @@ static JSValue js_call_bound_function(JSContext *ctx, JSValueConst func_obj,
     }
 }
 
+/* Inline caches: at function creation, OP_get_field, OP_get_field2
+   and OP_put_field are rewritten to their _ic forms whose operand is
+   an index in JSFunctionBytecode.ic. Each cache records up to
+   IC_MAX_ENTRIES receiver shapes with the index of a plain data
+   property, either own or inherited from a prototype. put_field caches
+   writable own properties and the shape transition when the property
+   is added. The global variable accesses use a single entry, see
+   js_global_cache_lookup(). */
+
+static void js_inline_cache_free_entry(JSRuntime *rt, JSInlineCacheEntry *e)
+{
+    int k;
+    for(k = 0; k <= e->depth; k++)
+        js_free_shape(rt, e->shapes[k]);
+    if (e->new_shape)
+        js_free_shape(rt, e->new_shape);
+}
+
+static void js_free_inline_caches(JSRuntime *rt, JSFunctionBytecode *b)
+{
+    JSInlineCache *ic;
+    int i, j;
+
+    for(i = 0; i < b->ic_count; i++) {
+        ic = &b->ic[i];
+        JS_FreeAtomRT(rt, ic->atom);
+        for(j = 0; j < ic->count; j++)
+            js_inline_cache_free_entry(rt, &ic->entries[j]);
+        js_free_rt(rt, ic->entries);
+    }
+    js_free_rt(rt, b->ic);
+}
+
+static void js_inline_cache_mark(JSRuntime *rt, JSInlineCache *ic,
+                                 JS_MarkFunc *mark_func)
+{
+    JSInlineCacheEntry *e;
+    int i, k;
+
+    for(i = 0; i < ic->count; i++) {
+        e = &ic->entries[i];
+        for(k = 0; k <= e->depth; k++)
+            mark_func(rt, &e->shapes[k]->header);
+        if (e->new_shape)
+            mark_func(rt, &e->new_shape->header);
+    }
+}
+
+/* TRUE if the exotic behavior of 'p' has no effect on the lookup of
+   an atom accepted by js_inline_cache_atom_ok() */
+static BOOL js_inline_cache_is_ordinary(JSRuntime *rt, JSObject *p)
+{
+    return !p->is_exotic || p->fast_array ||
+        !rt->class_array[p->class_id].exotic;
+}
+
+/* record the receiver shape 'sh' and the shapes of its 'depth' first
+   prototypes. For get_field, the property 'prop_index' of the last one
+   holds 'ic->atom'. For put_field, 'new_shape' is the shape after
+   adding the property or NULL if it is an own property of
+   'sh'. Return FALSE if the cache cannot be updated. */
+static BOOL js_inline_cache_update(JSRuntime *rt, JSInlineCache *ic,
+                                   JSShape *sh, int depth, uint32_t prop_index,
+                                   JSShape *new_shape)
+{
+    JSInlineCacheEntry e1, *e;
+    int i, k;
+
+    for(i = 0; i < ic->count; i++) {
+        /* stale entry for the same receiver shape */
+        if (ic->entries[i].shapes[0] == sh)
+            break;
+    }
+    if (i == ic->count) {
+        if (ic->count < IC_MAX_ENTRIES) {
+            e = js_realloc_rt(rt, ic->entries,
+                              sizeof(ic->entries[0]) * (ic->count + 1));
+            if (!e)
+                return FALSE;
+            ic->entries = e;
+        } else {
+            i = ic->updates % IC_MAX_ENTRIES;
+        }
+    }
+    for(k = 0; k <= depth; k++) {
+        e1.shapes[k] = js_dup_shape(sh);
+        if (sh->proto)
+            sh = sh->proto->shape;
+    }
+    e1.new_shape = new_shape ? js_dup_shape(new_shape) : NULL;
+    e1.depth = depth;
+    e1.prop_index = prop_index;
+    if (i == ic->count)
+        ic->count++;
+    else
+        js_inline_cache_free_entry(rt, &ic->entries[i]);
+    ic->entries[i] = e1;
+    if (++ic->updates == IC_MAX_UPDATES)
+        rt->ic_stats.megamorphic_count++;
+    return TRUE;
+}
+
+static force_inline JSProperty *js_inline_cache_get(JSRuntime *rt,
+                                                    JSInlineCache *ic,
+                                                    JSObject *p)
+{
+    JSInlineCacheEntry *e;
+    JSShape *sh = p->shape;
+    int i, k;
+
+    for(i = 0, e = ic->entries; i < ic->count; i++, e++) {
+        if (e->shapes[0] == sh) {
+            if (e->depth != 0) {
+                if (unlikely(!js_inline_cache_is_ordinary(rt, p)))
+                    return NULL;
+                for(k = 1; k <= e->depth; k++) {
+                    p = e->shapes[k - 1]->proto;
+                    if (p->shape != e->shapes[k])
+                        return NULL;
+                }
+            }
+            rt->ic_stats.get_hits++;
+            return &p->prop[e->prop_index];
+        }
+    }
+    return NULL;
+}
+
+/* same as the fast path of add_property() when the next shape is
+   already known. Return 0 if the entry no longer applies. */
+static int js_inline_cache_add_property(JSContext *ctx, JSInlineCacheEntry *e,
+                                        JSObject *p, JSValue val)
+{
+    JSShape *sh = p->shape, *new_sh = e->new_shape;
+    JSProperty *new_prop;
+    JSObject *p1;
+    int k;
+
+    if (unlikely(!p->extensible || p->is_exotic))
+        return 0;
+    /* a prototype may have defined the property */
+    for(k = 1; k <= e->depth; k++) {
+        p1 = e->shapes[k - 1]->proto;
+        if (p1->shape != e->shapes[k])
+            return 0;
+    }
+    if (new_sh->prop_size != sh->prop_size) {
+        new_prop = js_realloc(ctx, p->prop, sizeof(p->prop[0]) *
+                              new_sh->prop_size);
+        if (!new_prop) {
+            JS_FreeValue(ctx, val);
+            return -1;
+        }
+        p->prop = new_prop;
+    }
+    p->shape = js_dup_shape(new_sh);
+    js_free_shape(ctx->rt, sh);
+    p->prop[new_sh->prop_count - 1].u.value = val;
+    ctx->rt->ic_stats.put_hits++;
+    return 1;
+}
+
+/* return 1 if 'val' was stored (it is then freed), 0 if the cache does
+   not apply and -1 if exception */
+static force_inline int js_inline_cache_put(JSContext *ctx, JSInlineCache *ic,
+                                            JSObject *p, JSValue val)
+{
+    JSInlineCacheEntry *e;
+    JSShape *sh = p->shape;
+    int i;
+
+    for(i = 0, e = ic->entries; i < ic->count; i++, e++) {
+        if (e->shapes[0] == sh) {
+            if (e->new_shape)
+                return js_inline_cache_add_property(ctx, e, p, val);
+            ctx->rt->ic_stats.put_hits++;
+            set_value(ctx, &p->prop[e->prop_index].u.value, val);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static JSValue js_inline_cache_get_slow(JSContext *ctx, JSInlineCache *ic,
+                                        JSValueConst obj)
+{
+    JSRuntime *rt = ctx->rt;
+    JSObject *p, *p1;
+    JSProperty *pr;
+    JSShapeProperty *prs;
+    int depth;
+
+    rt->ic_stats.get_misses++;
+    if (JS_VALUE_GET_TAG(obj) == JS_TAG_OBJECT &&
+        ic->updates < IC_MAX_UPDATES) {
+        p = JS_VALUE_GET_OBJ(obj);
+        p1 = p;
+        for(depth = 0;; depth++) {
+            prs = find_own_property(&pr, p1, ic->atom);
+            if (prs) {
+                if (!(prs->flags & JS_PROP_TMASK) &&
+                    js_inline_cache_update(rt, ic, p->shape, depth,
+                                           prs - get_shape_prop(p1->shape),
+                                           NULL))
+                    return JS_DupValue(ctx, pr->u.value);
+                break;
+            }
+            if (depth == IC_MAX_DEPTH || !js_inline_cache_is_ordinary(rt, p1))
+                break;
+            p1 = p1->shape->proto;
+            if (!p1)
+                break;
+        }
+    }
+    return JS_GetProperty(ctx, obj, ic->atom);
+}
+
+/* return the number of prototypes of 'sh' or -1 if setting 'atom' on
+   an object of shape 'sh' may do more than adding an own property */
+static int js_inline_cache_proto_depth(JSRuntime *rt, JSShape *sh, JSAtom atom)
+{
+    JSObject *p;
+    JSProperty *pr;
+    int depth;
+
+    depth = 0;
+    for(p = sh->proto; p != NULL; p = p->shape->proto) {
+        if (++depth > IC_MAX_DEPTH ||
+            find_own_property(&pr, p, atom) ||
+            !js_inline_cache_is_ordinary(rt, p))
+            return -1;
+    }
+    return depth;
+}
+
+/* 'val' is freed */
+static int js_inline_cache_put_slow(JSContext *ctx, JSInlineCache *ic,
+                                    JSValueConst obj, JSValue val)
+{
+    JSRuntime *rt = ctx->rt;
+    JSObject *p;
+    JSProperty *pr;
+    JSShapeProperty *prs;
+    JSShape *sh;
+    int depth;
+
+    rt->ic_stats.put_misses++;
+    if (JS_VALUE_GET_TAG(obj) == JS_TAG_OBJECT &&
+        ic->updates < IC_MAX_UPDATES) {
+        p = JS_VALUE_GET_OBJ(obj);
+        sh = p->shape;
+        prs = find_own_property(&pr, p, ic->atom);
+        if (prs) {
+            if ((prs->flags & (JS_PROP_TMASK | JS_PROP_WRITABLE |
+                               JS_PROP_LENGTH)) == JS_PROP_WRITABLE &&
+                js_inline_cache_update(rt, ic, sh, 0,
+                                       prs - get_shape_prop(sh), NULL)) {
+                set_value(ctx, &pr->u.value, val);
+                return TRUE;
+            }
+        } else if (p->extensible && !p->is_exotic && sh->is_hashed &&
+                   (depth = js_inline_cache_proto_depth(rt, sh, ic->atom)) >= 0) {
+            /* the reference to 'sh' ensures that add_property() creates
+               a new shape instead of modifying it */
+            js_dup_shape(sh);
+            pr = add_property(ctx, p, ic->atom, JS_PROP_C_W_E);
+            if (unlikely(!pr)) {
+                js_free_shape(rt, sh);
+                JS_FreeValue(ctx, val);
+                return -1;
+            }
+            pr->u.value = val;
+            if (p->shape->is_hashed)
+                js_inline_cache_update(rt, ic, sh, depth, 0, p->shape);
+            js_free_shape(rt, sh);
+            return TRUE;
+        }
+    }
+    return JS_SetPropertyInternal(ctx, obj, ic->atom, val, obj,
+                                  JS_PROP_THROW_STRICT);
+}
+
+/* A global variable cache entry treats the lexical declarations
+   (global_var_obj) as the receiver and the global object as its
+   prototype: shapes[0] is the shape of global_var_obj and, if depth =
+   1, shapes[1] is the shape of the global object holding the
+   variable. Return NULL if the entry does not apply. The caller must
+   check that a lexical variable is initialized. */
+static force_inline JSProperty *js_global_cache_lookup(JSContext *ctx,
+                                                       JSInlineCache *ic)
+{
+    JSInlineCacheEntry *e = ic->entries;
+    JSObject *p;
+
+    p = JS_VALUE_GET_OBJ(ctx->global_var_obj);
+    if (ic->count == 0 || p->shape != e->shapes[0])
+        return NULL;
+    if (e->depth != 0) {
+        p = JS_VALUE_GET_OBJ(ctx->global_obj);
+        if (p->shape != e->shapes[1])
+            return NULL;
+    }
+    return &p->prop[e->prop_index];
+}
+
+/* look for a data property holding 'ic->atom' in the lexical
+   declarations, then in the global object, and record it if
+   'writable_mask' is satisfied */
+static void js_global_cache_update(JSContext *ctx, JSInlineCache *ic,
+                                   int writable_mask)
+{
+    JSRuntime *rt = ctx->rt;
+    JSObject *var_obj, *p;
+    JSInlineCacheEntry *e;
+    JSShapeProperty *prs;
+    JSProperty *pr;
+    int depth;
+
+    if (ic->updates >= IC_MAX_UPDATES)
+        return;
+    var_obj = JS_VALUE_GET_OBJ(ctx->global_var_obj);
+    p = var_obj;
+    depth = 0;
+    prs = find_own_property(&pr, p, ic->atom);
+    if (!prs) {
+        p = JS_VALUE_GET_OBJ(ctx->global_obj);
+        depth = 1;
+        prs = find_own_property(&pr, p, ic->atom);
+    }
+    if (!prs ||
+        (prs->flags & (JS_PROP_TMASK | writable_mask)) != writable_mask ||
+        JS_IsUninitialized(pr->u.value))
+        return;
+    if (ic->count == 0) {
+        e = js_malloc_rt(rt, sizeof(*e));
+        if (!e)
+            return;
+        ic->entries = e;
+        ic->count = 1;
+    } else {
+        e = ic->entries;
+        js_inline_cache_free_entry(rt, e);
+    }
+    e->shapes[0] = js_dup_shape(var_obj->shape);
+    if (depth != 0)
+        e->shapes[1] = js_dup_shape(p->shape);
+    e->new_shape = NULL;
+    e->depth = depth;
+    e->prop_index = prs - get_shape_prop(p->shape);
+    if (++ic->updates == IC_MAX_UPDATES)
+        rt->ic_stats.megamorphic_count++;
+}
+
+static JSValue js_global_cache_get_slow(JSContext *ctx, JSInlineCache *ic)
+{
+    int ret;
+
+    ctx->rt->ic_stats.global_misses++;
+    js_global_cache_update(ctx, ic, 0);
+    if (ic->opcode == OP_check_var) {
+        ret = JS_CheckGlobalVar(ctx, ic->atom);
+        if (ret < 0)
+            return JS_EXCEPTION;
+        return JS_NewBool(ctx, ret);
+    }
+    return JS_GetGlobalVar(ctx, ic->atom, ic->opcode == OP_get_var);
+}
+
+/* 'val' is freed */
+static int js_global_cache_put_slow(JSContext *ctx, JSInlineCache *ic,
+                                    JSValue val)
+{
+    ctx->rt->ic_stats.global_misses++;
+    js_global_cache_update(ctx, ic, JS_PROP_WRITABLE);
+    return JS_SetGlobalVar(ctx, ic->atom, val,
+                           ic->opcode == OP_put_var_strict ? 2 : 0);
+}
+
+/* opcode profiler */
+
+typedef struct JSFunctionProfile {
+    struct JSFunctionProfile *hash_next;
+    /* the functions with the same name and position share their
+       counters, so the scripts evaluated several times are merged */
+    JSAtom func_name;
+    JSAtom filename; /* JS_ATOM_NULL if no debug info */
+    int line_num, col_num;
+    int64_t call_count;
+    int64_t loop_count; /* backward jumps */
+    int64_t exec_count; /* executed opcodes */
+} JSFunctionProfile;
+
+typedef struct JSOpcodeProfileData {
+    int64_t opcode_count[256];
+    int64_t pair_count[256][256];
+    int func_hash_bits;
+    int func_count;
+    JSFunctionProfile **func_hash;
+} JSOpcodeProfileData;
+
+/* state of the profiler in a JS_CallInternal() activation */
+typedef struct JSProfileState {
+    const uint8_t *prev_pc; /* NULL at the start of the function */
+    int prev_opcode;
+} JSProfileState;
+
+static const char * const opcode_names[OP_COUNT] = {
+#define FMT(f)
+#define DEF(id, size, n_pop, n_push, f) #id,
+#define def(id, size, n_pop, n_push, f)
+#include "quickjs-opcode.h"
+#undef FMT
+};
+
+const char *JS_GetOpcodeName(int opcode)
+{
+    if (opcode < 0 || opcode >= OP_COUNT)
+        return NULL;
+    return opcode_names[opcode];
+}
+
+static uint32_t js_function_profile_hash(JSAtom func_name, JSAtom filename,
+                                         int line_num, int col_num)
+{
+    uint32_t h;
+    h = func_name * 263 + filename;
+    h = h * 263 + line_num;
+    h = h * 263 + col_num;
+    return h * 0x9e3779b1;
+}
+
+static int js_resize_function_profile_hash(JSRuntime *rt,
+                                           JSOpcodeProfileData *prof)
+{
+    JSFunctionProfile **new_hash, *fp, *fp_next;
+    int i, new_bits, old_size;
+    uint32_t h;
+
+    if (prof->func_hash) {
+        old_size = 1 << prof->func_hash_bits;
+        new_bits = prof->func_hash_bits + 1;
+    } else {
+        old_size = 0;
+        new_bits = 6;
+    }
+    new_hash = js_mallocz_rt(rt, sizeof(new_hash[0]) << new_bits);
+    if (!new_hash)
+        return -1;
+    for(i = 0; i < old_size; i++) {
+        for(fp = prof->func_hash[i]; fp != NULL; fp = fp_next) {
+            fp_next = fp->hash_next;
+            h = js_function_profile_hash(fp->func_name, fp->filename,
+                                         fp->line_num, fp->col_num) >> (32 - new_bits);
+            fp->hash_next = new_hash[h];
+            new_hash[h] = fp;
+        }
+    }
+    js_free_rt(rt, prof->func_hash);
+    prof->func_hash = new_hash;
+    prof->func_hash_bits = new_bits;
+    return 0;
+}
+
+void JS_SetOpcodeProfiling(JSRuntime *rt, BOOL enable)
+{
+    JSOpcodeProfileData *prof;
+
+    if (enable && !rt->opcode_profile) {
+        prof = js_mallocz_rt(rt, sizeof(*prof));
+        if (!prof)
+            return;
+        if (js_resize_function_profile_hash(rt, prof)) {
+            js_free_rt(rt, prof);
+            return;
+        }
+        rt->opcode_profile = prof;
+    }
+    rt->opcode_profiling = enable;
+}
+
+BOOL JS_IsOpcodeProfiling(JSRuntime *rt)
+{
+    return rt->opcode_profiling;
+}
+
+void JS_ResetOpcodeProfile(JSRuntime *rt)
+{
+    JSOpcodeProfileData *prof = rt->opcode_profile;
+    JSFunctionProfile *fp;
+    int i;
+
+    if (!prof)
+        return;
+    memset(prof->opcode_count, 0, sizeof(prof->opcode_count));
+    memset(prof->pair_count, 0, sizeof(prof->pair_count));
+    /* the function bytecodes keep a pointer to their entry */
+    for(i = 0; i < (1 << prof->func_hash_bits); i++) {
+        for(fp = prof->func_hash[i]; fp != NULL; fp = fp->hash_next) {
+            fp->call_count = 0;
+            fp->loop_count = 0;
+            fp->exec_count = 0;
+        }
+    }
+}
+
+static void js_free_opcode_profile(JSRuntime *rt)
+{
+    JSOpcodeProfileData *prof = rt->opcode_profile;
+    JSFunctionProfile *fp, *fp_next;
+    int i;
+
+    if (!prof)
+        return;
+    for(i = 0; i < (1 << prof->func_hash_bits); i++) {
+        for(fp = prof->func_hash[i]; fp != NULL; fp = fp_next) {
+            fp_next = fp->hash_next;
+            JS_FreeAtomRT(rt, fp->func_name);
+            JS_FreeAtomRT(rt, fp->filename);
+            js_free_rt(rt, fp);
+        }
+    }
+    js_free_rt(rt, prof->func_hash);
+    js_free_rt(rt, prof);
+    rt->opcode_profile = NULL;
+    rt->opcode_profiling = FALSE;
+}
+
+/* return NULL if out of memory */
+static no_inline JSFunctionProfile *js_get_function_profile(JSRuntime *rt,
+                                                            JSFunctionBytecode *b)
+{
+    JSOpcodeProfileData *prof = rt->opcode_profile;
+    JSFunctionProfile *fp;
+    JSAtom filename;
+    int line_num, col_num;
+    uint32_t h;
+
+    if (b->has_debug) {
+        filename = b->debug.filename;
+        line_num = find_line_num(b->realm, b, -1, &col_num);
+    } else {
+        filename = JS_ATOM_NULL;
+        line_num = 0;
+        col_num = 0;
+    }
+    if (prof->func_count >= (1 << prof->func_hash_bits) * 2) {
+        if (js_resize_function_profile_hash(rt, prof))
+            return NULL;
+    }
+    h = js_function_profile_hash(b->func_name, filename, line_num,
+                                 col_num) >> (32 - prof->func_hash_bits);
+    for(fp = prof->func_hash[h]; fp != NULL; fp = fp->hash_next) {
+        if (fp->func_name == b->func_name && fp->filename == filename &&
+            fp->line_num == line_num && fp->col_num == col_num)
+            goto done;
+    }
+    fp = js_mallocz_rt(rt, sizeof(*fp));
+    if (!fp)
+        return NULL;
+    fp->func_name = JS_DupAtomRT(rt, b->func_name);
+    fp->filename = JS_DupAtomRT(rt, filename);
+    fp->line_num = line_num;
+    fp->col_num = col_num;
+    fp->hash_next = prof->func_hash[h];
+    prof->func_hash[h] = fp;
+    prof->func_count++;
+ done:
+    b->profile = fp;
+    return fp;
+}
+
+static no_inline void js_profile_call(JSRuntime *rt, JSFunctionBytecode *b)
+{
+    JSFunctionProfile *fp = b->profile;
+    if (!fp) {
+        fp = js_get_function_profile(rt, b);
+        if (!fp)
+            return;
+    }
+    fp->call_count++;
+}
+
+/* called before executing the opcode at pc[-1] */
+static no_inline void js_profile_opcode(JSRuntime *rt, JSFunctionBytecode *b,
+                                        JSProfileState *ps, const uint8_t *pc)
+{
+    JSOpcodeProfileData *prof = rt->opcode_profile;
+    JSFunctionProfile *fp;
+    int op = pc[-1];
+
+    prof->opcode_count[op]++;
+    if (ps->prev_pc)
+        prof->pair_count[ps->prev_opcode][op]++;
+    fp = b->profile;
+    if (!fp)
+        fp = js_get_function_profile(rt, b);
+    if (fp) {
+        fp->exec_count++;
+        if (pc <= ps->prev_pc)
+            fp->loop_count++;
+    }
+    ps->prev_pc = pc;
+    ps->prev_opcode = op;
+}
+
+static int js_opcode_profile_entry_cmp(const void *a, const void *b)
+{
+    const JSOpcodeProfileEntry *e1 = a, *e2 = b;
+    if (e1->count != e2->count)
+        return e1->count < e2->count ? 1 : -1;
+    if (e1->opcode != e2->opcode)
+        return e1->opcode - e2->opcode;
+    return e1->next_opcode - e2->next_opcode;
+}
+
+static int js_function_profile_entry_cmp(const void *a, const void *b)
+{
+    const JSFunctionProfileEntry *e1 = a, *e2 = b;
+    if (e1->exec_count != e2->exec_count)
+        return e1->exec_count < e2->exec_count ? 1 : -1;
+    if (e1->call_count != e2->call_count)
+        return e1->call_count < e2->call_count ? 1 : -1;
+    return 0;
+}
+
+static char *js_profile_atom_dup(JSRuntime *rt, JSAtom atom)
+{
+    char buf[256];
+    const char *str;
+    size_t len;
+    char *ret;
+
+    if (atom == JS_ATOM_NULL)
+        str = "";
+    else
+        str = JS_AtomGetStrRT(rt, buf, sizeof(buf), atom);
+    len = strlen(str);
+    ret = js_malloc_rt(rt, len + 1);
+    if (ret)
+        memcpy(ret, str, len + 1);
+    return ret;
+}
+
+void JS_FreeOpcodeProfile(JSRuntime *rt, JSOpcodeProfile *p)
+{
+    int i;
+
+    if (!p)
+        return;
+    for(i = 0; i < p->function_count; i++) {
+        js_free_rt(rt, p->functions[i].func_name);
+        js_free_rt(rt, p->functions[i].filename);
+    }
+    js_free_rt(rt, p->opcodes);
+    js_free_rt(rt, p->pairs);
+    js_free_rt(rt, p->functions);
+    js_free_rt(rt, p);
+}
+
+JSOpcodeProfile *JS_GetOpcodeProfile(JSRuntime *rt, int max_entries)
+{
+    JSOpcodeProfileData *prof = rt->opcode_profile;
+    JSOpcodeProfile *p;
+    JSOpcodeProfileEntry *e;
+    JSFunctionProfileEntry *fe;
+    JSFunctionProfile *fp;
+    int i, j, n;
+
+    if (!prof)
+        return NULL;
+    p = js_mallocz_rt(rt, sizeof(*p));
+    if (!p)
+        return NULL;
+
+    n = 0;
+    for(i = 0; i < 256; i++) {
+        if (prof->opcode_count[i])
+            n++;
+    }
+    p->opcodes = js_malloc_rt(rt, sizeof(p->opcodes[0]) * max_int(n, 1));
+    if (!p->opcodes)
+        goto fail;
+    for(i = 0; i < 256; i++) {
+        if (prof->opcode_count[i]) {
+            e = &p->opcodes[p->opcode_count++];
+            e->opcode = i;
+            e->next_opcode = -1;
+            e->count = prof->opcode_count[i];
+            p->total += e->count;
+        }
+    }
+    qsort(p->opcodes, p->opcode_count, sizeof(p->opcodes[0]),
+          js_opcode_profile_entry_cmp);
+
+    n = 0;
+    for(i = 0; i < 256; i++) {
+        for(j = 0; j < 256; j++) {
+            if (prof->pair_count[i][j])
+                n++;
+        }
+    }
+    p->pairs = js_malloc_rt(rt, sizeof(p->pairs[0]) * max_int(n, 1));
+    if (!p->pairs)
+        goto fail;
+    for(i = 0; i < 256; i++) {
+        for(j = 0; j < 256; j++) {
+            if (prof->pair_count[i][j]) {
+                e = &p->pairs[p->pair_count++];
+                e->opcode = i;
+                e->next_opcode = j;
+                e->count = prof->pair_count[i][j];
+            }
+        }
+    }
+    qsort(p->pairs, p->pair_count, sizeof(p->pairs[0]),
+          js_opcode_profile_entry_cmp);
+
+    p->functions = js_malloc_rt(rt, sizeof(p->functions[0]) *
+                                max_int(prof->func_count, 1));
+    if (!p->functions)
+        goto fail;
+    for(i = 0; i < (1 << prof->func_hash_bits); i++) {
+        for(fp = prof->func_hash[i]; fp != NULL; fp = fp->hash_next) {
+            if (!fp->call_count && !fp->exec_count)
+                continue;
+            fe = &p->functions[p->function_count];
+            fe->func_name = NULL;
+            fe->filename = NULL;
+            fe->line_num = fp->line_num;
+            fe->col_num = fp->col_num;
+            fe->call_count = fp->call_count;
+            fe->loop_count = fp->loop_count;
+            fe->exec_count = fp->exec_count;
+            p->function_count++;
+            fe->func_name = js_profile_atom_dup(rt, fp->func_name);
+            fe->filename = js_profile_atom_dup(rt, fp->filename);
+            if (!fe->func_name || !fe->filename)
+                goto fail;
+        }
+    }
+    qsort(p->functions, p->function_count, sizeof(p->functions[0]),
+          js_function_profile_entry_cmp);
+
+    if (max_entries > 0) {
+        /* the truncated entries are freed with the profile */
+        for(i = max_entries; i < p->function_count; i++) {
+            js_free_rt(rt, p->functions[i].func_name);
+            js_free_rt(rt, p->functions[i].filename);
+        }
+        p->opcode_count = min_int(p->opcode_count, max_entries);
+        p->pair_count = min_int(p->pair_count, max_entries);
+        p->function_count = min_int(p->function_count, max_entries);
+    }
+    return p;
+ fail:
+    JS_FreeOpcodeProfile(rt, p);
+    return NULL;
+}
+
+void JS_DumpOpcodeProfile(FILE *fp, const JSOpcodeProfile *p)
+{
+    const JSOpcodeProfileEntry *e;
+    const JSFunctionProfileEntry *fe;
+    int i;
+
+    fprintf(fp, "%-32s %12s %6s\n", "OPCODES", "COUNT", "%");
+    for(i = 0; i < p->opcode_count; i++) {
+        e = &p->opcodes[i];
+        fprintf(fp, "%-32s %12"PRId64" %6.2f\n", JS_GetOpcodeName(e->opcode),
+                e->count, p->total ? 100.0 * e->count / p->total : 0.0);
+    }
+    fprintf(fp, "\n%-32s %12s %6s\n", "OPCODE PAIRS", "COUNT", "%");
+    for(i = 0; i < p->pair_count; i++) {
+        char buf[64];
+        e = &p->pairs[i];
+        snprintf(buf, sizeof(buf), "%s %s", JS_GetOpcodeName(e->opcode),
+                 JS_GetOpcodeName(e->next_opcode));
+        fprintf(fp, "%-32s %12"PRId64" %6.2f\n", buf,
+                e->count, p->total ? 100.0 * e->count / p->total : 0.0);
+    }
+    fprintf(fp, "\n%-32s %12s %12s %12s  %s\n", "FUNCTIONS", "OPCODES",
+            "CALLS", "LOOPS", "LOCATION");
+    for(i = 0; i < p->function_count; i++) {
+        fe = &p->functions[i];
+        fprintf(fp, "%-32s %12"PRId64" %12"PRId64" %12"PRId64"  %s:%d:%d\n",
+                fe->func_name[0] ? fe->func_name : "<anonymous>",
+                fe->exec_count, fe->call_count, fe->loop_count,
+                fe->filename[0] ? fe->filename : "<unknown>",
+                fe->line_num, fe->col_num);
+    }
+}
+
 /* argument of OP_special_object */
 typedef enum {
     OP_SPECIAL_OBJECT_ARGUMENTS,
@@ -16754,9 +18137,14 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
     JSValue *local_buf, *stack_buf, *var_buf, *arg_buf, *sp, ret_val, *pval;
     JSVarRef **var_refs;
     size_t alloca_size;
+    JSProfileState prof_state;
 
 #if !DIRECT_DISPATCH
-#define SWITCH(pc)      switch (opcode = *pc++)
+    BOOL profiling;
+#define SWITCH(pc)      opcode = *pc++;                                 \
+                        if (unlikely(profiling))                        \
+                            js_profile_opcode(rt, b, &prof_state, pc);  \
+                        switch (opcode)
 #define CASE(op)        case op
 #define DEFAULT         default
 #define BREAK           break
@@ -16769,9 +18157,17 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
 #define def(id, size, n_pop, n_push, f) && case_default,
 #endif
 #include "quickjs-opcode.h"
+#if !SUPER_OPCODES
+        /* with the superinstructions, all the opcodes are used */
         [ OP_COUNT ... 255 ] = &&case_default
+#endif
+    };
+    /* when profiling, all the opcodes go through case_profile */
+    static const void * const profile_dispatch_table[256] = {
+        [ 0 ... 255 ] = &&case_profile
     };
-#define SWITCH(pc)      goto *dispatch_table[opcode = *pc++];
+    const void * const *active_dispatch_table;
+#define SWITCH(pc)      goto *active_dispatch_table[opcode = *pc++];
 #define CASE(op)        case_ ## op
 #define DEFAULT         case_default
 #define BREAK           SWITCH(pc)
@@ -16856,11 +18252,25 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
     stack_buf = var_buf + b->var_count;
     sp = stack_buf;
     pc = b->byte_code_buf;
+    if (unlikely(!rt->current_stack_frame && rt->cpu_profiler))
+        js_cpu_profile_enter(rt);
     sf->prev_frame = rt->current_stack_frame;
     rt->current_stack_frame = sf;
     ctx = b->realm; /* set the current realm */
+    if (unlikely(rt->opcode_profiling))
+        js_profile_call(rt, b);
 
  restart:
+#if DIRECT_DISPATCH
+    if (unlikely(rt->opcode_profiling))
+        active_dispatch_table = profile_dispatch_table;
+    else
+        active_dispatch_table = dispatch_table;
+#else
+    profiling = rt->opcode_profiling;
+#endif
+    prof_state.prev_pc = NULL;
+    prof_state.prev_opcode = 0;
     for(;;) {
         int call_argc;
         JSValue *call_argv;
@@ -17859,18 +19269,18 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
 
         CASE(OP_goto):
             pc += (int32_t)get_u32(pc);
-            if (unlikely(js_poll_interrupts(ctx)))
+            if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
                 goto exception;
             BREAK;
 #if SHORT_OPCODES
         CASE(OP_goto16):
             pc += (int16_t)get_u16(pc);
-            if (unlikely(js_poll_interrupts(ctx)))
+            if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
                 goto exception;
             BREAK;
         CASE(OP_goto8):
             pc += (int8_t)pc[0];
-            if (unlikely(js_poll_interrupts(ctx)))
+            if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
                 goto exception;
             BREAK;
 #endif
@@ -17890,7 +19300,7 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 if (res) {
                     pc += (int32_t)get_u32(pc - 4) - 4;
                 }
-                if (unlikely(js_poll_interrupts(ctx)))
+                if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
                     goto exception;
             }
             BREAK;
@@ -17911,7 +19321,7 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 if (!res) {
                     pc += (int32_t)get_u32(pc - 4) - 4;
                 }
-                if (unlikely(js_poll_interrupts(ctx)))
+                if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
                     goto exception;
             }
             BREAK;
@@ -17932,7 +19342,7 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 if (res) {
                     pc += (int8_t)pc[-1] - 1;
                 }
-                if (unlikely(js_poll_interrupts(ctx)))
+                if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
                     goto exception;
             }
             BREAK;
@@ -17952,7 +19362,59 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 if (!res) {
                     pc += (int8_t)pc[-1] - 1;
                 }
-                if (unlikely(js_poll_interrupts(ctx)))
+                if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
+                    goto exception;
+            }
+            BREAK;
+#endif
+#if SUPER_OPCODES
+        CASE(OP_lt_if_false):
+            {
+                int res;
+                JSValue op1, op2;
+
+                op1 = sp[-2];
+                op2 = sp[-1];
+                if (likely(JS_VALUE_IS_BOTH_INT(op1, op2))) {
+                    res = JS_VALUE_GET_INT(op1) < JS_VALUE_GET_INT(op2);
+                    sp -= 2;
+                } else {
+                    sf->cur_pc = pc;
+                    if (js_relational_slow(ctx, sp, OP_lt))
+                        goto exception;
+                    res = JS_VALUE_GET_BOOL(sp[-2]);
+                    sp -= 2;
+                }
+                pc += 2;
+                if (!res) {
+                    pc += (int16_t)get_u16(pc - 2) - 2;
+                }
+                if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
+                    goto exception;
+            }
+            BREAK;
+        CASE(OP_inc_loc_goto):
+            {
+                JSValue op1;
+                int val;
+                int idx;
+                idx = *pc;
+                pc += 1;
+
+                op1 = var_buf[idx];
+                if (likely(JS_VALUE_GET_TAG(op1) == JS_TAG_INT &&
+                           JS_VALUE_GET_INT(op1) != INT32_MAX)) {
+                    val = JS_VALUE_GET_INT(op1);
+                    var_buf[idx] = JS_NewInt32(ctx, val + 1);
+                } else {
+                    sf->cur_pc = pc;
+                    op1 = JS_DupValue(ctx, op1);
+                    if (js_unary_arith_slow(ctx, &op1 + 1, OP_inc))
+                        goto exception;
+                    set_value(ctx, &var_buf[idx], op1);
+                }
+                pc += (int16_t)get_u16(pc);
+                if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
                     goto exception;
             }
             BREAK;
@@ -18190,6 +19652,147 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             }
             BREAK;
 
+        CASE(OP_get_field_ic):
+            {
+                JSValue val;
+                JSInlineCache *ic;
+                JSProperty *pr;
+                ic = &b->ic[get_u32(pc)];
+                pc += 4;
+
+                if (likely(JS_VALUE_GET_TAG(sp[-1]) == JS_TAG_OBJECT) &&
+                    (pr = js_inline_cache_get(rt, ic, JS_VALUE_GET_OBJ(sp[-1]))) != NULL) {
+                    val = JS_DupValue(ctx, pr->u.value);
+                } else {
+                    sf->cur_pc = pc;
+                    val = js_inline_cache_get_slow(ctx, ic, sp[-1]);
+                    if (unlikely(JS_IsException(val)))
+                        goto exception;
+                }
+                JS_FreeValue(ctx, sp[-1]);
+                sp[-1] = val;
+            }
+            BREAK;
+
+        CASE(OP_get_field2_ic):
+            {
+                JSValue val;
+                JSInlineCache *ic;
+                JSProperty *pr;
+                ic = &b->ic[get_u32(pc)];
+                pc += 4;
+
+                if (likely(JS_VALUE_GET_TAG(sp[-1]) == JS_TAG_OBJECT) &&
+                    (pr = js_inline_cache_get(rt, ic, JS_VALUE_GET_OBJ(sp[-1]))) != NULL) {
+                    val = JS_DupValue(ctx, pr->u.value);
+                } else {
+                    sf->cur_pc = pc;
+                    val = js_inline_cache_get_slow(ctx, ic, sp[-1]);
+                    if (unlikely(JS_IsException(val)))
+                        goto exception;
+                }
+                *sp++ = val;
+            }
+            BREAK;
+
+        CASE(OP_put_field_ic):
+            {
+                int ret;
+                JSInlineCache *ic;
+                ic = &b->ic[get_u32(pc)];
+                pc += 4;
+
+                ret = 0;
+                if (likely(JS_VALUE_GET_TAG(sp[-2]) == JS_TAG_OBJECT))
+                    ret = js_inline_cache_put(ctx, ic, JS_VALUE_GET_OBJ(sp[-2]), sp[-1]);
+                if (ret == 0) {
+                    sf->cur_pc = pc;
+                    ret = js_inline_cache_put_slow(ctx, ic, sp[-2], sp[-1]);
+                }
+                JS_FreeValue(ctx, sp[-2]);
+                sp -= 2;
+                if (unlikely(ret < 0))
+                    goto exception;
+            }
+            BREAK;
+
+        CASE(OP_get_var_ic):
+            {
+                JSValue val;
+                JSInlineCache *ic;
+                JSProperty *pr;
+                ic = &b->ic[get_u32(pc)];
+                pc += 4;
+
+                pr = js_global_cache_lookup(ctx, ic);
+                if (likely(pr != NULL && !JS_IsUninitialized(pr->u.value))) {
+                    rt->ic_stats.global_hits++;
+                    if (ic->opcode == OP_check_var)
+                        val = JS_TRUE;
+                    else
+                        val = JS_DupValue(ctx, pr->u.value);
+                } else {
+                    sf->cur_pc = pc;
+                    val = js_global_cache_get_slow(ctx, ic);
+                    if (unlikely(JS_IsException(val)))
+                        goto exception;
+                }
+                *sp++ = val;
+            }
+            BREAK;
+
+        CASE(OP_put_var_ic):
+            {
+                int ret;
+                JSInlineCache *ic;
+                JSProperty *pr;
+                ic = &b->ic[get_u32(pc)];
+                pc += 4;
+
+                pr = js_global_cache_lookup(ctx, ic);
+                if (likely(pr != NULL && !JS_IsUninitialized(pr->u.value))) {
+                    rt->ic_stats.global_hits++;
+                    set_value(ctx, &pr->u.value, sp[-1]);
+                    ret = 0;
+                } else {
+                    sf->cur_pc = pc;
+                    ret = js_global_cache_put_slow(ctx, ic, sp[-1]);
+                }
+                sp--;
+                if (unlikely(ret < 0))
+                    goto exception;
+            }
+            BREAK;
+
+        CASE(OP_put_var_strict_ic):
+            {
+                int ret;
+                JSInlineCache *ic;
+                JSProperty *pr;
+                ic = &b->ic[get_u32(pc)];
+                pc += 4;
+
+                /* sp[-2] is JS_TRUE or JS_FALSE */
+                if (unlikely(!JS_VALUE_GET_INT(sp[-2]))) {
+                    sf->cur_pc = pc;
+                    JS_ThrowReferenceErrorNotDefined(ctx, ic->atom);
+                    goto exception;
+                }
+                pr = js_global_cache_lookup(ctx, ic);
+                if (likely(pr != NULL && !JS_IsUninitialized(pr->u.value))) {
+                    rt->ic_stats.global_hits++;
+                    set_value(ctx, &pr->u.value, sp[-1]);
+                    ret = 0;
+                } else {
+                    sf->cur_pc = pc;
+                    ret = js_global_cache_put_slow(ctx, ic, sp[-1]);
+                }
+                sp -= 2;
+                if (unlikely(ret < 0))
+                    goto exception;
+            }
+            BREAK;
+
         CASE(OP_private_symbol):
             {
                 JSAtom atom;
@@ -19330,10 +20933,17 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             sp[-1] = JS_FALSE;
             BREAK;
         CASE(OP_invalid):
+#if !(DIRECT_DISPATCH && SUPER_OPCODES)
         DEFAULT:
+#endif
             JS_ThrowInternalError(ctx, "invalid opcode: pc=%u opcode=0x%02x",
                                   (int)(pc - b->byte_code_buf - 1), opcode);
             goto exception;
+#if DIRECT_DISPATCH
+        case_profile:
+            js_profile_opcode(rt, b, &prof_state, pc);
+            goto *dispatch_table[opcode];
+#endif
         }
     }
  exception:
@@ -30764,6 +32374,168 @@ static JSFunctionDef *js_new_function_def(JSContext *ctx,
     return fd;
 }
 
+/* FALSE if the lookup of 'atom' may depend on the exotic behavior of
+   fast arrays (array indexes and typed array numeric keys) */
+static BOOL js_inline_cache_atom_ok(JSRuntime *rt, JSAtom atom)
+{
+    JSString *p;
+    int c;
+
+    if (__JS_AtomIsTaggedInt(atom) ||
+        atom == JS_ATOM_Infinity || atom == JS_ATOM_NaN)
+        return FALSE;
+    p = rt->atom_array[atom];
+    if (p->atom_type == JS_ATOM_TYPE_STRING && p->len != 0) {
+        c = string_get(p, 0);
+        if (is_num(c) || c == '-')
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Failing to allocate the caches is not an error: the bytecode is
+   then left unchanged. */
+static void js_init_inline_caches(JSRuntime *rt, JSFunctionBytecode *b)
+{
+    uint8_t *bc_buf = b->byte_code_buf;
+    int pos, len, op, new_op, count, idx;
+    JSAtom atom;
+
+    count = 0;
+    for(pos = 0; pos < b->byte_code_len; pos += len) {
+        op = bc_buf[pos];
+        len = short_opcode_info(op).size;
+        switch(op) {
+        case OP_get_field:
+        case OP_get_field2:
+        case OP_put_field:
+        case OP_check_var:
+        case OP_get_var_undef:
+        case OP_get_var:
+        case OP_put_var:
+        case OP_put_var_strict:
+            if (js_inline_cache_atom_ok(rt, get_u32(bc_buf + pos + 1)))
+                count++;
+            break;
+        }
+    }
+    if (count == 0)
+        return;
+    b->ic = js_mallocz_rt(rt, sizeof(b->ic[0]) * count);
+    if (!b->ic)
+        return;
+    b->ic_count = count;
+    idx = 0;
+    for(pos = 0; pos < b->byte_code_len; pos += len) {
+        op = bc_buf[pos];
+        len = short_opcode_info(op).size;
+        switch(op) {
+        case OP_get_field:
+            new_op = OP_get_field_ic;
+            break;
+        case OP_get_field2:
+            new_op = OP_get_field2_ic;
+            break;
+        case OP_put_field:
+            new_op = OP_put_field_ic;
+            break;
+        case OP_check_var:
+        case OP_get_var_undef:
+        case OP_get_var:
+            new_op = OP_get_var_ic;
+            break;
+        case OP_put_var:
+            new_op = OP_put_var_ic;
+            break;
+        case OP_put_var_strict:
+            new_op = OP_put_var_strict_ic;
+            break;
+        default:
+            continue;
+        }
+        atom = get_u32(bc_buf + pos + 1);
+        if (!js_inline_cache_atom_ok(rt, atom))
+            continue;
+        /* the cache takes the reference to the atom */
+        b->ic[idx].atom = atom;
+        b->ic[idx].opcode = op;
+        bc_buf[pos] = new_op;
+        put_u32(bc_buf + pos + 1, idx);
+        idx++;
+    }
+}
+
+#if SUPER_OPCODES
+/* Replace the opcode pairs 'lt if_false8' and 'inc_loc goto8' by
+   superinstructions of the same size, so that the jump offsets and
+   the pc2line table remain valid. A pair is not fused when its second
+   instruction is a jump target. */
+static void js_fuse_superinstructions(JSRuntime *rt, JSFunctionBytecode *b)
+{
+    uint8_t *bc_buf = b->byte_code_buf;
+    int bc_len = b->byte_code_len;
+    uint8_t *targets;
+    int pos, len, op, addr;
+
+    /* bitmap of the jump targets */
+    targets = js_mallocz_rt(rt, (bc_len + 7) >> 3);
+    if (!targets)
+        return;
+    for(pos = 0; pos < bc_len; pos += len) {
+        op = bc_buf[pos];
+        len = short_opcode_info(op).size;
+        switch(short_opcode_info(op).fmt) {
+        case OP_FMT_label8:
+            addr = pos + 1 + get_i8(bc_buf + pos + 1);
+            break;
+        case OP_FMT_label16:
+            addr = pos + 1 + get_i16(bc_buf + pos + 1);
+            break;
+        case OP_FMT_label:
+        case OP_FMT_label_u16:
+            addr = pos + 1 + (int32_t)get_u32(bc_buf + pos + 1);
+            break;
+        case OP_FMT_atom_label_u8:
+        case OP_FMT_atom_label_u16:
+            addr = pos + 5 + (int32_t)get_u32(bc_buf + pos + 5);
+            break;
+        default:
+            continue;
+        }
+        if (addr >= 0 && addr < bc_len)
+            targets[addr >> 3] |= 1 << (addr & 7);
+    }
+
+#define is_jump_target(addr) ((targets[(addr) >> 3] >> ((addr) & 7)) & 1)
+    /* the offsets are relative to the offset field, which moves back
+       by one byte */
+    for(pos = 0; pos < bc_len; pos += len) {
+        op = bc_buf[pos];
+        len = short_opcode_info(op).size;
+        switch(op) {
+        case OP_lt:
+            if (pos + 3 <= bc_len && bc_buf[pos + 1] == OP_if_false8 &&
+                !is_jump_target(pos + 1)) {
+                bc_buf[pos] = OP_lt_if_false;
+                put_u16(bc_buf + pos + 1, get_i8(bc_buf + pos + 2) + 1);
+                len = 3;
+            }
+            break;
+        case OP_inc_loc:
+            if (pos + 4 <= bc_len && bc_buf[pos + 2] == OP_goto8 &&
+                !is_jump_target(pos + 2)) {
+                bc_buf[pos] = OP_inc_loc_goto;
+                put_u16(bc_buf + pos + 2, get_i8(bc_buf + pos + 3) + 1);
+                len = 4;
+            }
+            break;
+        }
+    }
+#undef is_jump_target
+    js_free_rt(rt, targets);
+}
+#endif
+
 static void free_bytecode_atoms(JSRuntime *rt,
                                 const uint8_t *bc_buf, int bc_len,
                                 BOOL use_short_opcodes)
@@ -30923,6 +32695,12 @@ static void dump_byte_code(JSContext *ctx, int pass,
                 pos++;
                 addr = (int16_t)get_u16(tab + pos);
                 goto has_addr;
+#endif
+#if SUPER_OPCODES
+            case OP_FMT_loc8_label16:
+                pos += 2;
+                addr = (int16_t)get_u16(tab + pos);
+                goto has_addr;
 #endif
             case OP_FMT_atom_label_u8:
             case OP_FMT_atom_label_u16:
@@ -31118,6 +32896,16 @@ static void dump_byte_code(JSContext *ctx, int pass,
         case OP_FMT_loc8:
             idx = get_u8(tab + pos);
             goto has_loc;
+#if SUPER_OPCODES
+        case OP_FMT_loc8_label16:
+            idx = get_u8(tab + pos);
+            printf(" %d: ", idx);
+            if (idx < var_count) {
+                print_atom(ctx, vars[idx].var_name);
+            }
+            printf(",%u", get_i16(tab + pos + 1) + pos + 1);
+            break;
+#endif
         case OP_FMT_loc:
             idx = get_u16(tab + pos);
         has_loc:
@@ -34820,6 +36608,10 @@ static JSValue js_create_function(JSContext *ctx, JSFunctionDef *fd)
     b->is_direct_or_indirect_eval = (fd->eval_type == JS_EVAL_TYPE_DIRECT ||
                                      fd->eval_type == JS_EVAL_TYPE_INDIRECT);
     b->realm = JS_DupContext(ctx);
+    js_init_inline_caches(ctx->rt, b);
+#if SUPER_OPCODES
+    js_fuse_superinstructions(ctx->rt, b);
+#endif
 
     add_gc_object(ctx->rt, &b->header, JS_GC_OBJ_TYPE_FUNCTION_BYTECODE);
 
@@ -34853,6 +36645,7 @@ static void free_function_bytecode(JSRuntime *rt, JSFunctionBytecode *b)
     }
 #endif
     free_bytecode_atoms(rt, b->byte_code_buf, b->byte_code_len, TRUE);
+    js_free_inline_caches(rt, b);
 
     if (b->vardefs) {
         for(i = 0; i < b->arg_count + b->var_count; i++) {
@@ -36274,21 +38067,43 @@ static void bc_byte_swap(uint8_t *bc_buf, int bc_len)
 }
 
 static int JS_WriteFunctionBytecode(BCWriterState *s,
-                                    const uint8_t *bc_buf1, int bc_len)
+                                    const JSFunctionBytecode *b)
 {
-    int pos, len, op;
+    int pos, len, op, bc_len;
     JSAtom atom;
     uint8_t *bc_buf;
     uint32_t val;
 
+    bc_len = b->byte_code_len;
     bc_buf = js_malloc(s->ctx, bc_len);
     if (!bc_buf)
         return -1;
-    memcpy(bc_buf, bc_buf1, bc_len);
+    memcpy(bc_buf, b->byte_code_buf, bc_len);
 
     pos = 0;
     while (pos < bc_len) {
         op = bc_buf[pos];
+        if (op >= OP_get_field_ic && op <= OP_put_var_strict_ic) {
+            /* the inline caches are not saved */
+            const JSInlineCache *ic = &b->ic[get_u32(bc_buf + pos + 1)];
+            op = ic->opcode;
+            bc_buf[pos] = op;
+            put_u32(bc_buf + pos + 1, ic->atom);
+        }
+#if SUPER_OPCODES
+        /* neither are the superinstructions */
+        if (op == OP_lt_if_false) {
+            op = OP_lt;
+            bc_buf[pos] = op;
+            bc_buf[pos + 2] = get_i16(bc_buf + pos + 1) - 1;
+            bc_buf[pos + 1] = OP_if_false8;
+        } else if (op == OP_inc_loc_goto) {
+            op = OP_inc_loc;
+            bc_buf[pos] = op;
+            bc_buf[pos + 3] = get_i16(bc_buf + pos + 2) - 1;
+            bc_buf[pos + 2] = OP_goto8;
+        }
+#endif
         len = short_opcode_info(op).size;
         switch(short_opcode_info(op).fmt) {
         case OP_FMT_atom:
@@ -36447,7 +38262,7 @@ static int JS_WriteFunctionTag(BCWriterState *s, JSValueConst obj)
         bc_put_u8(s, flags);
     }
 
-    if (JS_WriteFunctionBytecode(s, b->byte_code_buf, b->byte_code_len))
+    if (JS_WriteFunctionBytecode(s, b))
         goto fail;
 
     if (b->has_debug) {
@@ -37408,6 +39223,12 @@ static JSValue JS_ReadFunctionTag(BCReaderState *s)
         bc_read_trace(s, "bytecode {\n");
         if (JS_ReadFunctionBytecode(s, b, byte_code_offset, b->byte_code_len))
             goto fail;
+        if (!b->read_only_bytecode) {
+            js_init_inline_caches(ctx->rt, b);
+#if SUPER_OPCODES
+            js_fuse_superinstructions(ctx->rt, b);
+#endif
+        }
         bc_read_trace(s, "}\n");
     }
     if (b->has_debug) {
@@ -53015,6 +54836,24 @@ JSValue JS_NewTypedArray(JSContext *ctx, int argc, JSValueConst *argv,
                                       JS_CLASS_UINT8C_ARRAY + type);
 }
 
+/* return the typed array type (JSTypedArrayEnum) or -1 if 'obj' is
+   not a typed array */
+int JS_GetTypedArrayType(JSValueConst obj)
+{
+    JSClassID class_id = JS_GetClassID(obj);
+    if (class_id >= JS_CLASS_UINT8C_ARRAY && class_id <= JS_CLASS_FLOAT64_ARRAY)
+        return class_id - JS_CLASS_UINT8C_ARRAY;
+    else
+        return -1;
+}
+
+JS_BOOL JS_IsArrayBuffer(JSValueConst obj)
+{
+    JSClassID class_id = JS_GetClassID(obj);
+    return class_id == JS_CLASS_ARRAY_BUFFER ||
+        class_id == JS_CLASS_SHARED_ARRAY_BUFFER;
+}
+
 /* Return the buffer associated to the typed array or an exception if
    it is not a typed array or if the buffer is detached. pbyte_offset,
    pbyte_length or pbytes_per_element can be NULL. */
@@ -445,6 +445,79 @@ typedef struct JSMemoryUsage {
 void JS_ComputeMemoryUsage(JSRuntime *rt, JSMemoryUsage *s);
 void JS_DumpMemoryUsage(FILE *fp, const JSMemoryUsage *s, JSRuntime *rt);
 
+/* inline caches of the property accesses with a constant name
+   (obj.prop) and of the global variable accesses */
+typedef struct JSInlineCacheStats {
+    int64_t get_hits, get_misses;
+    int64_t put_hits, put_misses;
+    int64_t global_hits, global_misses;
+    int64_t megamorphic_count; /* caches which stopped recording shapes */
+} JSInlineCacheStats;
+
+void JS_GetInlineCacheStats(JSRuntime *rt, JSInlineCacheStats *s);
+void JS_ResetInlineCacheStats(JSRuntime *rt);
+
+/* opcode profiler: when enabled, the interpreter counts the executed
+   opcodes, the pairs of consecutive opcodes of a function and, for
+   each bytecode function, its calls, loop iterations (backward jumps)
+   and executed opcodes. It takes effect at the next function call and
+   the counts are kept when it is disabled. The opcodes are the ones
+   actually executed, including the inline cache variants and the
+   superinstructions (build without SUPER_OPCODES to see the pairs
+   they replace). */
+typedef struct JSOpcodeProfileEntry {
+    int opcode;
+    int next_opcode; /* second opcode of a pair, -1 otherwise */
+    int64_t count;
+} JSOpcodeProfileEntry;
+
+typedef struct JSFunctionProfileEntry {
+    char *func_name; /* empty string for anonymous functions */
+    char *filename; /* empty string if no debug info */
+    int line_num, col_num;
+    int64_t call_count;
+    int64_t loop_count;
+    int64_t exec_count; /* executed opcodes */
+} JSFunctionProfileEntry;
+
+/* the entries are sorted by decreasing count */
+typedef struct JSOpcodeProfile {
+    int64_t total; /* executed opcodes */
+    int opcode_count;
+    JSOpcodeProfileEntry *opcodes;
+    int pair_count;
+    JSOpcodeProfileEntry *pairs;
+    int function_count;
+    JSFunctionProfileEntry *functions;
+} JSOpcodeProfile;
+
+void JS_SetOpcodeProfiling(JSRuntime *rt, JS_BOOL enable);
+JS_BOOL JS_IsOpcodeProfiling(JSRuntime *rt);
+void JS_ResetOpcodeProfile(JSRuntime *rt);
+/* return NULL if the profiler was never enabled or if there is no
+   memory. Each list is truncated to 'max_entries' if max_entries > 0. */
+JSOpcodeProfile *JS_GetOpcodeProfile(JSRuntime *rt, int max_entries);
+void JS_FreeOpcodeProfile(JSRuntime *rt, JSOpcodeProfile *p);
+void JS_DumpOpcodeProfile(FILE *fp, const JSOpcodeProfile *p);
+/* return NULL if not a valid opcode */
+const char *JS_GetOpcodeName(int opcode);
+
+/* sampling CPU profiler: a timer calls JS_RequestCPUProfileSample()
+   every 'interval_us' microseconds and the JS thread records its call
+   stack at its next interrupt check (function call or backward
+   jump). JS_StartCPUProfiler() discards the previous profile. Return
+   -1 if no memory. */
+int JS_StartCPUProfiler(JSRuntime *rt, int interval_us);
+void JS_StopCPUProfiler(JSRuntime *rt);
+JS_BOOL JS_IsCPUProfilerRunning(JSRuntime *rt);
+/* can be called from a signal handler or from any thread while the
+   runtime is alive */
+void JS_RequestCPUProfileSample(JSRuntime *rt);
+/* return the profile in the Chrome DevTools .cpuprofile JSON format
+   (free it with js_free_rt()) or NULL if the profiler was never
+   started or if there is no memory */
+char *JS_GetCPUProfile(JSRuntime *rt, size_t *plen);
+
 /* atom support */
 #define JS_ATOM_NULL 0
 
@@ -737,6 +810,9 @@ static inline JSValue JS_NewString(JSContext *ctx, const char *str)
 {
     return JS_NewStringLen(ctx, str, strlen(str));
 }
+JSValue JS_NewStringUTF16(JSContext *ctx, const uint16_t *buf, size_t len);
+JSValue JS_NewStringLatin1(JSContext *ctx, const uint8_t *buf, size_t len);
+const void *JS_GetStringBuffer(JSValueConst val, size_t *plen, JS_BOOL *pis_wide_char);
 JSValue JS_NewAtomString(JSContext *ctx, const char *str);
 JSValue JS_ToString(JSContext *ctx, JSValueConst val);
 JSValue JS_ToPropertyKey(JSContext *ctx, JSValueConst val);
@@ -888,6 +964,9 @@ JSValue JS_GetTypedArrayBuffer(JSContext *ctx, JSValueConst obj,
                                size_t *pbyte_offset,
                                size_t *pbyte_length,
                                size_t *pbytes_per_element);
+/* return -1 if not a typed array */
+int JS_GetTypedArrayType(JSValueConst obj);
+JS_BOOL JS_IsArrayBuffer(JSValueConst obj);
 typedef struct {
     void *(*sab_alloc)(void *opaque, size_t size);
     void (*sab_free)(void *opaque, void *ptr);
@@ -553,6 +553,36 @@ function global_write_strict(n)
     return n * 4;
 }
 
+let global_let0 = 1;
+
+function global_let_read(n)
+{
+    var sum, j;
+    sum = 0;
+    for(j = 0; j < n; j++) {
+        sum += global_let0;
+        sum += global_let0;
+        sum += global_let0;
+        sum += global_let0;
+    }
+    global_res = sum;
+    return n * 4;
+}
+
+function global_builtin_read(n)
+{
+    var sum, j;
+    sum = 0;
+    for(j = 0; j < n; j++) {
+        sum += Math.abs(j);
+        sum += Math.abs(j);
+        sum += Math.abs(j);
+        sum += Math.abs(j);
+    }
+    global_res = sum;
+    return n * 4;
+}
+
 function local_destruct(n)
 {
     var j, v1, v2, v3, v4;
@@ -1370,6 +1400,8 @@ function main(argc, argv, g)
         global_read,
         global_write,
         global_write_strict,
+        global_let_read,
+        global_builtin_read,
         local_destruct,
         global_destruct,
         global_destruct_strict,
@@ -622,6 +622,170 @@ function test_optional_chaining()
     assert((a?.["b"])().c, 42);
 }
 
+let ic_lex = 0;
+const ic_const = 1;
+
+function test_global_cache()
+{
+    var geval = eval;
+    var i, get_g, set_g, set_g_strict, has_g;
+
+    geval("var ic_g = 1;");
+    get_g = geval("(function() { return ic_g; })");
+    set_g = geval("(function(v) { ic_g = v; })");
+    set_g_strict = geval("(function(v) { 'use strict'; ic_g = v; })");
+    has_g = geval("(function() { return typeof ic_g; })");
+    for(i = 0; i < 3; i++) {
+        set_g(i);
+        assert(get_g(), i);
+        set_g_strict(i + 1);
+        assert(get_g(), i + 1);
+    }
+
+    /* property redefined as an accessor */
+    Object.defineProperty(globalThis, "ic_g", { get: function() { return "getter"; },
+                                                set: function(v) { globalThis.ic_set = v; },
+                                                configurable: true });
+    assert(get_g(), "getter");
+    set_g(5);
+    assert(globalThis.ic_set, 5);
+
+    /* read-only property */
+    Object.defineProperty(globalThis, "ic_g", { value: 1, writable: false, configurable: true });
+    set_g(6);
+    assert(get_g(), 1);
+    assert_throws(TypeError, () => set_g_strict(6));
+
+    /* deleted property */
+    delete globalThis.ic_g;
+    assert(has_g(), "undefined");
+    assert_throws(ReferenceError, get_g);
+    assert_throws(ReferenceError, () => set_g_strict(1));
+    set_g(7);
+    assert(get_g(), 7);
+
+    /* lexical declarations take precedence over the global object */
+    get_g = geval("(function() { return ic_lex; })");
+    set_g = geval("(function(v) { ic_lex = v; })");
+    for(i = 0; i < 3; i++) {
+        set_g(i);
+        assert(get_g(), i);
+    }
+    globalThis.ic_lex = "global";
+    assert(get_g(), 2);
+    set_g(3);
+    assert(ic_lex, 3);
+    assert(globalThis.ic_lex, "global");
+
+    /* constant and uninitialized lexical declarations */
+    get_g = geval("(function() { return ic_const; })");
+    set_g = geval("(function(v) { ic_const = v; })");
+    for(i = 0; i < 3; i++) {
+        assert(get_g(), 1);
+        assert_throws(TypeError, () => set_g(2));
+    }
+    get_g = geval("(function() { return ic_tdz; })");
+    set_g = geval("(function(v) { ic_tdz = v; })");
+    for(i = 0; i < 3; i++) {
+        assert_throws(ReferenceError, get_g);
+        assert_throws(ReferenceError, () => set_g(1));
+    }
+}
+
+function test_inline_cache()
+{
+    function get_x(o) { return o.x; }
+    function set_x(o, v) { o.x = v; }
+    function call_f(o) { return o.f(); }
+    var i, j, o, objs, proto, base, mid, leaf;
+
+    /* polymorphic then megamorphic site */
+    objs = [];
+    for(i = 0; i < 20; i++) {
+        o = { x: i };
+        o["p" + i] = 0;
+        objs.push(o);
+    }
+    for(j = 0; j < 3; j++) {
+        for(i = 0; i < objs.length; i++)
+            assert(get_x(objs[i]), i);
+    }
+
+    /* own property shadowing an inherited one */
+    proto = { x: 1, f: function() { return "proto"; } };
+    o = Object.create(proto);
+    for(i = 0; i < 3; i++)
+        assert(get_x(o), 1);
+    o.x = 2;
+    assert(get_x(o), 2);
+
+    /* modified prototype property */
+    o = Object.create(proto);
+    for(i = 0; i < 3; i++)
+        assert(call_f(o), "proto");
+    proto.f = function() { return "value"; };
+    assert(call_f(o), "value");
+    Object.defineProperty(proto, "f", { get: function() { return function() { return "getter"; }; } });
+    assert(call_f(o), "getter");
+    delete proto.f;
+    assert_throws(TypeError, () => call_f(o));
+
+    /* property added to an intermediate prototype */
+    base = { f: function() { return "base"; } };
+    mid = Object.create(base);
+    leaf = Object.create(mid);
+    for(i = 0; i < 3; i++)
+        assert(call_f(leaf), "base");
+    mid.f = function() { return "mid"; };
+    assert(call_f(leaf), "mid");
+    Object.setPrototypeOf(leaf, base);
+    assert(call_f(leaf), "base");
+    Object.setPrototypeOf(leaf, { f: function() { return "other"; } });
+    assert(call_f(leaf), "other");
+
+    /* writes to read-only, frozen and accessor properties */
+    o = { x: 1 };
+    for(i = 0; i < 3; i++)
+        set_x(o, i);
+    assert(o.x, 2);
+    Object.freeze(o);
+    set_x(o, 10);
+    assert(o.x, 2);
+    o = { x: 1 };
+    for(i = 0; i < 3; i++)
+        set_x(o, i);
+    Object.defineProperty(o, "x", { set: function(v) { this.y = v; } });
+    set_x(o, 7);
+    assert(o.y, 7);
+
+    /* shape without hash modified in place */
+    o = { a: 1, x: 5 };
+    delete o.a;
+    for(i = 0; i < 3; i++)
+        assert(get_x(o), 5);
+    o.b = 1;
+    Object.defineProperty(o, "x", { value: 9, writable: false });
+    assert(get_x(o), 9);
+    set_x(o, 11);
+    assert(o.x, 9);
+    delete o.x;
+    assert(get_x(o), undefined);
+
+    /* exotic and primitive receivers */
+    o = new Proxy({}, { get: function(t, k) { return k === "x" ? "proxy" : undefined; } });
+    assert(get_x(o), "proxy");
+    assert(get_x([1, 2]), undefined);
+    Array.prototype.x = "array";
+    assert(get_x([1, 2]), "array");
+    delete Array.prototype.x;
+    assert(get_x([1, 2]), undefined);
+    assert(get_x("abc"), undefined);
+    String.prototype.x = 4;
+    assert(get_x("abc"), 4);
+    delete String.prototype.x;
+    assert(get_x(new Uint8Array(2)), undefined);
+}
+
 function test_unicode_ident()
 {
     var Ãµ = 3;
@@ -652,3 +816,7 @@ test_parse_semicolon();
 test_optional_chaining();
 test_parse_arrow_function();
 test_unicode_ident();
+test_inline_cache();
+test_global_cache();
+
+let ic_tdz = 1;
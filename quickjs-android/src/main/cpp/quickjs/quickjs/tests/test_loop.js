@@ -74,6 +74,51 @@ function test_for()
     assert(c === 3 && j === 3);
 }
 
+/* loop test and increment with operands which are not small integers */
+function test_for_slow()
+{
+    var i, c, s, log, lim;
+
+    c = 0;
+    for(i = 0.5; i < 3; i++)
+        c++;
+    assert(c === 3 && i === 3.5);
+
+    c = 0;
+    for(i = 0; i < "3"; i++)
+        c++;
+    assert(c === 3);
+
+    s = "";
+    for(i = "a"; i < "d"; i = String.fromCharCode(i.charCodeAt(0) + 1))
+        s += i;
+    assert(s === "abc");
+
+    log = [];
+    lim = { valueOf() { log.push(1); return 2; } };
+    for(i = 0; i < lim; i++);
+    assert(log.length === 3);
+
+    lim = { valueOf() { throw Error("valueOf"); } };
+    s = "";
+    try {
+        for(i = 0; i < lim; i++);
+    } catch(e) {
+        s = e.message;
+    }
+    assert(s === "valueOf");
+
+    c = 0;
+    for(i = 0x7ffffffe; i < 0x80000001; i++)
+        c++;
+    assert(c === 3 && i === 0x80000001);
+
+    c = 0;
+    for(i = 0n; i < 3n; i++)
+        c++;
+    assert(c === 3 && i === 3n);
+}
+
 function test_for_in()
 {
     var i, tab, a, b;
@@ -385,6 +430,7 @@ test_while();
 test_while_break();
 test_do_while();
 test_for();
+test_for_slow();
 test_for_break();
 test_switch1();
 test_switch2();
@@ -0,0 +1,37 @@
+package com.quickjs
+
+/**
+ * 内存池模式运行时的分配统计。小对象按大小级别从 64KB 的块中分配，
+ * reservedBytes 为所有块占用的字节数，大对象直接向系统分配
+ */
+data class ArenaStats(
+    val sizeClasses: List<SizeClass>,
+    val largeCount: Long,
+    val largeBytes: Long,
+    val reservedBytes: Long
+) {
+    /**
+     * 单个大小级别：slotSize 为槽位字节数，live 为存活的分配，allocations 为累计分配次数，chunks 为占用的块数
+     */
+    data class SizeClass(
+        val slotSize: Long,
+        val live: Long,
+        val allocations: Long,
+        val chunks: Long
+    )
+
+    companion object {
+        /**
+         * 解析 getArenaStats 返回的数组：每个级别 4 个值，末尾依次为大对象数、大对象字节数和块的总字节数
+         */
+        @JvmStatic
+        fun fromArray(values: LongArray): ArenaStats {
+            val classCount = (values.size - 3) / 4
+            val sizeClasses = List(classCount) { i ->
+                SizeClass(values[i * 4], values[i * 4 + 1], values[i * 4 + 2], values[i * 4 + 3])
+            }
+            val tail = classCount * 4
+            return ArenaStats(sizeClasses, values[tail], values[tail + 1], values[tail + 2])
+        }
+    }
+}
@@ -0,0 +1,131 @@
+package com.quickjs
+
+import java.io.Closeable
+import java.util.concurrent.ConcurrentLinkedQueue
+import java.util.concurrent.atomic.AtomicBoolean
+
+/**
+ * 已初始化上下文的模板：插件、Java 方法与预加载脚本只描述一次，之后按模板快速生成新的 JSContext。
+ *
+ * QuickJS 不支持堆镜像，因此预加载脚本在构建时编译为字节码，生成上下文时直接执行字节码，
+ * 省去解析与编译；另外在 JS 线程空闲时预先生成 prewarm 个上下文，newContext 直接取用。
+ */
+class ContextSnapshot private constructor(
+    val quickJS: QuickJS,
+    private val pluginFactories: List<() -> Plugin>,
+    private val javaMethods: List<Pair<String, JavaCallback>>,
+    private val bytecodes: List<ByteArray>,
+    private val prewarm: Int
+) : Closeable {
+    private val spares = ConcurrentLinkedQueue<JSContext>()
+    private val refilling = AtomicBoolean(false)
+
+    @Volatile
+    private var closed = false
+
+    init {
+        refill()
+    }
+
+    /**
+     * 获取一个按模板初始化好的上下文，调用方负责关闭
+     */
+    fun newContext(): JSContext {
+        check(!closed) { "ContextSnapshot is closed" }
+        val context = spares.poll() ?: quickJS.native.postAsync { stamp() }.get()
+        refill()
+        return context
+    }
+
+    private fun stamp(): JSContext {
+        val context = quickJS.createContext()
+        try {
+            javaMethods.forEach { (name, callback) -> context.registerJavaMethod(name, callback) }
+            pluginFactories.forEach { context.addPlugin(it()) }
+            bytecodes.forEach { context.executeBytecode(it) }
+        } catch (e: Throwable) {
+            // 半初始化的上下文不能交给调用方，也不能留作预热
+            context.close()
+            throw e
+        }
+        return context
+    }
+
+    private fun refill() {
+        if (closed || spares.size >= prewarm || !refilling.compareAndSet(false, true)) return
+        quickJS.native.eventLoop.post(object : Runnable {
+            override fun run() {
+                var scheduled = false
+                try {
+                    if (closed || quickJS.isReleased() || spares.size >= prewarm) return
+                    spares.offer(stamp())
+                    // stamp 期间 close 可能已清空 spares，之后放入的上下文由这里回收
+                    if (closed) {
+                        drainSpares()
+                        return
+                    }
+                    // 每次只生成一个，避免长时间占用 JS 线程
+                    scheduled = quickJS.native.eventLoop.post(this)
+                } catch (e: RuntimeException) {
+                    // 预热失败不影响 JS 线程上的其它任务，newContext 同步生成时会把异常抛给调用方
+                    QuickJSLog.e("ContextSnapshot prewarm failed", e)
+                } finally {
+                    if (!scheduled) refilling.set(false)
+                }
+            }
+        })
+    }
+
+    override fun close() {
+        if (closed) return
+        closed = true
+        drainSpares()
+    }
+
+    private fun drainSpares() {
+        while (true) {
+            val context = spares.poll() ?: break
+            context.close()
+        }
+    }
+
+    class Builder(private val quickJS: QuickJS) {
+        private val pluginFactories = ArrayList<() -> Plugin>()
+        private val javaMethods = ArrayList<Pair<String, JavaCallback>>()
+        private val scripts = ArrayList<Triple<String, String, Int>>()
+        private var prewarm = 0
+
+        /**
+         * 插件可能持有上下文相关的状态，因此每个上下文创建一个新实例
+         */
+        fun addPlugin(factory: () -> Plugin): Builder = apply { pluginFactories.add(factory) }
+
+        fun registerJavaMethod(name: String, callback: JavaCallback): Builder =
+            apply { javaMethods.add(name to callback) }
+
+        fun addScript(source: String, fileName: String): Builder =
+            apply { scripts.add(Triple(source, fileName, QuickJS.JS_EVAL_TYPE_GLOBAL)) }
+
+        fun addModule(source: String, fileName: String): Builder =
+            apply { scripts.add(Triple(source, fileName, QuickJS.JS_EVAL_TYPE_MODULE)) }
+
+        /**
+         * 预先生成的空闲上下文数量
+         */
+        fun prewarm(count: Int): Builder = apply { prewarm = count }
+
+        fun build(): ContextSnapshot {
+            val bytecodes = if (scripts.isEmpty()) {
+                emptyList()
+            } else {
+                val compiler = quickJS.createContext()
+                try {
+                    scripts.map { (source, fileName, evalType) -> compiler.compileScript(source, fileName, evalType) }
+                } finally {
+                    compiler.close()
+                }
+            }
+            return ContextSnapshot(quickJS, pluginFactories.toList(), javaMethods.toList(), bytecodes, prewarm)
+        }
+    }
+}
@@ -0,0 +1,127 @@
+package com.quickjs
+
+import android.os.Handler
+import android.os.HandlerThread
+import java.io.Closeable
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * JS 线程的任务调度器，所有 JSRuntime 操作都在其线程上执行
+ */
+interface EventLoop : Closeable {
+    fun post(task: Runnable): Boolean
+
+    fun postDelayed(task: Runnable, delayMillis: Long): Boolean
+
+    fun removeCallbacks(task: Runnable)
+
+    fun interrupt()
+
+    fun isInterrupted(): Boolean
+
+    /**
+     * 停止调度，必须在 JSRuntime 释放之后、于调度线程上调用
+     */
+    fun quit()
+
+    /**
+     * 释放调度器本身，由 QuickJS.close 在 quit 之后调用，此后投递的任务一律返回 false
+     */
+    override fun close() {
+    }
+}
+
+/**
+ * 基于 Android Handler/Looper 的调度器
+ */
+class HandlerEventLoop(
+    val handler: Handler,
+    private val handlerThread: HandlerThread?
+) : EventLoop {
+
+    override fun post(task: Runnable): Boolean = handler.post(task)
+
+    override fun postDelayed(task: Runnable, delayMillis: Long): Boolean =
+        handler.postDelayed(task, delayMillis)
+
+    override fun removeCallbacks(task: Runnable) {
+        handler.removeCallbacks(task)
+    }
+
+    override fun interrupt() {
+        handlerThread?.interrupt()
+    }
+
+    override fun isInterrupted(): Boolean = handlerThread?.isInterrupted == true
+
+    override fun quit() {
+        handlerThread?.quitSafely()
+    }
+}
+
+/**
+ * 原生事件循环：无锁 MPSC 环形队列 + 专用原生线程，不依赖 Android Looper，
+ * 投递任务时不分配 Message。
+ * 原生对象在 close 之前一直有效；close 会等待正在进行的原生调用返回后再回收，
+ * 其他线程此后的投递直接返回 false
+ */
+class NativeEventLoop internal constructor(val loopPtr: Long) : EventLoop {
+    @Volatile
+    private var interrupted = false
+
+    @Volatile
+    private var quit = false
+
+    @Volatile
+    private var closed = false
+
+    // 正在使用 loopPtr 的调用数，先加计数再检查 closed，与 close 的顺序相反
+    private val users = AtomicInteger()
+
+    private inline fun <T> use(fallback: T, block: () -> T): T {
+        users.incrementAndGet()
+        try {
+            return if (closed) fallback else block()
+        } finally {
+            users.decrementAndGet()
+        }
+    }
+
+    override fun post(task: Runnable): Boolean = postDelayed(task, 0)
+
+    override fun postDelayed(task: Runnable, delayMillis: Long): Boolean {
+        if (quit) return false
+        return use(false) { QuickJSNativeImpl.eventLoopPost(loopPtr, task, delayMillis) }
+    }
+
+    override fun removeCallbacks(task: Runnable) {
+        if (quit) return
+        use(Unit) { QuickJSNativeImpl.eventLoopRemove(loopPtr, task) }
+    }
+
+    override fun interrupt() {
+        interrupted = true
+    }
+
+    override fun isInterrupted(): Boolean = interrupted
+
+    override fun quit() {
+        if (quit) return
+        quit = true
+        use(Unit) { QuickJSNativeImpl.eventLoopQuit(loopPtr) }
+    }
+
+    override fun close() {
+        synchronized(this) {
+            if (closed) return
+            closed = true
+        }
+        // 先停止循环，让因队列已满而等待的投递方返回，再等所有原生调用结束
+        quit = true
+        QuickJSNativeImpl.eventLoopQuit(loopPtr)
+        while (users.get() != 0) {
+            Thread.yield()
+        }
+        QuickJSNativeImpl.eventLoopRelease(loopPtr)
+    }
+}
@@ -1,27 +1,30 @@
 package com.quickjs
 
 import android.os.Handler
-import android.os.HandlerThread
-import android.os.Looper
-import android.util.Log
+import java.nio.ByteBuffer
+import java.util.concurrent.Callable
 
 
 class EventQueue(
     private val quickJS: QuickJS,
-    private val handlerThread: HandlerThread?
+    val eventLoop: EventLoop
 ) : QuickJSNative {
     private val quickJSNative: QuickJSNative = QuickJSNativeImpl()
     private val thread: Thread = Thread.currentThread()
-    val handler: Handler = Handler(Looper.myLooper()!!)
     private val threadChecker: ThreadChecker = ThreadChecker(quickJS)
 
+    @Deprecated("使用 eventLoop，原生事件循环没有 Handler", ReplaceWith("eventLoop"))
+    val handler: Handler
+        get() = (eventLoop as? HandlerEventLoop)?.handler
+            ?: throw UnsupportedOperationException("This runtime is not driven by a Handler")
+
     fun interrupt() {
-        handlerThread?.interrupt()
+        eventLoop.interrupt()
     }
 
     private fun <T> post(event: () -> T): T? {
-        if (quickJS.isReleased() || handlerThread?.isInterrupted == true) {
-            Log.e("QuickJS", "QuickJS is released")
+        if (quickJS.isReleased() || eventLoop.isInterrupted()) {
+            QuickJSLog.e("QuickJS is released")
             return null
         }
         if (Thread.currentThread() == thread) return event()
@@ -29,7 +32,7 @@ class EventQueue(
         val result = arrayOfNulls<Any>(2)
         val errors = arrayOfNulls<RuntimeException>(1)
 
-        handler.post {
+        val posted = eventLoop.post {
             try {
                 result[0] = event()
             } catch (e: RuntimeException) {
@@ -40,6 +43,10 @@ class EventQueue(
                 (result as Object).notifyAll() // 关键修正点
             }
         }
+        if (!posted) {
+            QuickJSLog.e("QuickJS event loop has quit")
+            return null
+        }
 
         synchronized(result) {
             try {
@@ -56,13 +63,39 @@ class EventQueue(
         return result[0] as? T
     }
 
+    /**
+     * 非阻塞提交：把任务放入 JS 线程队列后立即返回，结果和异常通过 QuickJSFuture 传递
+     */
+    fun <T> postAsync(event: () -> T): QuickJSFuture<T> {
+        val future = QuickJSFuture(Callable { event() })
+        if (quickJS.isReleased() || eventLoop.isInterrupted()) {
+            future.fail(IllegalStateException("QuickJS is released"))
+            return future
+        }
+        if (Thread.currentThread() == thread) {
+            future.run()
+            return future
+        }
+        val posted = eventLoop.post {
+            if (quickJS.isReleased()) {
+                future.fail(IllegalStateException("QuickJS is released"))
+            } else {
+                future.run()
+            }
+        }
+        if (!posted) {
+            future.fail(IllegalStateException("QuickJS event loop has quit"))
+        }
+        return future
+    }
+
     fun postVoid(event: () -> Unit) {
         postVoid(true, event)
     }
 
     fun postVoid(block: Boolean = true, event: () -> Unit) {
-        if (quickJS.isReleased() || (handlerThread?.isInterrupted == true)) {
-            Log.e("QuickJS", "QuickJS is released")
+        if (quickJS.isReleased() || eventLoop.isInterrupted()) {
+            QuickJSLog.e("QuickJS is released")
             return
         }
         if (Thread.currentThread() == thread) {
@@ -71,7 +104,7 @@ class EventQueue(
         }
         val result = arrayOfNulls<Any>(2)
         val errors = arrayOfNulls<RuntimeException>(1)
-        handler.post {
+        val posted = eventLoop.post {
             try {
                 if (!quickJS.isReleased()) {
                     event()
@@ -86,6 +119,10 @@ class EventQueue(
                 }
             }
         }
+        if (!posted) {
+            QuickJSLog.e("QuickJS event loop has quit")
+            return
+        }
         if (block) {
             synchronized(result) {
                 try {
@@ -101,7 +138,11 @@ class EventQueue(
     }
 
     override fun releaseRuntime(runtimePtr: Long) {
-        postVoid { quickJSNative.releaseRuntime(runtimePtr) }
+        postVoid {
+            quickJSNative.releaseRuntime(runtimePtr)
+            // 运行时释放后立即在 JS 线程上停止调度，之后不会再访问该运行时
+            eventLoop.quit()
+        }
     }
 
     override fun createContext(runtimePtr: Long): Long {
@@ -122,6 +163,14 @@ class EventQueue(
         return post { quickJSNative.executeScript(contextPtr, expectedType, source, fileName, evalFlags) }
     }
 
+    override fun compileScript(contextPtr: Long, source: String, fileName: String, evalFlags: Int): ByteArray {
+        return post { quickJSNative.compileScript(contextPtr, source, fileName, evalFlags) }!!
+    }
+
+    override fun executeBytecode(contextPtr: Long, expectedType: Int, bytecode: ByteArray): Any? {
+        return post { quickJSNative.executeBytecode(contextPtr, expectedType, bytecode) }
+    }
+
 
     override fun getGlobalObject(contextPtr: Long): JSObject {
         return post { quickJSNative.getGlobalObject(contextPtr) }!!
@@ -135,6 +184,48 @@ class EventQueue(
         return post { quickJSNative.get(contextPtr, expectedType, objectHandle, key) }
     }
 
+    override fun getMany(contextPtr: Long, objectHandle: JSValue, keys: Array<String>): Array<Any?> {
+        return post { quickJSNative.getMany(contextPtr, objectHandle, keys) }!!
+    }
+
+    override fun setMany(contextPtr: Long, objectHandle: JSValue, keys: Array<String>, values: Array<out Any?>) {
+        postVoid { quickJSNative.setMany(contextPtr, objectHandle, keys, values) }
+    }
+
+    override fun getManyAtoms(contextPtr: Long, objectHandle: JSValue, atoms: IntArray): Array<Any?> {
+        return post { quickJSNative.getManyAtoms(contextPtr, objectHandle, atoms) }!!
+    }
+
+    override fun newAtom(contextPtr: Long, key: String): Int {
+        return post { quickJSNative.newAtom(contextPtr, key) }!!
+    }
+
+    override fun freeAtom(contextPtr: Long, atom: Int) {
+        postVoid { quickJSNative.freeAtom(contextPtr, atom) }
+    }
+
+    override fun getAtom(contextPtr: Long, expectedType: Int, objectHandle: JSValue, atom: Int): Any? {
+        return post { quickJSNative.getAtom(contextPtr, expectedType, objectHandle, atom) }
+    }
+
+    override fun setAtom(contextPtr: Long, objectHandle: JSValue, atom: Int, value: Any?) {
+        postVoid { quickJSNative.setAtom(contextPtr, objectHandle, atom, value) }
+    }
+
+    override fun containsAtom(contextPtr: Long, objectHandle: JSValue, atom: Int): Boolean {
+        return post { quickJSNative.containsAtom(contextPtr, objectHandle, atom) }!!
+    }
+
+    override fun executeFunctionAtom(
+        contextPtr: Long,
+        expectedType: Int,
+        objectHandle: JSValue,
+        atom: Int,
+        parametersHandle: Array<out Any?>
+    ): Any? {
+        return post { quickJSNative.executeFunctionAtom(contextPtr, expectedType, objectHandle, atom, parametersHandle) }
+    }
+
     override fun arrayGet(contextPtr: Long, expectedType: Int, objectHandle: JSValue, index: Int): Any? {
         return post { quickJSNative.arrayGet(contextPtr, expectedType, objectHandle, index) }
     }
@@ -163,6 +254,37 @@ class EventQueue(
         return post { quickJSNative.executeFunction2(contextPtr, expectedType, objectHandle, functionHandle, parametersHandle) }
     }
 
+    /**
+     * 已在 JS 线程上时类型化调用直接进入原生层，避免 post 的 lambda 与结果装箱
+     */
+    private fun isDirect(): Boolean =
+        Thread.currentThread() == thread && !quickJS.isReleased() && !eventLoop.isInterrupted()
+
+    override fun callII(contextPtr: Long, thisHandle: Long, functionHandle: Long, a: Int, b: Int): Int {
+        if (isDirect()) return quickJSNative.callII(contextPtr, thisHandle, functionHandle, a, b)
+        return post { quickJSNative.callII(contextPtr, thisHandle, functionHandle, a, b) }!!
+    }
+
+    override fun callDD(contextPtr: Long, thisHandle: Long, functionHandle: Long, a: Double, b: Double): Double {
+        if (isDirect()) return quickJSNative.callDD(contextPtr, thisHandle, functionHandle, a, b)
+        return post { quickJSNative.callDD(contextPtr, thisHandle, functionHandle, a, b) }!!
+    }
+
+    override fun callLL(contextPtr: Long, thisHandle: Long, functionHandle: Long, a: Long, b: Long): Long {
+        if (isDirect()) return quickJSNative.callLL(contextPtr, thisHandle, functionHandle, a, b)
+        return post { quickJSNative.callLL(contextPtr, thisHandle, functionHandle, a, b) }!!
+    }
+
+    override fun callVoid(contextPtr: Long, thisHandle: Long, functionHandle: Long) {
+        if (isDirect()) return quickJSNative.callVoid(contextPtr, thisHandle, functionHandle)
+        postVoid { quickJSNative.callVoid(contextPtr, thisHandle, functionHandle) }
+    }
+
+    override fun callDoubles(contextPtr: Long, thisHandle: Long, functionHandle: Long, args: DoubleArray): Double {
+        if (isDirect()) return quickJSNative.callDoubles(contextPtr, thisHandle, functionHandle, args)
+        return post { quickJSNative.callDoubles(contextPtr, thisHandle, functionHandle, args) }!!
+    }
+
     override fun initNewJSObject(contextPtr: Long): JSObject {
         return post { quickJSNative.initNewJSObject(contextPtr) }!!
     }
@@ -171,21 +293,125 @@ class EventQueue(
         return post { quickJSNative.initNewJSArray(contextPtr) }!!
     }
 
-    override fun initNewJSFunction(contextPtr: Long, javaCallerId: Int): JSFunction {
-        return post { quickJSNative.initNewJSFunction(contextPtr, javaCallerId) }!!
+    override fun initNewJSFunction(contextPtr: Long, callback: JavaCallback): JSFunction {
+        return post { quickJSNative.initNewJSFunction(contextPtr, callback) }!!
+    }
+
+    override fun releasePtr(contextPtr: Long, handle: Long) {
+        postVoid { quickJSNative.releasePtr(contextPtr, handle) }
+    }
+
+    override fun getHandleCount(contextPtr: Long): Int {
+        return post { quickJSNative.getHandleCount(contextPtr) }!!
     }
 
-    override fun releasePtr(contextPtr: Long, tag: Long, uInt32: Int, uFloat64: Double, uPtr: Long) {
-        postVoid { quickJSNative.releasePtr(contextPtr, tag, uInt32, uFloat64, uPtr) }
+    override fun dumpLeaks(contextPtr: Long): Array<String> {
+        return post { quickJSNative.dumpLeaks(contextPtr) }!!
     }
 
     override fun registerJavaMethod(
         contextPtr: Long,
         objectHandle: JSValue,
         jsFunctionName: String,
-        javaCallerId: Int
+        callback: JavaCallback
     ): JSFunction {
-        return post { quickJSNative.registerJavaMethod(contextPtr, objectHandle, jsFunctionName, javaCallerId) }!!
+        return post { quickJSNative.registerJavaMethod(contextPtr, objectHandle, jsFunctionName, callback) }!!
+    }
+
+    override fun getCallbackCount(runtimePtr: Long): Int {
+        return post { quickJSNative.getCallbackCount(runtimePtr) }!!
+    }
+
+    override fun setExecutionLimits(runtimePtr: Long, timeoutMillis: Long, instructionBudget: Long) {
+        postVoid { quickJSNative.setExecutionLimits(runtimePtr, timeoutMillis, instructionBudget) }
+    }
+
+    override fun setMemoryLimit(runtimePtr: Long, limit: Long) {
+        postVoid { quickJSNative.setMemoryLimit(runtimePtr, limit) }
+    }
+
+    override fun setGCThreshold(runtimePtr: Long, threshold: Long) {
+        postVoid { quickJSNative.setGCThreshold(runtimePtr, threshold) }
+    }
+
+    override fun setMaxStackSize(runtimePtr: Long, stackSize: Long) {
+        postVoid { quickJSNative.setMaxStackSize(runtimePtr, stackSize) }
+    }
+
+    override fun runGC(runtimePtr: Long) {
+        postVoid { quickJSNative.runGC(runtimePtr) }
+    }
+
+    override fun getMemoryUsage(runtimePtr: Long): LongArray {
+        return post { quickJSNative.getMemoryUsage(runtimePtr) }!!
+    }
+
+    override fun getArenaStats(runtimePtr: Long): LongArray? {
+        return post { quickJSNative.getArenaStats(runtimePtr) }
+    }
+
+    override fun getInlineCacheStats(runtimePtr: Long): LongArray {
+        return post { quickJSNative.getInlineCacheStats(runtimePtr) }!!
+    }
+
+    override fun resetInlineCacheStats(runtimePtr: Long) {
+        postVoid { quickJSNative.resetInlineCacheStats(runtimePtr) }
+    }
+
+    override fun setOpcodeProfiling(runtimePtr: Long, enable: Boolean) {
+        postVoid { quickJSNative.setOpcodeProfiling(runtimePtr, enable) }
+    }
+
+    override fun resetOpcodeProfile(runtimePtr: Long) {
+        postVoid { quickJSNative.resetOpcodeProfile(runtimePtr) }
+    }
+
+    override fun getOpcodeProfile(runtimePtr: Long, maxEntries: Int): Array<Any>? {
+        return post { quickJSNative.getOpcodeProfile(runtimePtr, maxEntries) }
+    }
+
+    override fun startCPUProfiler(runtimePtr: Long, intervalMicros: Int): Boolean {
+        return post { quickJSNative.startCPUProfiler(runtimePtr, intervalMicros) }!!
+    }
+
+    override fun stopCPUProfiler(runtimePtr: Long) {
+        postVoid { quickJSNative.stopCPUProfiler(runtimePtr) }
+    }
+
+    override fun getCPUProfile(runtimePtr: Long): String? {
+        return post { quickJSNative.getCPUProfile(runtimePtr) }
+    }
+
+    override fun beginExecutionBudget(runtimePtr: Long, timeoutMillis: Long, instructionBudget: Long) {
+        postVoid { quickJSNative.beginExecutionBudget(runtimePtr, timeoutMillis, instructionBudget) }
+    }
+
+    override fun endExecutionBudget(runtimePtr: Long) {
+        postVoid { quickJSNative.endExecutionBudget(runtimePtr) }
+    }
+
+    /**
+     * 在 JS 线程上以单独的执行预算运行 block，预算耗尽时 block 中的 JS 调用抛出 QuickJSTimeoutException
+     */
+    fun <T> withExecutionBudget(timeoutMillis: Long, instructionBudget: Long, block: () -> T): T? {
+        return post {
+            quickJSNative.beginExecutionBudget(quickJS.runtimePtr, timeoutMillis, instructionBudget)
+            try {
+                block()
+            } finally {
+                quickJSNative.endExecutionBudget(quickJS.runtimePtr)
+            }
+        }
+    }
+
+    override fun registerTypedJavaMethod(
+        contextPtr: Long,
+        objectHandle: JSValue,
+        jsFunctionName: String,
+        kind: Int,
+        callback: Any
+    ): JSFunction {
+        return post { quickJSNative.registerTypedJavaMethod(contextPtr, objectHandle, jsFunctionName, kind, callback) }!!
     }
 
     override fun getObjectType(contextPtr: Long, objectHandle: JSValue): Int {
@@ -220,8 +446,8 @@ class EventQueue(
         return post { quickJSNative.getException(contextPtr) }
     }
 
-    override fun newClass(contextPtr: Long, javaCallerId: Int): JSFunction {
-        return post { quickJSNative.newClass(contextPtr, javaCallerId) }!!
+    override fun newClass(contextPtr: Long, callback: JavaCallback): JSFunction {
+        return post { quickJSNative.newClass(contextPtr, callback) }!!
     }
 
     override fun toJSString(contextPtr: Long, value: JSValue): String {
@@ -243,4 +469,53 @@ class EventQueue(
     override fun isError(contextPtr: Long, value: JSValue): Boolean {
         return post { quickJSNative.isError(contextPtr, value) }!!
     }
+
+    override fun newArrayBuffer(contextPtr: Long, buffer: ByteBuffer): JSObject {
+        return post { quickJSNative.newArrayBuffer(contextPtr, buffer) }!!
+    }
+
+    override fun newTypedArray(contextPtr: Long, type: Int, buffer: ByteBuffer): JSObject {
+        return post { quickJSNative.newTypedArray(contextPtr, type, buffer) }!!
+    }
+
+    override fun getArrayBuffer(contextPtr: Long, objectHandle: JSValue): ByteBuffer? {
+        return post { quickJSNative.getArrayBuffer(contextPtr, objectHandle) }
+    }
+
+    override fun toJava(contextPtr: Long, objectHandle: JSValue, depthLimit: Int): Any? {
+        return post { quickJSNative.toJava(contextPtr, objectHandle, depthLimit) }
+    }
+
+    override fun fromJava(contextPtr: Long, value: Any?, depthLimit: Int): Any? {
+        return post { quickJSNative.fromJava(contextPtr, value, depthLimit) }
+    }
+
+    override fun parseJSON(contextPtr: Long, json: String): Any? {
+        return post { quickJSNative.parseJSON(contextPtr, json) }
+    }
+
+    override fun parseJSONBytes(contextPtr: Long, bytes: ByteArray, offset: Int, length: Int): Any? {
+        return post { quickJSNative.parseJSONBytes(contextPtr, bytes, offset, length) }
+    }
+
+    override fun parseJSONBuffer(contextPtr: Long, buffer: ByteBuffer, offset: Int, length: Int): Any? {
+        return post { quickJSNative.parseJSONBuffer(contextPtr, buffer, offset, length) }
+    }
+
+    override fun stringify(contextPtr: Long, objectHandle: JSValue, indent: Int): String? {
+        return post { quickJSNative.stringify(contextPtr, objectHandle, indent) }
+    }
+
+    override fun stringifyToBytes(contextPtr: Long, objectHandle: JSValue, indent: Int): ByteArray? {
+        return post { quickJSNative.stringifyToBytes(contextPtr, objectHandle, indent) }
+    }
+
+    override fun stringifyToBuffer(
+        contextPtr: Long,
+        objectHandle: JSValue,
+        indent: Int,
+        reuse: ByteBuffer?
+    ): ByteBuffer? {
+        return post { quickJSNative.stringifyToBuffer(contextPtr, objectHandle, indent, reuse) }
+    }
 }
\ No newline at end of file
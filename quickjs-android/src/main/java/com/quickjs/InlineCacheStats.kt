@@ -0,0 +1,34 @@
+package com.quickjs
+
+/**
+ * 属性读写内联缓存的统计，与 QuickJS 的 JSInlineCacheStats 一一对应。
+ * globalHits/globalMisses 为全局变量读写的缓存统计，megamorphicCount 为因形状过多而放弃缓存的访问点数量
+ */
+data class InlineCacheStats(
+    val getHits: Long,
+    val getMisses: Long,
+    val putHits: Long,
+    val putMisses: Long,
+    val globalHits: Long,
+    val globalMisses: Long,
+    val megamorphicCount: Long
+) {
+    /**
+     * 所有缓存合计的命中率，尚无访问时为 0
+     */
+    val hitRate: Double
+        get() {
+            val hits = getHits + putHits + globalHits
+            val total = hits + getMisses + putMisses + globalMisses
+            return if (total > 0) hits.toDouble() / total else 0.0
+        }
+
+    companion object {
+        /**
+         * 按 JSInlineCacheStats 的字段顺序解析 getInlineCacheStats 返回的数组
+         */
+        @JvmStatic
+        fun fromArray(values: LongArray): InlineCacheStats =
+            InlineCacheStats(values[0], values[1], values[2], values[3], values[4], values[5], values[6])
+    }
+}
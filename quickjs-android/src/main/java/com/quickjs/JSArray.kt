@@ -10,8 +10,7 @@ class JSArray : JSObject, Collection<Any?> {
         context.native.initNewJSArray(context.contextPtr)
     )
 
-    constructor(context: JSContext, tag: Long, uInt32: Int, uFloat64: Double, uPtr: Long)
-            : super(context, tag, uInt32, uFloat64, uPtr)
+    constructor(context: JSContext, handle: Long) : super(context, handle)
 
     constructor(context: JSContext, jsonArray: JSONArray) : this(context) {
         append(this, jsonArray)
@@ -83,19 +82,7 @@ class JSArray : JSObject, Collection<Any?> {
 
     fun length(): Int = getInteger("length")
 
-    fun toJSONArray(): JSONArray {
-        val jsonArray = JSONArray()
-        for (i in 0 until length()) {
-            val obj = get(i)
-            when (obj) {
-                is Undefined, is JSFunction -> {}
-                is Number, is String, is Boolean -> jsonArray.put(obj)
-                is JSArray -> jsonArray.put(obj.toJSONArray())
-                is JSObject -> jsonArray.put(obj.toJSONObject())
-            }
-        }
-        return jsonArray
-    }
+    fun toJSONArray(): JSONArray = JSONArray(toJava() as List<*>)
 
     override fun toString(): String {
         val result = ArrayList<String>()
@@ -1,11 +1,13 @@
 package com.quickjs
 
 import java.io.Closeable
+import java.lang.ref.ReferenceQueue
+import java.lang.ref.WeakReference
+import java.nio.ByteBuffer
 import java.util.Collections
 import java.util.HashMap
 import java.util.HashSet
 import java.util.LinkedList
-import java.util.WeakHashMap
 
 open class JSContext(
     val quickJS: QuickJS,
@@ -13,63 +15,133 @@ open class JSContext(
 ): Closeable {
 
     private val plugins: MutableSet<Plugin> = Collections.synchronizedSet(HashSet())
-    val refs: MutableMap<Int, JSValue> = Collections.synchronizedMap(WeakHashMap())
-    private val releaseObjPtrPool: MutableList<Array<Any>> = Collections.synchronizedList(LinkedList())
-    val functionRegistry: MutableMap<Int, QuickJS.MethodDescriptor> = Collections.synchronizedMap(HashMap())
+
+    /**
+     * 以句柄为键跟踪 Java 侧的 JSValue，值被回收而未关闭时由 refQueue 通知释放对应句柄
+     */
+    private val refs: MutableMap<Long, HandleReference> = Collections.synchronizedMap(HashMap())
+    private val refQueue = ReferenceQueue<JSValue>()
+    private val releaseObjPtrPool: MutableList<Long> = Collections.synchronizedList(LinkedList())
+    private val propertyKeys: MutableSet<PropertyKey> = Collections.synchronizedSet(HashSet())
     private var released: Boolean = false
     val native: QuickJSNative by lazy { quickJS.native }
     val global: JSObject by lazy { native.getGlobalObject(contextPtr) }
+    private var jsonBuffer: ByteBuffer? = null
+
+    /**
+     * 严格模式下关闭上下文时若仍有未关闭的 JSValue，在释放全部资源后抛出 IllegalStateException 并附带泄漏报告
+     */
+    @Volatile
+    var strict: Boolean = false
 
     init {
         QuickJS.sContextMap[contextPtr] = this
     }
 
+    private class HandleReference(value: JSValue, queue: ReferenceQueue<JSValue>) :
+        WeakReference<JSValue>(value, queue) {
+        val handle: Long = value.handle
+    }
+
     fun addObjRef(reference: JSValue) {
-        if (reference.javaClass != JSContext::class.java) {
-            refs[reference.hashCode()] = reference
-        }
+        refs[reference.handle] = HandleReference(reference, refQueue)
     }
 
     fun releaseObjRef(reference: JSValue, finalize: Boolean) {
         if (finalize) {
-            releaseObjPtrPool.add(arrayOf(reference.tag, reference.uInt32, reference.uFloat64, reference.uPtr))
+            releaseObjPtrPool.add(reference.handle)
         } else {
-            native.releasePtr(contextPtr, reference.tag, reference.uInt32, reference.uFloat64, reference.uPtr)
+            native.releasePtr(contextPtr, reference.handle)
         }
         removeObjRef(reference)
     }
 
     private fun checkReleaseObjPtrPool() {
+        while (true) {
+            val ref = refQueue.poll() as HandleReference? ?: break
+            // 句柄可能已被显式关闭或转交给新的包装对象，只释放仍由该引用持有的句柄
+            synchronized(refs) {
+                if (refs[ref.handle] === ref) {
+                    refs.remove(ref.handle)
+                    releaseObjPtrPool.add(ref.handle)
+                }
+            }
+        }
         while (releaseObjPtrPool.isNotEmpty()) {
-            val ptr = releaseObjPtrPool[0]
-            native.releasePtr(contextPtr, ptr[0] as Long, ptr[1] as Int, ptr[2] as Double, ptr[3] as Long)
+            native.releasePtr(contextPtr, releaseObjPtrPool[0])
             releaseObjPtrPool.removeAt(0)
         }
     }
 
     fun removeObjRef(reference: JSValue) {
-        refs.remove(reference.hashCode())
+        synchronized(refs) {
+            if (refs[reference.handle]?.get() === reference) {
+                refs.remove(reference.handle)
+            }
+        }
+    }
+
+    /**
+     * 原生层中属于本上下文、尚未释放的值的数量
+     */
+    val handleCount: Int
+        get() = native.getHandleCount(contextPtr)
+
+    /**
+     * 按创建位置和类型汇总尚未释放的值，例如 "executeScript JSObject x3"
+     */
+    fun dumpLeaks(): List<String> {
+        checkReleaseObjPtrPool()
+        return native.dumpLeaks(contextPtr).toList()
+    }
+
+    internal fun addPropertyKey(key: PropertyKey) {
+        propertyKeys.add(key)
+    }
+
+    internal fun removePropertyKey(key: PropertyKey) {
+        propertyKeys.remove(key)
     }
 
+    fun newPropertyKey(name: String): PropertyKey = PropertyKey(this, name)
+
     override fun close() {
         if (released) return
         plugins.forEach { it.close(this@JSContext) }
         plugins.clear()
-        functionRegistry.clear()
-        refs.values.toTypedArray().forEach { it.close() }
+        propertyKeys.toTypedArray().forEach { it.close() }
+        global.close()
+        val leaks = dumpLeaks()
+        if (leaks.isNotEmpty()) {
+            QuickJSLog.w("JSContext closed with unreleased values: $leaks")
+        }
+        synchronized(refs) { refs.values.mapNotNull { it.get() } }.forEach { it.close() }
         checkReleaseObjPtrPool()
         native.releaseContext(contextPtr)
         QuickJS.sContextMap.remove(contextPtr)
         released = true
+        if (strict && leaks.isNotEmpty()) {
+            throw IllegalStateException("JSContext closed with unreleased values: " + leaks.joinToString())
+        }
     }
 
     open fun registerJavaMethod(jsFunctionName: String, callback: JavaCallback): JSFunction {
         checkReleased()
-        val functionHandle = native.registerJavaMethod(contextPtr, global, jsFunctionName, callback.hashCode())
-        registerCallback(callback)
-        return functionHandle
+        return native.registerJavaMethod(contextPtr, global, jsFunctionName, callback)
     }
 
+    fun registerJavaMethod(jsFunctionName: String, callback: DoubleUnaryCallback): JSFunction =
+        global.registerJavaMethod(jsFunctionName, callback)
+
+    fun registerJavaMethod(jsFunctionName: String, callback: DoubleBinaryCallback): JSFunction =
+        global.registerJavaMethod(jsFunctionName, callback)
+
+    fun registerJavaMethod(jsFunctionName: String, callback: IntBinaryCallback): JSFunction =
+        global.registerJavaMethod(jsFunctionName, callback)
+
+    fun registerJavaMethod(jsFunctionName: String, callback: StringCallback): JSFunction =
+        global.registerJavaMethod(jsFunctionName, callback)
+
     /*open fun registerJavaMethod(jsFunctionName: String, callback: JavaVoidCallback): JSFunction {
         checkReleased()
         val functionHandle = native.registerJavaMethod(contextPtr, global, jsFunctionName, callback.hashCode(), true)
@@ -92,6 +164,29 @@ open class JSContext(
         return obj
     }
 
+    /**
+     * 异步执行脚本，调用线程不会等待 JS 线程
+     */
+    fun executeScriptAsync(source: String, fileName: String): QuickJSFuture<Any?> =
+        quickJS.native.postAsync { executeScript(source, fileName) }
+
+    fun executeModuleScriptAsync(source: String, fileName: String): QuickJSFuture<Any?> =
+        quickJS.native.postAsync { executeModuleScript(source, fileName) }
+
+    /**
+     * 编译脚本为字节码，之后可通过 executeBytecode 在本运行时的任意上下文中执行，省去解析开销
+     */
+    @JvmOverloads
+    fun compileScript(source: String, fileName: String, evalType: Int = QuickJS.JS_EVAL_TYPE_GLOBAL): ByteArray {
+        checkReleased()
+        return native.compileScript(contextPtr, source, fileName, evalType)
+    }
+
+    fun executeBytecode(bytecode: ByteArray): Any? {
+        checkReleased()
+        return native.executeBytecode(contextPtr, JSValue.TYPE.UNKNOWN.value, bytecode)
+    }
+
     open fun executeModuleScript(source: String, fileName: String): Any? {
         val obj = native.executeScript(this.contextPtr, JSValue.TYPE.UNKNOWN.value, source, fileName, QuickJS.JS_EVAL_TYPE_MODULE)
         QuickJS.checkException(this)
@@ -123,18 +218,6 @@ open class JSContext(
     fun isReleased(): Boolean =
         quickJS.released || released
 
-    fun registerCallback(callback: JavaCallback) {
-        val methodDescriptor = QuickJS.MethodDescriptor()
-        methodDescriptor.callback = callback
-        functionRegistry[callback.hashCode()] = methodDescriptor
-    }
-
-    /*fun registerCallback(callback: JavaVoidCallback) {
-        val methodDescriptor = QuickJS.MethodDescriptor()
-        methodDescriptor.voidCallback = callback
-        functionRegistry[callback.hashCode()] = methodDescriptor
-    }*/
-
     fun checkRuntime(value: JSValue?) {
         if (value != null && !value.isUndefined()) {
             val quickJS = value.context.quickJS
@@ -160,6 +243,69 @@ open class JSContext(
         if (isReleased()) throw Error("Context disposed error")
     }
 
+    /**
+     * 在原生层一次性把 Map/Collection/数组构成的 Java 对象图转换为 JS 值，对象与数组返回 JSObject/JSArray，
+     * byte[] 转为 Uint8Array，其它基本类型数组转为对应的有符号 TypedArray。
+     * Map 的非字符串键使用 toString()，null 键为 "null"
+     */
+    @JvmOverloads
+    fun fromJava(value: Any?, depthLimit: Int = JSObject.DEFAULT_DEPTH_LIMIT): Any? {
+        checkReleased()
+        return native.fromJava(contextPtr, value, depthLimit)
+    }
+
+    fun parseJSON(json: String): Any? {
+        checkReleased()
+        return native.parseJSON(contextPtr, json)
+    }
+
+    /**
+     * 直接解析 UTF-8 字节，适合从网络或文件读到的大段 JSON
+     */
+    @JvmOverloads
+    fun parseJSONBytes(bytes: ByteArray, offset: Int = 0, length: Int = bytes.size - offset): Any? {
+        checkReleased()
+        return native.parseJSONBytes(contextPtr, bytes, offset, length)
+    }
+
+    /**
+     * 解析 direct ByteBuffer 中 position 到 limit 之间的 UTF-8 字节，不改变 position；
+     * limit 之后紧跟 0 字节时原地解析，不复制
+     */
+    fun parseJSONBytes(buffer: ByteBuffer): Any? {
+        checkReleased()
+        require(buffer.isDirect) { "ByteBuffer must be a direct buffer" }
+        return native.parseJSONBuffer(contextPtr, buffer, buffer.position(), buffer.remaining())
+    }
+
+    /**
+     * 按 JSON.stringify 序列化，值无法序列化（如 undefined、函数）时返回 null
+     */
+    @JvmOverloads
+    fun stringify(value: JSValue, indent: Int = 0): String? {
+        checkReleased()
+        return native.stringify(contextPtr, value, indent)
+    }
+
+    @JvmOverloads
+    fun stringifyToBytes(value: JSValue, indent: Int = 0): ByteArray? {
+        checkReleased()
+        return native.stringifyToBytes(contextPtr, value, indent)
+    }
+
+    /**
+     * 序列化为 UTF-8 写入本上下文复用的 direct ByteBuffer，返回的缓冲区 position 为 0、limit 为字节数，
+     * 内容在下一次调用 stringifyToBuffer 前有效
+     */
+    @JvmOverloads
+    @Synchronized
+    fun stringifyToBuffer(value: JSValue, indent: Int = 0): ByteBuffer? {
+        checkReleased()
+        val buffer = native.stringifyToBuffer(contextPtr, value, indent, jsonBuffer) ?: return null
+        jsonBuffer = buffer
+        return buffer
+    }
+
     fun toJSString(obj: JSValue): String {
         return native.toJSString(contextPtr, obj) ?: "undefined"
     }
@@ -168,6 +314,24 @@ open class JSContext(
         return native.getPrototype(contextPtr, obj)
     }
 
+    /**
+     * 以零拷贝方式把 direct ByteBuffer 包装为 ArrayBuffer，JS 对象存活期间持有该 ByteBuffer
+     */
+    fun newArrayBuffer(buffer: ByteBuffer): JSObject {
+        checkReleased()
+        require(buffer.isDirect) { "ByteBuffer must be a direct buffer" }
+        return native.newArrayBuffer(contextPtr, buffer)
+    }
+
+    /**
+     * 以零拷贝方式把 direct ByteBuffer 包装为 TypedArray，type 取 JSValue.TYPE_XXX_ARRAY
+     */
+    fun newTypedArray(type: Int, buffer: ByteBuffer): JSObject {
+        checkReleased()
+        require(buffer.isDirect) { "ByteBuffer must be a direct buffer" }
+        return native.newTypedArray(contextPtr, type, buffer)
+    }
+
 //    fun getNative(): QuickJSNative = quickJS.native
 
 }
\ No newline at end of file
@@ -1,6 +1,6 @@
 package com.quickjs
 
-class JSException(context: JSContext, tag: Long, uInt32: Int, uFloat64: Double, uPtr: Long) : JSObject(context, tag, uInt32, uFloat64, uPtr) {
+class JSException(context: JSContext, handle: Long) : JSObject(context, handle) {
 
     val name: String
         get() = this["name"].toString()
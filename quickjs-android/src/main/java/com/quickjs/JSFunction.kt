@@ -5,12 +5,9 @@ open class JSFunction : JSObject {
     constructor(context: JSContext, callback: JavaCallback) : this(context, callback, false)
 
     private constructor(context: JSContext, callback: JavaCallback, isVoid: Boolean) :
-            super(context, context.native.initNewJSFunction(context.contextPtr, callback.hashCode())) {
-        context.registerCallback(callback)
-    }
+            super(context, context.native.initNewJSFunction(context.contextPtr, callback))
 
-    internal constructor(context: JSContext, tag: Long, uInt32: Int, uFloat64: Double, uPtr: Long) :
-            super(context, tag, uInt32, uFloat64, uPtr)
+    internal constructor(context: JSContext, handle: Long) : super(context, handle)
 
     open fun call(type: TYPE, receiver: JSObject? = null, vararg parameters: Any?): Any? {
         context.checkReleased()
@@ -25,6 +22,22 @@ open class JSFunction : JSObject {
         return call(TYPE.UNKNOWN, receiver, *parameters)
     }
 
+    /**
+     * 绑定 this 并返回类型化调用入口，适合高频调用
+     */
+    @JvmOverloads
+    fun prepare(receiver: JSObject? = null): PreparedCall {
+        context.checkReleased()
+        return PreparedCall(this, receiver)
+    }
+
+    /**
+     * 异步调用，调用线程不会等待 JS 线程
+     */
+    fun callAsync(receiver: JSObject? = null, vararg parameters: Any?): QuickJSFuture<Any?> {
+        return context.quickJS.native.postAsync { call(TYPE.UNKNOWN, receiver, *parameters) }
+    }
+
     override fun toString(): String {
         val result = context.native.toJSString(context.contextPtr, this) ?: return "undefined"
 
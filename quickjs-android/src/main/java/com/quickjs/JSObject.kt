@@ -4,6 +4,8 @@ import android.webkit.JavascriptInterface
 import org.json.JSONArray
 import org.json.JSONObject
 import java.lang.reflect.Method
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 import java.util.ArrayList
 import java.util.Collection
 
@@ -33,9 +35,11 @@ open class JSObject : JSValue {
 
     constructor(context: JSContext, value: JSValue) : super(context, value)
 
-    constructor(context: JSContext, tag: Long, uInt32: Int, uFloat64: Double, uPtr: Long) : super(context, tag, uInt32, uFloat64, uPtr)
+    constructor(context: JSContext, handle: Long) : super(context, handle)
 
     companion object {
+        const val DEFAULT_DEPTH_LIMIT = 64
+
         private fun JSONObject.appendTo(jsObject: JSObject) {
             keys().forEach { key ->
                 when (val value = opt(key)) {
@@ -115,6 +119,60 @@ open class JSObject : JSValue {
         setObject(key, value)
     }
 
+    open fun get(expectedType: TYPE?, key: PropertyKey): Any? {
+        context.checkReleased()
+        key.checkReleased()
+        val type = expectedType ?: TYPE.UNKNOWN
+        val obj = context.native.getAtom(getContextPtr(), type.value, this, key.atom)
+        return checkType(obj, type)
+    }
+
+    operator fun get(key: PropertyKey): Any? = get(TYPE.UNKNOWN, key)
+
+    operator fun set(key: PropertyKey, value: Any?) {
+        setObject(key, value)
+    }
+
+    protected open fun setObject(key: PropertyKey, value: Any?): JSObject {
+        context.checkReleased()
+        key.checkReleased()
+        if (value is JSValue) context.checkRuntime(value)
+        context.native.setAtom(getContextPtr(), this, key.atom, value)
+        return this
+    }
+
+    fun getInteger(key: PropertyKey): Int = get(TYPE.INTEGER, key) as Int
+    fun getBoolean(key: PropertyKey): Boolean = get(TYPE.BOOLEAN, key) as Boolean
+    fun getDouble(key: PropertyKey): Double = get(TYPE.DOUBLE, key) as Double
+    fun getString(key: PropertyKey): String? = get(TYPE.STRING, key) as String?
+    fun getArray(key: PropertyKey): JSArray = get(TYPE.JS_ARRAY, key) as JSArray
+    fun getObject(key: PropertyKey): JSObject = get(TYPE.JS_OBJECT, key) as JSObject
+
+    /**
+     * 批量读取属性，只经过一次事件队列和一次 JNI 调用，结果与 keys 一一对应
+     */
+    fun getMany(keys: Array<String>): Array<Any?> {
+        context.checkReleased()
+        return getNative().getMany(getContextPtr(), this, keys)
+    }
+
+    /**
+     * 批量设置属性，只经过一次事件队列和一次 JNI 调用
+     */
+    fun setMany(keys: Array<String>, values: Array<out Any?>): JSObject {
+        context.checkReleased()
+        require(keys.size == values.size) { "keys and values must have the same size" }
+        values.filterIsInstance<JSValue>().forEach { context.checkRuntime(it) }
+        getNative().setMany(getContextPtr(), this, keys, values)
+        return this
+    }
+
+    fun getMany(keys: Array<PropertyKey>): Array<Any?> {
+        context.checkReleased()
+        keys.forEach { it.checkReleased() }
+        return getNative().getManyAtoms(getContextPtr(), this, IntArray(keys.size) { keys[it].atom })
+    }
+
     fun getInteger(key: String): Int = get(TYPE.INTEGER, key) as Int
     fun getBoolean(key: String): Boolean = get(TYPE.BOOLEAN, key) as Boolean
     fun getDouble(key: String): Double = get(TYPE.DOUBLE, key) as Double
@@ -131,9 +189,7 @@ open class JSObject : JSValue {
 
     open fun registerJavaMethod(jsFunctionName: String, callback: JavaCallback): JSFunction {
         context.checkReleased()
-        val functionHandle = getNative().registerJavaMethod(getContextPtr(), this, jsFunctionName, callback.hashCode())
-        context.registerCallback(callback)
-        return functionHandle
+        return getNative().registerJavaMethod(getContextPtr(), this, jsFunctionName, callback)
     }
 
     /*open fun registerJavaMethod(jsFunctionName: String, callback: JavaVoidCallback): JSFunction {
@@ -143,6 +199,26 @@ open class JSObject : JSValue {
         return functionHandle
     }*/
 
+    /**
+     * 基本类型签名的回调直接由原生层调用，不经过回调注册表，生命周期跟随 JS 函数
+     */
+    fun registerJavaMethod(jsFunctionName: String, callback: DoubleUnaryCallback): JSFunction =
+        registerTypedJavaMethod(jsFunctionName, TYPED_CALLBACK_DOUBLE_UNARY, callback)
+
+    fun registerJavaMethod(jsFunctionName: String, callback: DoubleBinaryCallback): JSFunction =
+        registerTypedJavaMethod(jsFunctionName, TYPED_CALLBACK_DOUBLE_BINARY, callback)
+
+    fun registerJavaMethod(jsFunctionName: String, callback: IntBinaryCallback): JSFunction =
+        registerTypedJavaMethod(jsFunctionName, TYPED_CALLBACK_INT_BINARY, callback)
+
+    fun registerJavaMethod(jsFunctionName: String, callback: StringCallback): JSFunction =
+        registerTypedJavaMethod(jsFunctionName, TYPED_CALLBACK_STRING, callback)
+
+    private fun registerTypedJavaMethod(jsFunctionName: String, kind: Int, callback: Any): JSFunction {
+        context.checkReleased()
+        return getNative().registerTypedJavaMethod(getContextPtr(), this, jsFunctionName, kind, callback)
+    }
+
     open fun registerClass(className: String, javaConstructorCallback: JavaConstructorCallback): JSFunction {
         val callback = object : JavaCallback {
             override fun invoke(
@@ -154,8 +230,7 @@ open class JSObject : JSValue {
             }
         }
 
-        val functionHandle = getNative().newClass(getContextPtr(), callback.hashCode())
-        context.registerCallback(callback)
+        val functionHandle = getNative().newClass(getContextPtr(), callback)
         set(className, functionHandle)
         return functionHandle
     }
@@ -172,6 +247,13 @@ open class JSObject : JSValue {
         executeFunction(TYPE.NULL, name, parameters)
     }
 
+    /**
+     * 异步调用成员函数，调用线程不会等待 JS 线程
+     */
+    fun executeFunctionAsync(name: String, vararg parameters: Any?): QuickJSFuture<Any?> {
+        return context.quickJS.native.postAsync { executeFunction(TYPE.UNKNOWN, name, *parameters) }
+    }
+
     fun executeFunction2(name: String, vararg parameters: Any?): Any? {
         context.checkReleased()
         return QuickJS.executeFunction(context, this, name, parameters)
@@ -182,6 +264,24 @@ open class JSObject : JSValue {
         return getNative().contains(getContextPtr(), this, key)
     }
 
+    fun contains(key: PropertyKey): Boolean {
+        context.checkReleased()
+        key.checkReleased()
+        return getNative().containsAtom(getContextPtr(), this, key.atom)
+    }
+
+    fun executeFunction(key: PropertyKey, vararg parameters: Any?): Any? =
+        executeFunction(TYPE.UNKNOWN, key, *parameters)
+
+    open fun executeFunction(expectedType: TYPE, key: PropertyKey, vararg parameters: Any?): Any? {
+        context.checkReleased()
+        key.checkReleased()
+        parameters.filterIsInstance<JSValue>().forEach { context.checkRuntime(it) }
+        val obj = getNative().executeFunctionAtom(getContextPtr(), expectedType.value, this, key.atom, parameters)
+        QuickJS.checkException(context)
+        return checkType(obj, expectedType)
+    }
+
     fun getKeys(): Array<String> {
         context.checkReleased()
         return getNative().getKeys(getContextPtr(), this)
@@ -266,16 +366,28 @@ open class JSObject : JSValue {
         return (0 until length.toInt()).map { this.get(it.toString()) }
     }
 
-    fun toJSONObject(): JSONObject {
-        val jsonObject = JSONObject()
-        getKeys().forEach { key ->
-            when (val value = get(key)) {
-                is Number, is String, is Boolean -> jsonObject.put(key, value)
-                is JSArray -> jsonObject.put(key, value.toJSONArray())
-                is JSObject -> jsonObject.put(key, value.toJSONObject())
-            }
-        }
-        return jsonObject
+    fun toJSONObject(): JSONObject = JSONObject(toJava() as Map<*, *>)
+
+    /**
+     * 在原生层一次性把对象图转换为 Java 对象：对象为 HashMap，数组为 ArrayList，
+     * TypedArray/ArrayBuffer 为基本类型数组，函数等无法表示的值被跳过。
+     * Uint16Array/Uint32Array/BigUint64Array 按位复制为 short[]/int[]/long[]，大于有符号上限的元素读出为负数，
+     * 需要时用 `toInt() and 0xffff`、`toLong() and 0xffffffffL` 还原。
+     * 循环引用或嵌套超过 depthLimit 时抛出 QuickJSException
+     */
+    @JvmOverloads
+    fun toJava(depthLimit: Int = DEFAULT_DEPTH_LIMIT): Any? {
+        context.checkReleased()
+        return getNative().toJava(getContextPtr(), this, depthLimit)
+    }
+
+    /**
+     * 以 direct ByteBuffer 的形式直接访问 ArrayBuffer/TypedArray 的内存，不是二进制对象时返回 null。
+     * 返回的 ByteBuffer 只在当前对象未释放、且 ArrayBuffer 未被 detach 时有效
+     */
+    fun toByteBuffer(): ByteBuffer? {
+        context.checkReleased()
+        return getNative().getArrayBuffer(getContextPtr(), this)?.order(ByteOrder.nativeOrder())
     }
 
     fun getPrototype(): JSObject {
@@ -297,8 +409,8 @@ open class JSObject : JSValue {
         return getKeys().associateWith { key -> get(key)?.toString() ?: "null" }.toString()
     }
 
-    open class Undefined(context: JSContext, tag: Long, uInt32: Int, uFloat64: Double, uPtr: Long) :
-        JSObject(context, tag, uInt32, uFloat64, uPtr) {
+    open class Undefined(context: JSContext, handle: Long) :
+        JSObject(context, handle) {
 
         init {
             released = true
@@ -312,6 +424,14 @@ open class JSObject : JSValue {
             throw UnsupportedOperationException()
         }
 
+        override fun setObject(key: PropertyKey, value: Any?): JSObject {
+            throw UnsupportedOperationException()
+        }
+
+        override fun get(expectedType: TYPE?, key: PropertyKey): Any? {
+            throw UnsupportedOperationException()
+        }
+
         override fun registerJavaMethod(
             jsFunctionName: String,
             callback: JavaCallback
@@ -323,6 +443,10 @@ open class JSObject : JSValue {
             throw UnsupportedOperationException()
         }
 
+        override fun executeFunction(expectedType: TYPE, key: PropertyKey, vararg parameters: Any?): Any? {
+            throw UnsupportedOperationException()
+        }
+
         override fun hashCode(): Int = TYPE_UNDEFINED
 
         override fun toString(): String = "undefined"
@@ -18,8 +18,21 @@ open class JSValue: Closeable {
         const val TYPE_JS_OBJECT = 6
         const val TYPE_JS_FUNCTION = 7
         const val TYPE_JS_EXCEPTION = 8
+        const val TYPE_INT_8_ARRAY = 9
+        const val TYPE_JS_ARRAY_BUFFER = 10
+        const val TYPE_UNSIGNED_INT_8_ARRAY = 11
+        const val TYPE_UNSIGNED_INT_8_CLAMPED_ARRAY = 12
+        const val TYPE_INT_16_ARRAY = 13
+        const val TYPE_UNSIGNED_INT_16_ARRAY = 14
+        const val TYPE_UNSIGNED_INT_32_ARRAY = 15
+        const val TYPE_FLOAT_32_ARRAY = 16
+        const val TYPE_INT_32_ARRAY = 1
+        const val TYPE_FLOAT_64_ARRAY = 2
         const val TYPE_UNDEFINED = 99
 
+        // undefined 不占用原生句柄槽位，所有 Undefined 共用这个句柄，无需释放
+        const val UNDEFINED_HANDLE = 0L
+
         private val typeMap = mapOf(
             TYPE_UNDEFINED to TYPE.UNDEFINED,
             TYPE_INTEGER to TYPE.INTEGER,
@@ -64,32 +77,27 @@ open class JSValue: Closeable {
     }
 
     val context: JSContext
+
+    /**
+     * 原生句柄表中的句柄（代数 + 槽位），值释放后句柄失效，再次使用会被原生层识别
+     */
     @JvmField
-    val tag: Long
-    @JvmField
-    val uInt32: Int
-    @JvmField
-    val uFloat64: Double
-    @JvmField
-    val uPtr: Long
+    val handle: Long
     val quickJS: QuickJS
 
-    constructor(context: JSContext, tag: Long, uInt32: Int, uFloat64: Double, uPtr: Long) {
+    constructor(context: JSContext, handle: Long) {
         this.context = context
-        this.tag = tag
-        this.uInt32 = uInt32
-        this.uFloat64 = uFloat64
-        this.uPtr = uPtr
+        this.handle = handle
         quickJS = context.quickJS
+        if (handle != UNDEFINED_HANDLE) {
+            context.addObjRef(this)
+        }
     }
 
-    constructor(context: JSContext, value: JSValue) : this(context, value.tag, value.uInt32, value.uFloat64, value.uPtr) {
+    constructor(context: JSContext, value: JSValue) : this(context, value.handle) {
+        // 句柄转交给新的包装对象，主构造函数已替换跟踪记录
         value.released = true
-        context.let {
-            it.removeObjRef(value)
-            it.addObjRef(this)
-            it.checkReleased()
-        }
+        context.checkReleased()
     }
 
     protected fun checkReleased() {
@@ -122,7 +130,7 @@ open class JSValue: Closeable {
     }
 
     override fun equals(other: Any?): Boolean =
-        other is JSValue && other.tag == this.tag
+        other is JSValue && other.context == this.context && other.handle == this.handle
 
 
     protected fun getNative(): QuickJSNative = context.native
@@ -134,12 +142,6 @@ open class JSValue: Closeable {
     }
 
     override fun hashCode(): Int {
-        var result = context.hashCode()
-        result = 31 * result + tag.hashCode()
-        result = 31 * result + uInt32
-        result = 31 * result + uFloat64.hashCode()
-        result = 31 * result + uPtr.hashCode()
-        result = 31 * result + released.hashCode()
-        return result
+        return 31 * context.hashCode() + handle.hashCode()
     }
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+package com.quickjs
+
+/**
+ * 运行时内存统计，与 QuickJS 的 JSMemoryUsage 一一对应，大小单位为字节。
+ * mallocLimit 为 -1 表示未设置内存上限
+ */
+data class MemoryUsage(
+    val mallocSize: Long,
+    val mallocLimit: Long,
+    val memoryUsedSize: Long,
+    val mallocCount: Long,
+    val memoryUsedCount: Long,
+    val atomCount: Long,
+    val atomSize: Long,
+    val stringCount: Long,
+    val stringSize: Long,
+    val objectCount: Long,
+    val objectSize: Long,
+    val propertyCount: Long,
+    val propertySize: Long,
+    val shapeCount: Long,
+    val shapeSize: Long,
+    val jsFunctionCount: Long,
+    val jsFunctionSize: Long,
+    val jsFunctionCodeSize: Long,
+    val jsFunctionPc2lineCount: Long,
+    val jsFunctionPc2lineSize: Long,
+    val cFunctionCount: Long,
+    val arrayCount: Long,
+    val fastArrayCount: Long,
+    val fastArrayElements: Long,
+    val binaryObjectCount: Long,
+    val binaryObjectSize: Long
+) {
+    companion object {
+        /**
+         * 按 JSMemoryUsage 的字段顺序解析 getMemoryUsage 返回的数组
+         */
+        @JvmStatic
+        fun fromArray(values: LongArray): MemoryUsage = MemoryUsage(
+            values[0], values[1], values[2], values[3], values[4], values[5], values[6],
+            values[7], values[8], values[9], values[10], values[11], values[12], values[13],
+            values[14], values[15], values[16], values[17], values[18], values[19], values[20],
+            values[21], values[22], values[23], values[24], values[25]
+        )
+    }
+}
@@ -0,0 +1,64 @@
+package com.quickjs
+
+import java.io.Closeable
+import java.util.ArrayDeque
+
+/**
+ * 周期性采样运行时内存：采样在 JS 线程的空闲间隙执行，不额外创建线程，
+ * 最近 capacity 个样本保存在环形队列中，并记录 mallocSize 最高的样本。
+ * 每次采样遍历整个堆，间隔不宜过短。
+ */
+class MemoryUsageSampler @JvmOverloads constructor(
+    private val quickJS: QuickJS,
+    private val intervalMillis: Long,
+    private val capacity: Int = 60,
+    private val listener: ((MemoryUsage) -> Unit)? = null
+) : Closeable {
+    private val samples = ArrayDeque<MemoryUsage>(capacity)
+
+    @Volatile
+    private var closed = false
+
+    @Volatile
+    var peak: MemoryUsage? = null
+        private set
+
+    @Volatile
+    var latest: MemoryUsage? = null
+        private set
+
+    private val task = object : Runnable {
+        override fun run() {
+            if (closed || quickJS.isReleased()) return
+            record(quickJS.memoryUsage)
+            quickJS.native.eventLoop.postDelayed(this, intervalMillis)
+        }
+    }
+
+    init {
+        require(intervalMillis > 0) { "Sampling interval must be positive" }
+        require(capacity > 0) { "Sampler capacity must be positive" }
+        quickJS.native.eventLoop.post(task)
+    }
+
+    private fun record(usage: MemoryUsage) {
+        synchronized(samples) {
+            if (samples.size == capacity) samples.removeFirst()
+            samples.addLast(usage)
+        }
+        latest = usage
+        if (usage.mallocSize > (peak?.mallocSize ?: -1)) peak = usage
+        listener?.invoke(usage)
+    }
+
+    /**
+     * 按时间顺序返回保留的样本
+     */
+    fun samples(): List<MemoryUsage> = synchronized(samples) { ArrayList(samples) }
+
+    override fun close() {
+        if (closed) return
+        closed = true
+        quickJS.native.eventLoop.removeCallbacks(task)
+    }
+}
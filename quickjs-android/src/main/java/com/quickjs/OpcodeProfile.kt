@@ -0,0 +1,91 @@
+package com.quickjs
+
+import java.util.Locale
+
+/**
+ * 字节码剖析报告，各列表按执行次数从多到少排序。total 为执行的字节码总数，
+ * 字节码名称与 quickjs-opcode.h 一致，包括内联缓存版本（如 get_field_ic）和超级指令（如 lt_if_false）
+ */
+data class OpcodeProfile(
+    val total: Long,
+    val opcodes: List<OpcodeCount>,
+    val pairs: List<PairCount>,
+    val functions: List<FunctionProfile>
+) {
+    data class OpcodeCount(val name: String, val count: Long)
+
+    /**
+     * 同一函数内先后执行的两个字节码
+     */
+    data class PairCount(val first: String, val second: String, val count: Long)
+
+    /**
+     * 单个函数的统计，按函数名和定义位置合并，因此多次执行的同一脚本只有一项。
+     * fileName 为空表示没有调试信息，loops 为向后跳转（循环迭代）次数，opcodes 为该函数自身执行的字节码数
+     */
+    data class FunctionProfile(
+        val name: String,
+        val fileName: String,
+        val line: Int,
+        val column: Int,
+        val calls: Long,
+        val loops: Long,
+        val opcodes: Long
+    )
+
+    /**
+     * 与 qjs --opcode-profile 相同格式的文本报告
+     */
+    fun format(): String {
+        val builder = StringBuilder()
+        builder.appendFormat("%-32s %12s %6s\n", "OPCODES", "COUNT", "%")
+        opcodes.forEach { builder.appendFormat("%-32s %12d %6.2f\n", it.name, it.count, percent(it.count)) }
+        builder.appendFormat("\n%-32s %12s %6s\n", "OPCODE PAIRS", "COUNT", "%")
+        pairs.forEach {
+            builder.appendFormat("%-32s %12d %6.2f\n", it.first + " " + it.second, it.count, percent(it.count))
+        }
+        builder.appendFormat("\n%-32s %12s %12s %12s  %s\n", "FUNCTIONS", "OPCODES", "CALLS", "LOOPS", "LOCATION")
+        functions.forEach {
+            builder.appendFormat(
+                "%-32s %12d %12d %12d  %s:%d:%d\n",
+                it.name.ifEmpty { "<anonymous>" }, it.opcodes, it.calls, it.loops,
+                it.fileName.ifEmpty { "<unknown>" }, it.line, it.column
+            )
+        }
+        return builder.toString()
+    }
+
+    private fun StringBuilder.appendFormat(format: String, vararg args: Any) {
+        append(String.format(Locale.ROOT, format, *args))
+    }
+
+    private fun percent(count: Long): Double = if (total > 0) 100.0 * count / total else 0.0
+
+    companion object {
+        @JvmField
+        val EMPTY = OpcodeProfile(0, emptyList(), emptyList(), emptyList())
+
+        /**
+         * 解析 getOpcodeProfile 返回的数组。values 依次为总数、字节码项数、字节码对项数、函数项数，
+         * 之后每个字节码 1 个计数，每个字节码对 1 个计数，每个函数 5 个值（行、列、调用、循环、字节码数）；
+         * names 依次为各字节码名称、各字节码对的两个名称、各函数的函数名和文件名
+         */
+        @JvmStatic
+        fun fromArrays(names: Array<String>, values: LongArray): OpcodeProfile {
+            val opcodeCount = values[1].toInt()
+            val pairCount = values[2].toInt()
+            val functionCount = values[3].toInt()
+            var v = 4
+            var n = 0
+            val opcodes = List(opcodeCount) { OpcodeCount(names[n++], values[v++]) }
+            val pairs = List(pairCount) { PairCount(names[n++], names[n++], values[v++]) }
+            val functions = List(functionCount) {
+                FunctionProfile(
+                    names[n++], names[n++], values[v++].toInt(), values[v++].toInt(),
+                    values[v++], values[v++], values[v++]
+                )
+            }
+            return OpcodeProfile(values[0], opcodes, pairs, functions)
+        }
+    }
+}
@@ -0,0 +1,41 @@
+package com.quickjs
+
+/**
+ * 预先绑定函数与 this 的调用入口，热路径上只传递原始句柄和基本类型参数。
+ *
+ * 不持有函数和接收者的所有权，它们关闭后继续调用会抛出 QuickJSException。
+ * JS 抛出的异常直接以 QuickJSException 抛出，不需要再调用 QuickJS.checkException。
+ */
+class PreparedCall internal constructor(
+    val function: JSFunction,
+    val receiver: JSObject?
+) {
+    private val context = function.context
+    private val native = context.native
+    private val contextPtr = context.contextPtr
+    private val functionHandle = function.handle
+    private val thisHandle = receiver?.handle ?: 0L
+
+    init {
+        receiver?.let { context.checkRuntime(it) }
+    }
+
+    fun callII(a: Int, b: Int): Int =
+        native.callII(contextPtr, thisHandle, functionHandle, a, b)
+
+    fun callDD(a: Double, b: Double): Double =
+        native.callDD(contextPtr, thisHandle, functionHandle, a, b)
+
+    fun callLL(a: Long, b: Long): Long =
+        native.callLL(contextPtr, thisHandle, functionHandle, a, b)
+
+    fun callVoid() {
+        native.callVoid(contextPtr, thisHandle, functionHandle)
+    }
+
+    /**
+     * 任意个数的 double 参数，返回 double
+     */
+    fun callDoubles(vararg args: Double): Double =
+        native.callDoubles(contextPtr, thisHandle, functionHandle, args)
+}
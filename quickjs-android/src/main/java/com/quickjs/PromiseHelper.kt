@@ -12,19 +12,19 @@ class PromiseHelper(private val ctx: JSContext) {
         val resolveReject = resolveRejectArray.get(1) as JSArray
         val resolve = resolveReject.get(0) as JSFunction
         val reject = resolveReject.get(1) as JSFunction
-        val handler = ctx.quickJS.native.handler
+        val eventLoop = ctx.quickJS.native.eventLoop
 
         // 2. 交给你的异步逻辑
 //        block(resolve, reject)
         block(
             JSFunction(ctx) { _, args ->
-                handler.post {
+                eventLoop.post {
                     // resolve
                     resolve.call(null, *args)
                 }
             },
             JSFunction(ctx) { _, args ->
-                handler.post {
+                eventLoop.post {
                     // reject
                     reject.call(null, *args)
                 }
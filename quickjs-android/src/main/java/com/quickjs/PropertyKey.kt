@@ -0,0 +1,37 @@
+package com.quickjs
+
+import java.io.Closeable
+
+/**
+ * 预先创建好 JSAtom 的属性名，用于频繁读写同一批属性的场景，
+ * 避免每次调用都进行 UTF-8 转换和 atom 哈希。close() 或 JSContext 关闭时释放 atom
+ */
+class PropertyKey(val context: JSContext, val name: String) : Closeable {
+    @Volatile
+    var released: Boolean = false
+        private set
+
+    internal val atom: Int
+
+    init {
+        context.checkReleased()
+        atom = context.native.newAtom(context.contextPtr, name)
+        context.addPropertyKey(this)
+    }
+
+    internal fun checkReleased() {
+        if (released) throw IllegalStateException("PropertyKey '$name' 已释放")
+        context.checkReleased()
+    }
+
+    override fun close() {
+        if (released) return
+        released = true
+        context.removePropertyKey(this)
+        if (!context.isReleased()) {
+            context.native.freeAtom(context.contextPtr, atom)
+        }
+    }
+
+    override fun toString(): String = name
+}
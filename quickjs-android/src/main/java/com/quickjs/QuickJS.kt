@@ -3,18 +3,23 @@ package com.quickjs
 import android.os.Environment
 import android.os.Handler
 import android.os.HandlerThread
+import android.os.Looper
 import androidx.annotation.Keep
 import java.io.Closeable
 import java.io.File
 import java.util.Collections
+import java.util.concurrent.FutureTask
 
 class QuickJS private constructor(
         val runtimePtr: Long,
-        handlerThread: HandlerThread?
+        eventLoop: EventLoop
 ) : Closeable {
-    val native: EventQueue = EventQueue(this, handlerThread)
+    val native: EventQueue = EventQueue(this, eventLoop)
 
-    val home = File(Environment.getExternalStoragePublicDirectory(Environment.DIRECTORY_DOCUMENTS), "nodejs")
+    // 延迟初始化，避免在非 Android 环境（原生事件循环的 JVM 测试）中访问 Environment
+    val home: File by lazy {
+        File(Environment.getExternalStoragePublicDirectory(Environment.DIRECTORY_DOCUMENTS), "nodejs")
+    }
 
     @Volatile
     var released: Boolean = false
@@ -24,17 +29,39 @@ class QuickJS private constructor(
 
         private var sId = 0
 
-        fun createRuntime(): QuickJS {
-            return QuickJS(QuickJSNativeImpl.createRuntime(), null)
+        /**
+         * arena 为 true 时运行时的小对象从按大小分级的内存池中分配，释放的内存留在池中复用，
+         * 关闭运行时时整体归还系统，适合频繁创建、生命周期短的运行时，统计见 arenaStats
+         */
+        @JvmOverloads
+        fun createRuntime(arena: Boolean = false): QuickJS {
+            return QuickJS(QuickJSNativeImpl.createRuntime(arena), HandlerEventLoop(Handler(Looper.myLooper()!!), null))
+        }
+
+        /**
+         * 创建由原生事件循环驱动的运行时：任务经无锁 MPSC 队列投递到专用原生线程，
+         * 不依赖 Android Looper
+         */
+        @JvmOverloads
+        fun createRuntimeWithNativeEventLoop(arena: Boolean = false): QuickJS {
+            val loopPtr = QuickJSNativeImpl.createEventLoop(arena)
+            val eventLoop = NativeEventLoop(loopPtr)
+            val task = FutureTask { QuickJS(QuickJSNativeImpl.getEventLoopRuntime(loopPtr), eventLoop) }
+            eventLoop.post(task)
+            return task.get()
         }
 
-        fun createRuntimeWithEventQueue(): QuickJS {
+        @JvmOverloads
+        fun createRuntimeWithEventQueue(arena: Boolean = false): QuickJS {
             val lock = Object()
             val objects = arrayOfNulls<Any>(2)
             val handlerThread = HandlerThread("QuickJS-" + (sId++))
             handlerThread.start()
             Handler(handlerThread.looper).post {
-                objects[0] = QuickJS(QuickJSNativeImpl.createRuntime(), handlerThread)
+                objects[0] = QuickJS(
+                    QuickJSNativeImpl.createRuntime(arena),
+                    HandlerEventLoop(Handler(handlerThread.looper), handlerThread)
+                )
                 synchronized(lock) {
                     objects[1] = true
                     lock.notify()
@@ -54,29 +81,15 @@ class QuickJS private constructor(
 
         @Keep
         @JvmStatic
-        fun callJavaCallback(
-            contextPtr: Long,
-            javaCallerId: Int,
-            objectHandle: JSValue,
-            args: Array<Any>,
-        ): Any? {
-            val context = sContextMap[contextPtr] ?: return null
-            val methodDescriptor = context.functionRegistry[javaCallerId] ?: return null
-            val receiver = objectHandle as? JSObject
-            return methodDescriptor.callback?.invoke(receiver, args)
-        }
-
-        @Keep
-        @JvmStatic
-        fun createJSValue(contextPtr: Long, type: Int, tag: Long, uInt32: Int, uFloat64: Double, uPtr: Long): JSValue {
+        fun createJSValue(contextPtr: Long, type: Int, handle: Long): JSValue {
             val context = sContextMap[contextPtr]!!
             return when (type) {
-                JSValue.TYPE_JS_FUNCTION -> JSFunction(context, tag, uInt32, uFloat64, uPtr)
-                JSValue.TYPE_JS_ARRAY -> JSArray(context, tag, uInt32, uFloat64, uPtr)
-                JSValue.TYPE_JS_OBJECT -> JSObject(context, tag, uInt32, uFloat64, uPtr)
-                JSValue.TYPE_JS_EXCEPTION -> JSException(context, tag, uInt32, uFloat64, uPtr)
-                JSValue.TYPE_UNDEFINED -> JSObject.Undefined(context, tag, uInt32, uFloat64, uPtr)
-                else -> JSValue(context, tag, uInt32, uFloat64, uPtr)
+                JSValue.TYPE_JS_FUNCTION -> JSFunction(context, handle)
+                JSValue.TYPE_JS_ARRAY -> JSArray(context, handle)
+                JSValue.TYPE_JS_OBJECT -> JSObject(context, handle)
+                JSValue.TYPE_JS_EXCEPTION -> JSException(context, handle)
+                JSValue.TYPE_UNDEFINED -> JSObject.Undefined(context, handle)
+                else -> JSValue(context, handle)
             }
         }
 
@@ -116,6 +129,34 @@ class QuickJS private constructor(
             )
         }
 
+        @Volatile
+        var bytecodeCacheDir: File? = null
+            private set
+
+        /**
+         * 开启字节码磁盘缓存：executeScript、executeModuleScript 与 ES6 模块加载
+         * 按源码内容哈希复用已编译的字节码，引擎版本变化或文件损坏时自动重新编译
+         */
+        @JvmStatic
+        fun enableBytecodeCache(dir: File) {
+            if (!dir.isDirectory && !dir.mkdirs()) {
+                throw IllegalArgumentException("Cannot create bytecode cache directory: $dir")
+            }
+            bytecodeCacheDir = dir
+            QuickJSNativeImpl.setBytecodeCacheDir(dir.absolutePath)
+        }
+
+        @JvmStatic
+        fun disableBytecodeCache() {
+            bytecodeCacheDir = null
+            QuickJSNativeImpl.setBytecodeCacheDir(null)
+        }
+
+        @JvmStatic
+        fun clearBytecodeCache() {
+            bytecodeCacheDir?.listFiles { file -> file.name.endsWith(".qjbc") }?.forEach { it.delete() }
+        }
+
         fun checkException(context: JSContext) {
             val result = context.native.getException(context.contextPtr) ?: return
             val message = StringBuilder().apply {
@@ -155,6 +196,7 @@ class QuickJS private constructor(
         values.forEach { it.close() }
         native.releaseRuntime(runtimePtr)
         released = true
+        native.eventLoop.close()
     }
 
     fun checkReleased() {
@@ -162,7 +204,144 @@ class QuickJS private constructor(
     }
     fun isReleased(): Boolean = released
 
-    class MethodDescriptor {
-        var callback: JavaCallback? = null
+    /**
+     * 尚未被 JS 回收的 Java 回调数量，JS 函数被回收后对应的回调会自动释放
+     */
+    val callbackCount: Int
+        get() = native.getCallbackCount(runtimePtr)
+
+    /**
+     * 运行时可分配的内存上限（字节），超出时 JS 抛出 out of memory，0 表示不限制
+     */
+    fun setMemoryLimit(limit: Long) {
+        checkReleased()
+        native.setMemoryLimit(runtimePtr, limit)
+    }
+
+    /**
+     * 已分配内存超过 threshold 字节时触发循环引用回收，0 表示只在调用 runGC 时回收
+     */
+    fun setGCThreshold(threshold: Long) {
+        checkReleased()
+        native.setGCThreshold(runtimePtr, threshold)
+    }
+
+    /**
+     * JS 可使用的最大栈深度（字节），0 表示不检查栈溢出
+     */
+    fun setMaxStackSize(stackSize: Long) {
+        checkReleased()
+        native.setMaxStackSize(runtimePtr, stackSize)
+    }
+
+    fun runGC() {
+        checkReleased()
+        native.runGC(runtimePtr)
+    }
+
+    /**
+     * 计算当前的内存统计，需要遍历整个堆，周期性监控使用 MemoryUsageSampler
+     */
+    val memoryUsage: MemoryUsage
+        get() {
+            checkReleased()
+            return MemoryUsage.fromArray(native.getMemoryUsage(runtimePtr))
+        }
+
+    /**
+     * 内存池的分级统计，运行时不是以 arena 模式创建时为 null
+     */
+    val arenaStats: ArenaStats?
+        get() {
+            checkReleased()
+            return native.getArenaStats(runtimePtr)?.let { ArenaStats.fromArray(it) }
+        }
+
+    /**
+     * 属性读写内联缓存的累计命中统计，覆盖该运行时的所有上下文
+     */
+    val inlineCacheStats: InlineCacheStats
+        get() {
+            checkReleased()
+            return InlineCacheStats.fromArray(native.getInlineCacheStats(runtimePtr))
+        }
+
+    fun resetInlineCacheStats() {
+        checkReleased()
+        native.resetInlineCacheStats(runtimePtr)
+    }
+
+    /**
+     * 开启后解释器统计执行的字节码、相邻字节码对以及每个函数的调用、循环次数，从下一次函数调用起生效。
+     * 开启后执行速度约下降一半，只用于分析；关闭后已收集的数据保留到 resetProfile
+     */
+    fun setOpcodeProfiling(enable: Boolean) {
+        checkReleased()
+        native.setOpcodeProfiling(runtimePtr, enable)
+    }
+
+    /**
+     * 按执行次数从多到少排序的剖析报告，每个列表最多 maxEntries 项，0 表示不限制
+     */
+    @JvmOverloads
+    fun getProfile(maxEntries: Int = 50): OpcodeProfile {
+        checkReleased()
+        val result = native.getOpcodeProfile(runtimePtr, maxEntries) ?: return OpcodeProfile.EMPTY
+        @Suppress("UNCHECKED_CAST")
+        return OpcodeProfile.fromArrays(result[0] as Array<String>, result[1] as LongArray)
+    }
+
+    fun resetProfile() {
+        checkReleased()
+        native.resetOpcodeProfile(runtimePtr)
+    }
+
+    /**
+     * 开始 CPU 采样：后台线程每 intervalMicros 微秒请求一次采样，JS 线程在下一次函数调用或循环回跳时记录调用栈，
+     * 不执行 JS 的时间记为 (idle)。开销很小，可以在线上常开；重新开始会丢弃之前的结果
+     */
+    @JvmOverloads
+    fun startCPUProfiler(intervalMicros: Int = 1000) {
+        require(intervalMicros > 0) { "intervalMicros must be positive" }
+        checkReleased()
+        if (!native.startCPUProfiler(runtimePtr, intervalMicros)) {
+            throw IllegalStateException("Cannot start the CPU profiler")
+        }
+    }
+
+    fun stopCPUProfiler() {
+        checkReleased()
+        native.stopCPUProfiler(runtimePtr)
+    }
+
+    /**
+     * Chrome DevTools .cpuprofile 格式的采样结果，可保存为文件后在 DevTools 的 Performance 面板打开；
+     * 采样进行中时返回截至目前的结果，从未开始过采样时返回 null
+     */
+    val cpuProfile: String?
+        get() {
+            checkReleased()
+            return native.getCPUProfile(runtimePtr)
+        }
+
+    /**
+     * 设置运行时默认的执行预算：每次从 Java 进入 JS 的最外层调用（执行脚本、调用函数、执行 Promise 任务）
+     * 最多运行 timeoutMillis 毫秒、instructionBudget 个计数，超出时抛出 QuickJSTimeoutException，0 表示不限制。
+     * 计数在循环回跳和函数调用时累加，每 10000 个检查一次，因此预算按 10000 向上取整生效
+     */
+    @JvmOverloads
+    fun setExecutionLimits(timeoutMillis: Long, instructionBudget: Long = 0) {
+        checkReleased()
+        native.setExecutionLimits(runtimePtr, timeoutMillis, instructionBudget)
+    }
+
+    /**
+     * 以单独的执行预算运行 block 中的全部 JS 调用，代替运行时默认预算；
+     * 在另一段预算内嵌套调用时只会收紧外层的限制
+     */
+    @JvmOverloads
+    fun <T> withExecutionLimits(timeoutMillis: Long, instructionBudget: Long = 0, block: () -> T): T? {
+        checkReleased()
+        return native.withExecutionBudget(timeoutMillis, instructionBudget, block)
     }
 }
\ No newline at end of file
@@ -1,6 +1,6 @@
 package com.quickjs
 
-class QuickJSException: RuntimeException {
+open class QuickJSException: RuntimeException {
     private var name: String? = null
 
     constructor(name: String, message: String): super("$name,$message") {
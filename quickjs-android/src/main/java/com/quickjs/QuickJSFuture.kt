@@ -0,0 +1,52 @@
+package com.quickjs
+
+import java.util.concurrent.Callable
+import java.util.concurrent.CancellationException
+import java.util.concurrent.ExecutionException
+import java.util.concurrent.FutureTask
+
+/**
+ * 事件队列异步任务的结果。minSdk 21 无法使用 CompletableFuture，
+ * 因此基于 FutureTask 实现，并支持完成回调，回调在 JS 线程执行（已完成时在调用线程执行）
+ */
+class QuickJSFuture<T> internal constructor(callable: Callable<T>) : FutureTask<T>(callable) {
+    private val listeners = ArrayList<(T?, Throwable?) -> Unit>()
+
+    /**
+     * 注册完成回调，成功时 error 为 null，失败或取消时 result 为 null
+     */
+    fun whenComplete(listener: (result: T?, error: Throwable?) -> Unit): QuickJSFuture<T> {
+        synchronized(listeners) {
+            if (!isDone) {
+                listeners.add(listener)
+                return this
+            }
+        }
+        notify(listener)
+        return this
+    }
+
+    override fun done() {
+        val pending = synchronized(listeners) {
+            listeners.toTypedArray().also { listeners.clear() }
+        }
+        pending.forEach { notify(it) }
+    }
+
+    private fun notify(listener: (T?, Throwable?) -> Unit) {
+        val result = try {
+            get()
+        } catch (e: ExecutionException) {
+            listener(null, e.cause ?: e)
+            return
+        } catch (e: CancellationException) {
+            listener(null, e)
+            return
+        }
+        listener(result, null)
+    }
+
+    internal fun fail(error: Throwable) {
+        setException(error)
+    }
+}
@@ -0,0 +1,31 @@
+package com.quickjs
+
+import android.util.Log
+
+/**
+ * 库内部日志：Android 上写入 logcat，普通 JVM 上（原生事件循环）写到标准错误。
+ * android.util.Log 只在 Android 上才会被解析，JVM 上不会加载到未实现的 stub
+ */
+internal object QuickJSLog {
+    private const val TAG = "QuickJS"
+
+    // ART 与 Dalvik 的 java.vm.name 都是 "Dalvik"
+    private val android = System.getProperty("java.vm.name") == "Dalvik"
+
+    fun w(message: String) {
+        if (android) {
+            Log.w(TAG, message)
+        } else {
+            System.err.println("W/$TAG: $message")
+        }
+    }
+
+    fun e(message: String, error: Throwable? = null) {
+        if (android) {
+            Log.e(TAG, message, error)
+        } else {
+            System.err.println("E/$TAG: $message")
+            error?.printStackTrace()
+        }
+    }
+}
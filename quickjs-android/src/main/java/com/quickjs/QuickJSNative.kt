@@ -1,5 +1,7 @@
 package com.quickjs
 
+import java.nio.ByteBuffer
+
 interface QuickJSNative {
     fun releaseRuntime(runtimePtr: Long)
 
@@ -15,12 +17,40 @@ interface QuickJSNative {
             evalFlags: Int
     ): Any?
 
+    fun compileScript(contextPtr: Long, source: String, fileName: String, evalFlags: Int): ByteArray
+
+    fun executeBytecode(contextPtr: Long, expectedType: Int, bytecode: ByteArray): Any?
+
     fun getGlobalObject(contextPtr: Long): JSObject
 
     fun set(contextPtr: Long, objectHandle: JSValue, key: String, value: Any?)
 
     fun get(contextPtr: Long, expectedType: Int, objectHandle: JSValue, key: String): Any?
 
+    fun getMany(contextPtr: Long, objectHandle: JSValue, keys: Array<String>): Array<Any?>
+
+    fun setMany(contextPtr: Long, objectHandle: JSValue, keys: Array<String>, values: Array<out Any?>)
+
+    fun getManyAtoms(contextPtr: Long, objectHandle: JSValue, atoms: IntArray): Array<Any?>
+
+    fun newAtom(contextPtr: Long, key: String): Int
+
+    fun freeAtom(contextPtr: Long, atom: Int)
+
+    fun getAtom(contextPtr: Long, expectedType: Int, objectHandle: JSValue, atom: Int): Any?
+
+    fun setAtom(contextPtr: Long, objectHandle: JSValue, atom: Int, value: Any?)
+
+    fun containsAtom(contextPtr: Long, objectHandle: JSValue, atom: Int): Boolean
+
+    fun executeFunctionAtom(
+        contextPtr: Long,
+        expectedType: Int,
+        objectHandle: JSValue,
+        atom: Int,
+        parametersHandle: Array<out Any?>
+    ): Any?
+
     fun arrayGet(contextPtr: Long, expectedType: Int, objectHandle: JSValue, index: Int): Any?
 
     fun arrayAdd(contextPtr: Long, objectHandle: JSValue, value: Any?)
@@ -41,25 +71,110 @@ interface QuickJSNative {
         parametersHandle: Array<out Any?>
     ): Any?
 
+    /**
+     * 类型化调用，参数与返回值不装箱；thisHandle 为 0 表示 undefined，JS 异常直接抛出 QuickJSException
+     */
+    fun callII(contextPtr: Long, thisHandle: Long, functionHandle: Long, a: Int, b: Int): Int
+
+    fun callDD(contextPtr: Long, thisHandle: Long, functionHandle: Long, a: Double, b: Double): Double
+
+    fun callLL(contextPtr: Long, thisHandle: Long, functionHandle: Long, a: Long, b: Long): Long
+
+    fun callVoid(contextPtr: Long, thisHandle: Long, functionHandle: Long)
+
+    fun callDoubles(contextPtr: Long, thisHandle: Long, functionHandle: Long, args: DoubleArray): Double
+
     fun initNewJSObject(contextPtr: Long): JSObject
 
     fun initNewJSArray(contextPtr: Long): JSArray
 
-    fun initNewJSFunction(contextPtr: Long, javaCallerId: Int): JSFunction
+    fun initNewJSFunction(contextPtr: Long, callback: JavaCallback): JSFunction
 
-    fun releasePtr(
-            contextPtr: Long,
-            tag: Long,
-            uInt32: Int,
-            uFloat64: Double,
-            uPtr: Long
-    )
+    fun releasePtr(contextPtr: Long, handle: Long)
+
+    fun getHandleCount(contextPtr: Long): Int
+
+    fun dumpLeaks(contextPtr: Long): Array<String>
 
     fun registerJavaMethod(
             contextPtr: Long,
             objectHandle: JSValue,
             jsFunctionName: String,
-            javaCallerId: Int,
+            callback: JavaCallback,
+    ): JSFunction
+
+    /**
+     * 运行时中尚未被 JS 回收的 Java 回调数量
+     */
+    fun getCallbackCount(runtimePtr: Long): Int
+
+    /**
+     * 运行时默认执行预算，每次从 Java 进入 JS 的最外层调用生效，0 表示不限制
+     */
+    fun setExecutionLimits(runtimePtr: Long, timeoutMillis: Long, instructionBudget: Long)
+
+    fun setMemoryLimit(runtimePtr: Long, limit: Long)
+
+    fun setGCThreshold(runtimePtr: Long, threshold: Long)
+
+    fun setMaxStackSize(runtimePtr: Long, stackSize: Long)
+
+    fun runGC(runtimePtr: Long)
+
+    /**
+     * 按 JSMemoryUsage 的字段顺序返回内存统计，见 MemoryUsage.fromArray
+     */
+    fun getMemoryUsage(runtimePtr: Long): LongArray
+
+    /**
+     * 内存池模式下各大小级别的统计，见 ArenaStats.fromArray；普通运行时返回 null
+     */
+    fun getArenaStats(runtimePtr: Long): LongArray?
+
+    /**
+     * 按 JSInlineCacheStats 的字段顺序返回属性访问内联缓存的命中统计，见 InlineCacheStats.fromArray
+     */
+    fun getInlineCacheStats(runtimePtr: Long): LongArray
+
+    fun resetInlineCacheStats(runtimePtr: Long)
+
+    fun setOpcodeProfiling(runtimePtr: Long, enable: Boolean)
+
+    fun resetOpcodeProfile(runtimePtr: Long)
+
+    /**
+     * 返回 {名称数组, 数值数组}，见 OpcodeProfile.fromArrays；从未开启过剖析时返回 null
+     */
+    fun getOpcodeProfile(runtimePtr: Long, maxEntries: Int): Array<Any>?
+
+    /**
+     * 开始 CPU 采样并启动采样线程，丢弃之前的结果；内存不足时返回 false
+     */
+    fun startCPUProfiler(runtimePtr: Long, intervalMicros: Int): Boolean
+
+    fun stopCPUProfiler(runtimePtr: Long)
+
+    /**
+     * Chrome DevTools .cpuprofile 格式的 JSON，从未开始过采样时返回 null
+     */
+    fun getCPUProfile(runtimePtr: Long): String?
+
+    /**
+     * 开始一段单独设置预算的调用，必须在 JS 线程上与 endExecutionBudget 成对调用
+     */
+    fun beginExecutionBudget(runtimePtr: Long, timeoutMillis: Long, instructionBudget: Long)
+
+    fun endExecutionBudget(runtimePtr: Long)
+
+    /**
+     * 注册基本类型签名的回调，kind 取 TYPED_CALLBACK_XXX，callback 为对应的回调接口实例
+     */
+    fun registerTypedJavaMethod(
+            contextPtr: Long,
+            objectHandle: JSValue,
+            jsFunctionName: String,
+            kind: Int,
+            callback: Any,
     ): JSFunction
 
     fun getObjectType(contextPtr: Long, objectHandle: JSValue): Int
@@ -78,7 +193,7 @@ interface QuickJSNative {
 
     fun getException(contextPtr: Long): Array<String>?
 
-    fun newClass(contextPtr: Long, javaCallerId: Int): JSFunction
+    fun newClass(contextPtr: Long, callback: JavaCallback): JSFunction
 
     fun toJSString(contextPtr: Long, value: JSValue): String?
 
@@ -89,4 +204,41 @@ interface QuickJSNative {
     fun newError(contextPtr: Long, message: String): JSObject
 
     fun isError(contextPtr: Long, value: JSValue): Boolean
+
+    fun newArrayBuffer(contextPtr: Long, buffer: ByteBuffer): JSObject
+
+    fun newTypedArray(contextPtr: Long, type: Int, buffer: ByteBuffer): JSObject
+
+    fun getArrayBuffer(contextPtr: Long, objectHandle: JSValue): ByteBuffer?
+
+    /**
+     * 在一次调用中把整个 JS 对象图转换为 HashMap/ArrayList/基本类型数组
+     */
+    fun toJava(contextPtr: Long, objectHandle: JSValue, depthLimit: Int): Any?
+
+    /**
+     * 在一次调用中把 Map/Collection/数组构成的 Java 对象图转换为 JS 值
+     */
+    fun fromJava(contextPtr: Long, value: Any?, depthLimit: Int): Any?
+
+    fun parseJSON(contextPtr: Long, json: String): Any?
+
+    /**
+     * 直接解析 UTF-8 字节，不经过 Java String
+     */
+    fun parseJSONBytes(contextPtr: Long, bytes: ByteArray, offset: Int, length: Int): Any?
+
+    /**
+     * 解析 direct ByteBuffer 中 [offset, offset + length) 的 UTF-8 字节，数据后紧跟 0 时原地解析
+     */
+    fun parseJSONBuffer(contextPtr: Long, buffer: ByteBuffer, offset: Int, length: Int): Any?
+
+    fun stringify(contextPtr: Long, objectHandle: JSValue, indent: Int): String?
+
+    fun stringifyToBytes(contextPtr: Long, objectHandle: JSValue, indent: Int): ByteArray?
+
+    /**
+     * 序列化为 UTF-8 写入 reuse，容量不足时分配新的 direct ByteBuffer 返回
+     */
+    fun stringifyToBuffer(contextPtr: Long, objectHandle: JSValue, indent: Int, reuse: ByteBuffer?): ByteBuffer?
 }
\ No newline at end of file
@@ -1,12 +1,39 @@
 package com.quickjs
 
+import java.nio.ByteBuffer
+
 class QuickJSNativeImpl : QuickJSNative {
 
 
 
     companion object {
+        // arena 为 true 时运行时使用分级内存池分配，见 QuickJS.createRuntime
+        @JvmStatic
+        external fun createRuntime(arena: Boolean): Long
+
+        // 创建原生事件循环，JSRuntime 在循环线程上创建
+        @JvmStatic
+        external fun createEventLoop(arena: Boolean): Long
+
+        @JvmStatic
+        external fun getEventLoopRuntime(loopPtr: Long): Long
+
+        @JvmStatic
+        external fun eventLoopPost(loopPtr: Long, task: Runnable, delayMillis: Long): Boolean
+
+        @JvmStatic
+        external fun eventLoopRemove(loopPtr: Long, task: Runnable)
+
+        @JvmStatic
+        external fun eventLoopQuit(loopPtr: Long)
+
+        // 回收原生事件循环，之后不能再使用 loopPtr
         @JvmStatic
-        external fun createRuntime(): Long
+        external fun eventLoopRelease(loopPtr: Long)
+
+        // 字节码缓存目录，null 表示关闭缓存
+        @JvmStatic
+        external fun setBytecodeCacheDir(path: String?)
     }
 
     external override fun releaseRuntime(runtimePtr: Long)
@@ -23,8 +50,38 @@ class QuickJSNativeImpl : QuickJSNative {
         evalFlags: Int
     ): Any?
 
+    external override fun compileScript(
+        contextPtr: Long,
+        source: String,
+        fileName: String,
+        evalFlags: Int
+    ): ByteArray
+
+    external override fun executeBytecode(contextPtr: Long, expectedType: Int, bytecode: ByteArray): Any?
+
     external override fun getGlobalObject(contextPtr: Long): JSObject
 
+    external override fun callII(contextPtr: Long, thisHandle: Long, functionHandle: Long, a: Int, b: Int): Int
+
+    external override fun callDD(
+        contextPtr: Long,
+        thisHandle: Long,
+        functionHandle: Long,
+        a: Double,
+        b: Double
+    ): Double
+
+    external override fun callLL(contextPtr: Long, thisHandle: Long, functionHandle: Long, a: Long, b: Long): Long
+
+    external override fun callVoid(contextPtr: Long, thisHandle: Long, functionHandle: Long)
+
+    external override fun callDoubles(
+        contextPtr: Long,
+        thisHandle: Long,
+        functionHandle: Long,
+        args: DoubleArray
+    ): Double
+
     external override fun set(
         contextPtr: Long,
         objectHandle: JSValue,
@@ -39,6 +96,57 @@ class QuickJSNativeImpl : QuickJSNative {
         key: String
     ): Any?
 
+    external override fun getMany(
+        contextPtr: Long,
+        objectHandle: JSValue,
+        keys: Array<String>
+    ): Array<Any?>
+
+    external override fun setMany(
+        contextPtr: Long,
+        objectHandle: JSValue,
+        keys: Array<String>,
+        values: Array<out Any?>
+    )
+
+    external override fun getManyAtoms(
+        contextPtr: Long,
+        objectHandle: JSValue,
+        atoms: IntArray
+    ): Array<Any?>
+
+    external override fun newAtom(contextPtr: Long, key: String): Int
+
+    external override fun freeAtom(contextPtr: Long, atom: Int)
+
+    external override fun getAtom(
+        contextPtr: Long,
+        expectedType: Int,
+        objectHandle: JSValue,
+        atom: Int
+    ): Any?
+
+    external override fun setAtom(
+        contextPtr: Long,
+        objectHandle: JSValue,
+        atom: Int,
+        value: Any?
+    )
+
+    external override fun containsAtom(
+        contextPtr: Long,
+        objectHandle: JSValue,
+        atom: Int
+    ): Boolean
+
+    external override fun executeFunctionAtom(
+        contextPtr: Long,
+        expectedType: Int,
+        objectHandle: JSValue,
+        atom: Int,
+        parametersHandle: Array<out Any?>
+    ): Any?
+
     external override fun arrayGet(
         contextPtr: Long,
         expectedType: Int,
@@ -74,22 +182,64 @@ class QuickJSNativeImpl : QuickJSNative {
 
     external override fun initNewJSFunction(
         contextPtr: Long,
-        javaCallerId: Int
+        callback: JavaCallback
     ): JSFunction
 
-    external override fun releasePtr(
-        contextPtr: Long,
-        tag: Long,
-        uInt32: Int,
-        uFloat64: Double,
-        uPtr: Long
-    )
+    external override fun releasePtr(contextPtr: Long, handle: Long)
+
+    external override fun getHandleCount(contextPtr: Long): Int
+
+    external override fun dumpLeaks(contextPtr: Long): Array<String>
 
     external override fun registerJavaMethod(
         contextPtr: Long,
         objectHandle: JSValue,
         jsFunctionName: String,
-        javaCallerId: Int,
+        callback: JavaCallback,
+    ): JSFunction
+
+    external override fun getCallbackCount(runtimePtr: Long): Int
+
+    external override fun setExecutionLimits(runtimePtr: Long, timeoutMillis: Long, instructionBudget: Long)
+
+    external override fun setMemoryLimit(runtimePtr: Long, limit: Long)
+
+    external override fun setGCThreshold(runtimePtr: Long, threshold: Long)
+
+    external override fun setMaxStackSize(runtimePtr: Long, stackSize: Long)
+
+    external override fun runGC(runtimePtr: Long)
+
+    external override fun getMemoryUsage(runtimePtr: Long): LongArray
+
+    external override fun getArenaStats(runtimePtr: Long): LongArray?
+
+    external override fun getInlineCacheStats(runtimePtr: Long): LongArray
+
+    external override fun resetInlineCacheStats(runtimePtr: Long)
+
+    external override fun setOpcodeProfiling(runtimePtr: Long, enable: Boolean)
+
+    external override fun resetOpcodeProfile(runtimePtr: Long)
+
+    external override fun getOpcodeProfile(runtimePtr: Long, maxEntries: Int): Array<Any>?
+
+    external override fun startCPUProfiler(runtimePtr: Long, intervalMicros: Int): Boolean
+
+    external override fun stopCPUProfiler(runtimePtr: Long)
+
+    external override fun getCPUProfile(runtimePtr: Long): String?
+
+    external override fun beginExecutionBudget(runtimePtr: Long, timeoutMillis: Long, instructionBudget: Long)
+
+    external override fun endExecutionBudget(runtimePtr: Long)
+
+    external override fun registerTypedJavaMethod(
+        contextPtr: Long,
+        objectHandle: JSValue,
+        jsFunctionName: String,
+        kind: Int,
+        callback: Any,
     ): JSFunction
 
     external override fun getObjectType(
@@ -131,7 +281,7 @@ class QuickJSNativeImpl : QuickJSNative {
 
     external override fun newClass(
         contextPtr: Long,
-        javaCallerId: Int
+        callback: JavaCallback
     ): JSFunction
 
     external override fun toJSString(contextPtr: Long, value: JSValue): String?
@@ -145,4 +295,33 @@ class QuickJSNativeImpl : QuickJSNative {
     external override fun newError(contextPtr: Long, message: String): JSObject
 
     external override fun isError(contextPtr: Long, value: JSValue): Boolean
+
+    // 零拷贝：ArrayBuffer 直接引用 direct ByteBuffer 的内存
+    external override fun newArrayBuffer(contextPtr: Long, buffer: ByteBuffer): JSObject
+
+    external override fun newTypedArray(contextPtr: Long, type: Int, buffer: ByteBuffer): JSObject
+
+    // 零拷贝：返回的 ByteBuffer 直接引用 ArrayBuffer/TypedArray 的内存
+    external override fun getArrayBuffer(contextPtr: Long, objectHandle: JSValue): ByteBuffer?
+
+    external override fun toJava(contextPtr: Long, objectHandle: JSValue, depthLimit: Int): Any?
+
+    external override fun fromJava(contextPtr: Long, value: Any?, depthLimit: Int): Any?
+
+    external override fun parseJSON(contextPtr: Long, json: String): Any?
+
+    external override fun parseJSONBytes(contextPtr: Long, bytes: ByteArray, offset: Int, length: Int): Any?
+
+    external override fun parseJSONBuffer(contextPtr: Long, buffer: ByteBuffer, offset: Int, length: Int): Any?
+
+    external override fun stringify(contextPtr: Long, objectHandle: JSValue, indent: Int): String?
+
+    external override fun stringifyToBytes(contextPtr: Long, objectHandle: JSValue, indent: Int): ByteArray?
+
+    external override fun stringifyToBuffer(
+        contextPtr: Long,
+        objectHandle: JSValue,
+        indent: Int,
+        reuse: ByteBuffer?
+    ): ByteBuffer?
 }
@@ -0,0 +1,220 @@
+package com.quickjs
+
+import java.io.Closeable
+import java.util.concurrent.Callable
+import java.util.concurrent.LinkedBlockingDeque
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * 多运行时池：预先创建 size 个 JSRuntime/JSContext，每个运行在各自的 JS 线程上，
+ * 插件与预加载脚本在每个上下文中执行一次，预加载脚本只编译一次，各上下文执行同一份字节码。
+ *
+ * 任务按轮询投递到各工作者的双端队列，工作者在自己的 JS 线程上从队头取任务，
+ * 自己的队列为空时从其他工作者的队尾窃取。
+ * 任务返回的 JSValue 属于执行它的上下文，只能在该任务内使用。
+ * arena 为 true 时各运行时使用内存池分配，见 QuickJS.createRuntime。
+ */
+class QuickJSPool @JvmOverloads constructor(
+    size: Int,
+    private val preloadScripts: Map<String, String> = emptyMap(),
+    useNativeEventLoop: Boolean = false,
+    arena: Boolean = false,
+    private val setup: (JSContext) -> Unit = {}
+) : Closeable {
+    private val workers: Array<Worker>
+    private val nextWorker = AtomicInteger()
+    private val createdAt = System.nanoTime()
+
+    @Volatile
+    private var closed = false
+
+    init {
+        require(size > 0) { "Pool size must be positive" }
+        val runtimes = ArrayList<QuickJS>(size)
+        workers = try {
+            repeat(size) {
+                runtimes.add(
+                    if (useNativeEventLoop) {
+                        QuickJS.createRuntimeWithNativeEventLoop(arena)
+                    } else {
+                        QuickJS.createRuntimeWithEventQueue(arena)
+                    }
+                )
+            }
+            val bytecodes = compilePreload(runtimes[0])
+            Array(size) { index -> Worker(index, runtimes[index], bytecodes) }
+        } catch (e: Throwable) {
+            // 构造失败时不会返回池对象，已创建的运行时只能在这里释放
+            runtimes.forEach { it.close() }
+            throw e
+        }
+    }
+
+    private fun compilePreload(quickJS: QuickJS): List<ByteArray> {
+        if (preloadScripts.isEmpty()) return emptyList()
+        val compiler = quickJS.createContext()
+        try {
+            return preloadScripts.map { (fileName, source) -> compiler.compileScript(source, fileName) }
+        } finally {
+            compiler.close()
+        }
+    }
+
+    val size: Int get() = workers.size
+
+    /**
+     * 所有工作者队列中尚未开始执行的任务总数
+     */
+    val queueDepth: Int get() = workers.sumOf { it.deque.size }
+
+    /**
+     * 在某个空闲的上下文上执行任务
+     */
+    fun <T> submit(task: (JSContext) -> T): QuickJSFuture<T> {
+        val worker = workers[Math.floorMod(nextWorker.getAndIncrement(), workers.size)]
+        val future = QuickJSFuture(Callable { current.get()!!.runTask(task) })
+        if (closed) {
+            future.fail(IllegalStateException("QuickJSPool is closed"))
+            return future
+        }
+        worker.deque.offerLast(future)
+        // close 可能在检查之后清空了队列；仍在队列中说明没有被取走，由这里让它失败
+        if (closed && worker.deque.remove(future)) {
+            future.fail(IllegalStateException("QuickJSPool is closed"))
+            return future
+        }
+        // 目标工作者可能正忙，唤醒一个空闲工作者来窃取
+        if (!worker.schedule()) {
+            workers.firstOrNull { it.schedule() }
+        }
+        return future
+    }
+
+    fun executeScript(source: String, fileName: String): QuickJSFuture<Any?> =
+        submit { it.executeScript(source, fileName) }
+
+    fun executeFunction(name: String, vararg parameters: Any): QuickJSFuture<Any?> =
+        submit { it.global.executeFunction(name, *parameters) }
+
+    fun metrics(): List<WorkerMetrics> {
+        val elapsed = System.nanoTime() - createdAt
+        return workers.map { it.metrics(elapsed) }
+    }
+
+    override fun close() {
+        if (closed) return
+        closed = true
+        workers.forEach { worker ->
+            while (true) {
+                val pending = worker.deque.pollFirst() ?: break
+                (pending as QuickJSFuture<*>).fail(IllegalStateException("QuickJSPool is closed"))
+            }
+            // QuickJS.close 会一并释放该运行时的上下文
+            worker.quickJS.close()
+        }
+    }
+
+    /**
+     * 单个工作者的统计信息，utilization 为自池创建以来执行任务的时间占比
+     */
+    data class WorkerMetrics(
+        val index: Int,
+        val queued: Int,
+        val completed: Long,
+        val stolen: Long,
+        val busyNanos: Long,
+        val utilization: Double
+    )
+
+    private inner class Worker(val index: Int, val quickJS: QuickJS, bytecodes: List<ByteArray>) {
+        val deque = LinkedBlockingDeque<Runnable>()
+        val context: JSContext
+        private val scheduled = AtomicBoolean(false)
+        private val completed = AtomicLong()
+        private val stolen = AtomicLong()
+        private val busyNanos = AtomicLong()
+        private val drain = Runnable { drain() }
+
+        init {
+            context = quickJS.createContext()
+            quickJS.native.postVoid {
+                setup(context)
+                bytecodes.forEach { context.executeBytecode(it) }
+            }
+        }
+
+        /**
+         * 在 future 完成之前计入统计，调用方拿到结果时 metrics 已经包含该任务
+         */
+        fun <T> runTask(task: (JSContext) -> T): T {
+            val start = System.nanoTime()
+            try {
+                return task(context)
+            } finally {
+                busyNanos.addAndGet(System.nanoTime() - start)
+                completed.incrementAndGet()
+            }
+        }
+
+        /**
+         * 工作者空闲时向其 JS 线程投递一次 drain，返回是否由本次调用完成投递
+         */
+        fun schedule(): Boolean {
+            if (closed || !scheduled.compareAndSet(false, true)) return false
+            if (!quickJS.native.eventLoop.post(drain)) {
+                scheduled.set(false)
+                return false
+            }
+            return true
+        }
+
+        private fun drain() {
+            current.set(this)
+            try {
+                while (true) {
+                    while (!closed) {
+                        val task = next() ?: break
+                        task.run()
+                    }
+                    scheduled.set(false)
+                    // 置为空闲后再次检查，避免与 submit 竞争丢失唤醒
+                    if (closed || !hasPendingWork() || !scheduled.compareAndSet(false, true)) break
+                }
+            } finally {
+                current.remove()
+            }
+        }
+
+        private fun next(): Runnable? {
+            deque.pollFirst()?.let { return it }
+            for (i in 1 until workers.size) {
+                val victim = workers[(index + i) % workers.size]
+                victim.deque.pollLast()?.let {
+                    stolen.incrementAndGet()
+                    return it
+                }
+            }
+            return null
+        }
+
+        private fun hasPendingWork(): Boolean = workers.any { it.deque.isNotEmpty() }
+
+        fun metrics(elapsed: Long): WorkerMetrics {
+            val busy = busyNanos.get()
+            return WorkerMetrics(
+                index,
+                deque.size,
+                completed.get(),
+                stolen.get(),
+                busy,
+                if (elapsed > 0) busy.toDouble() / elapsed else 0.0
+            )
+        }
+    }
+
+    private companion object {
+        val current = ThreadLocal<Worker>()
+    }
+}
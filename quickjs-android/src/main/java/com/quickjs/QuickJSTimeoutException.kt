@@ -0,0 +1,6 @@
+package com.quickjs
+
+/**
+ * 执行超过运行时或单次调用的时间、指令预算时抛出，JS 中的 try/catch 无法捕获该中断
+ */
+class QuickJSTimeoutException(message: String) : QuickJSException("TimeoutError", message)
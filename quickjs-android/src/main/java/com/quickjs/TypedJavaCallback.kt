@@ -0,0 +1,34 @@
+package com.quickjs
+
+import androidx.annotation.Keep
+
+/*
+ * 基本类型签名的 Java 回调，原生层通过缓存的 jmethodID 直接调用 invoke，
+ * 不分配参数数组、不装箱，也不经过回调注册表。
+ * 参数按 JS 的 ToNumber / ToInt32 / ToString 转换，缺省参数视为 undefined。
+ */
+
+@Keep
+fun interface DoubleUnaryCallback {
+    fun invoke(a: Double): Double
+}
+
+@Keep
+fun interface DoubleBinaryCallback {
+    fun invoke(a: Double, b: Double): Double
+}
+
+@Keep
+fun interface IntBinaryCallback {
+    fun invoke(a: Int, b: Int): Int
+}
+
+@Keep
+fun interface StringCallback {
+    fun invoke(value: String)
+}
+
+internal const val TYPED_CALLBACK_DOUBLE_UNARY = 0
+internal const val TYPED_CALLBACK_DOUBLE_BINARY = 1
+internal const val TYPED_CALLBACK_INT_BINARY = 2
+internal const val TYPED_CALLBACK_STRING = 3
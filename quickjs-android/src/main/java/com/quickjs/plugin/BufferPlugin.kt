@@ -41,8 +41,10 @@ class BufferPlugin : Plugin() {
                     arr
                 }
                 is JSObject -> {
-                    // 支持传入 Array/TypedArray
-                    input.asArrayOrNull()?.map { (it as Number).toByte() }?.toByteArray()
+                    // ArrayBuffer/TypedArray 直接读取底层内存，一次批量复制
+                    input.toByteBuffer()?.let { buffer -> ByteArray(buffer.remaining()).also { buffer.get(it) } }
+                        // 支持传入类数组对象
+                        ?: input.asArrayOrNull()?.map { (it as Number).toByte() }?.toByteArray()
                         ?: ByteArray(0)
                 }
                 else -> ByteArray(0)
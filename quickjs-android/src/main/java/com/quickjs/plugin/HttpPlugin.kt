@@ -22,6 +22,16 @@ class HttpPlugin: Plugin() {
     override fun close(context: JSContext) {
     }
 
+    /**
+     * 一次 toJava() 把 headers 对象整体转成 Map，值为 null/undefined 的字段忽略
+     */
+    private fun toHeaders(headersObj: JSObject): Map<String, String> {
+        val map = headersObj.toJava() as? Map<*, *> ?: return emptyMap()
+        return map.entries
+            .filter { it.key != null && it.value != null }
+            .associate { it.key.toString() to it.value.toString() }
+    }
+
     fun get(context: JSContext): JSFunction {
         return JSFunction(context, { _, args ->
             val url = args[0] as? String ?: throw NullPointerException("url is null")
@@ -35,16 +45,11 @@ class HttpPlugin: Plugin() {
                     callback = args[1] as JSFunction
                 } else if (args[1] is JSObject) {
                     // 第二个参数是 headers 对象
-                    val headersObj = args[1] as JSObject
-                    headers = headersObj.getKeys().associateWith { headersObj.get(it)!!.toString() }
+                    headers = toHeaders(args[1] as JSObject)
                 }
             } else if (args.size >= 3) {
                 val headersObj = args[1]
-                headers = if (headersObj is JSObject) {
-                    headersObj.getKeys().associateWith { headersObj.get(headersObj.getKeys().toString())!!.toString() }
-                } else {
-                    null
-                }
+                headers = if (headersObj is JSObject) toHeaders(headersObj) else null
                 callback = args[2] as JSFunction
             }
 
@@ -89,16 +94,11 @@ class HttpPlugin: Plugin() {
                 if (args[2] is JSFunction) {
                     callback = args[2] as JSFunction
                 } else if (args[2] is JSObject) {
-                    val headersObj = args[2] as JSObject
-                    headers = headersObj.getKeys().associateWith { headersObj.get(it)!!.toString() }
+                    headers = toHeaders(args[2] as JSObject)
                 }
             } else if (args.size >= 4) {
                 val headersObj = args[2]
-                headers = if (headersObj is JSObject) {
-                    headersObj.getKeys().associateWith { headersObj.get(it)!!.toString() }
-                } else {
-                    null
-                }
+                headers = if (headersObj is JSObject) toHeaders(headersObj) else null
                 callback = args[3] as JSFunction
             }
 
@@ -139,17 +139,17 @@ class HttpPlugin: Plugin() {
         callback: JSFunction?,
         block: () -> Any
     ): Any? {
-        val handler = ctx.quickJS.native.handler
+        val eventLoop = ctx.quickJS.native.eventLoop
         return if (callback != null) {
             Thread {
                 try {
                     val result = block()
-                    handler.post {
+                    eventLoop.post {
                         callback.call(null, result)
                     }
                 } catch (e: Exception) {
                     e.printStackTrace()
-                    handler.post {
+                    eventLoop.post {
                         callback.call(null, JSObject(ctx).apply {
                             set("code" , -1)
                             set("message", e.message ?: "")
@@ -165,10 +165,10 @@ class HttpPlugin: Plugin() {
                 Thread {
                     try {
                         val result = block()
-                        handler.post { resolve.call(null, result) }
+                        eventLoop.post { resolve.call(null, result) }
                     } catch (e: Exception) {
                         e.printStackTrace()
-                        handler.post {
+                        eventLoop.post {
                             reject.call(null, JSArray(ctx).apply {
                                 JSObject(ctx).apply {
                                     set("code" , -1)
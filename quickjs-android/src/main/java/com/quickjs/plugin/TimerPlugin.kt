@@ -52,7 +52,7 @@ class TimerPlugin : Plugin() {
                 }
                 val key = getTimeoutListIsNullOfIndex()
                 timeoutList.put(key, delayer)
-                context.quickJS.native.handler.postDelayed(delayer, delay as Long)
+                context.quickJS.native.eventLoop.postDelayed(delayer, delay as Long)
                 return@registerJavaMethod key
             }
             return@registerJavaMethod null
@@ -73,7 +73,7 @@ class TimerPlugin : Plugin() {
             if (args.isEmpty()) return@registerJavaMethod null
             val id = args[0] as? Long ?: return@registerJavaMethod null
             intervalList[id.toInt()]?.let {
-                context.quickJS.native.handler.removeCallbacks(it)
+                context.quickJS.native.eventLoop.removeCallbacks(it)
             }
 //            intervalList[id.toInt()] = null
         }
@@ -83,7 +83,7 @@ class TimerPlugin : Plugin() {
         context.registerJavaMethod( "clearTimeout") { receiver, args ->
             if (args.isEmpty()) return@registerJavaMethod null
             val id = args[0] as? Int ?: return@registerJavaMethod null
-            timeoutList[id]?.let { context.quickJS.native.handler.removeCallbacks(it) }
+            timeoutList[id]?.let { context.quickJS.native.eventLoop.removeCallbacks(it) }
 //            timeoutList[id] = null
         }
     }
@@ -97,12 +97,12 @@ class TimerPlugin : Plugin() {
             val task = object : Runnable {
                 override fun run() {
                     callback.call(null)
-                    context.quickJS.native.handler.postDelayed(this, delay)
+                    context.quickJS.native.eventLoop.postDelayed(this, delay)
                 }
             }
             val key = getIntervalListIsNullOfIndex()
             intervalList.put(key, task)
-            context.quickJS.native.handler.postDelayed(task, delay)
+            context.quickJS.native.eventLoop.postDelayed(task, delay)
             return@registerJavaMethod key
         })
     }